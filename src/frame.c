@@ -6,6 +6,96 @@
 #include "util.h"
 #include <stdlib.h>
 #include <string.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// ---- Aging kernels: ages[i] = ages[i] >> 1 | bit i of ref << 31, 64 frames per word ----
+
+typedef void (*FrameAgeFn)(uint32_t *ages, const uint64_t *ref, uint32_t words);
+
+static void frame_age_scalar(uint32_t *ages, const uint64_t *ref, uint32_t words)
+{
+    for (uint32_t w = 0; w < words; w++) {
+        uint64_t bits = ref[w];
+        uint32_t *a = ages + (size_t)w * 64;
+        for (uint32_t i = 0; i < 64; i++)
+            a[i] = a[i] >> 1 | (uint32_t)((bits >> i) & 1) << 31;
+    }
+}
+
+#if defined(__x86_64__)
+// SSE2 has no per-lane shift: spread 4 reference bits over the lanes by
+// comparing against each lane's own bit
+static void frame_age_sse2(uint32_t *ages, const uint64_t *ref, uint32_t words)
+{
+    const __m128i lane_bit = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i top = _mm_set1_epi32((int)0x80000000u);
+    for (uint32_t w = 0; w < words; w++) {
+        uint64_t bits = ref[w];
+        __m128i *a = (__m128i *)(ages + (size_t)w * 64);
+        for (uint32_t i = 0; i < 16; i++, bits >>= 4) {
+            __m128i b = _mm_and_si128(_mm_set1_epi32((int)(bits & 0xf)), lane_bit);
+            __m128i msb = _mm_and_si128(_mm_cmpeq_epi32(b, lane_bit), top);
+            _mm_store_si128(a + i, _mm_or_si128(_mm_srli_epi32(_mm_load_si128(a + i), 1), msb));
+        }
+    }
+}
+
+// AVX2 shifts each lane's reference bit straight to bit 31
+__attribute__((target("avx2"))) static void frame_age_avx2(uint32_t *ages, const uint64_t *ref,
+                                                           uint32_t words)
+{
+    const __m256i to_top = _mm256_setr_epi32(31, 30, 29, 28, 27, 26, 25, 24);
+    const __m256i top = _mm256_set1_epi32((int)0x80000000u);
+    for (uint32_t w = 0; w < words; w++) {
+        uint64_t bits = ref[w];
+        __m256i *a = (__m256i *)(ages + (size_t)w * 64);
+        for (uint32_t i = 0; i < 8; i++, bits >>= 8) {
+            __m256i msb =
+                _mm256_and_si256(_mm256_sllv_epi32(_mm256_set1_epi32((int)(bits & 0xff)), to_top),
+                                 top);
+            __m256i age = _mm256_srli_epi32(_mm256_load_si256(a + i), 1);
+            _mm256_store_si256(a + i, _mm256_or_si256(age, msb));
+        }
+    }
+}
+#endif
+
+static FrameAgeFn frame_age;
+static const char *frame_age_name = "scalar";
+
+void frame_set_aging_kernel(SimdLevel level)
+{
+    switch (simd_resolve(level)) {
+#if defined(__x86_64__)
+    case SIMD_AVX2:
+        frame_age = frame_age_avx2;
+        frame_age_name = "AVX2";
+        break;
+    case SIMD_SSE2:
+        frame_age = frame_age_sse2;
+        frame_age_name = "SSE2";
+        break;
+#endif
+    default:
+        frame_age = frame_age_scalar;
+        frame_age_name = "scalar";
+        break;
+    }
+}
+
+static void frame_select_kernel(void)
+{
+    if (!frame_age)
+        frame_set_aging_kernel(SIMD_AUTO);
+}
+
+const char *frame_aging_kernel_name(void)
+{
+    frame_select_kernel();
+    return frame_age_name;
+}
 
 FrameAllocator *frame_allocator_create(uint32_t num_frames)
 {
@@ -17,6 +107,10 @@ FrameAllocator *frame_allocator_create(uint32_t num_frames)
 
     allocator->total_frames = num_frames;
     allocator->free_frames = num_frames;
+    allocator->access_clock = 0;
+    allocator->age_sweeps = 0;
+    allocator->data = NULL;
+    allocator->page_size = 0;
 
     // Allocate frame info array
     allocator->frames = calloc(num_frames, sizeof(FrameInfo));
@@ -41,23 +135,42 @@ FrameAllocator *frame_allocator_create(uint32_t num_frames)
         return NULL;
     }
 
+    allocator->free_pos = malloc(num_frames * sizeof(uint32_t));
+    if (!allocator->free_pos) {
+        LOG_ERROR_MSG("Failed to allocate free list index");
+        free(allocator->free_list);
+        free(allocator->frames);
+        free(allocator);
+        return NULL;
+    }
+
     // Initialize free list with all frames
     for (uint32_t i = 0; i < num_frames; i++) {
         allocator->free_list[i] = i;
+        allocator->free_pos[i] = i;
     }
     allocator->free_list_top = num_frames;
-
-    // Allocate bitmap (1 bit per frame)
-    uint32_t bitmap_size = (num_frames + 7) / 8;
-    allocator->bitmap = calloc(bitmap_size, 1);
-    if (!allocator->bitmap) {
+    allocator->contig_cursor = 0;
+
+    // Allocate bitmaps (1 bit per frame)
+    uint32_t bitmap_words = (num_frames + 63) / 64;
+    allocator->bitmap = calloc(bitmap_words, sizeof(uint64_t));
+    allocator->ref_bitmap = calloc(bitmap_words, sizeof(uint64_t));
+    allocator->ages = aligned_alloc(64, (size_t)bitmap_words * 64 * sizeof(uint32_t));
+    if (!allocator->bitmap || !allocator->ref_bitmap || !allocator->ages) {
         LOG_ERROR_MSG("Failed to allocate bitmap");
+        free(allocator->bitmap);
+        free(allocator->ref_bitmap);
+        free(allocator->ages);
+        free(allocator->free_pos);
         free(allocator->free_list);
         free(allocator->frames);
         free(allocator);
         return NULL;
     }
 
+    memset(allocator->ages, 0, (size_t)bitmap_words * 64 * sizeof(uint32_t));
+
     LOG_INFO_MSG("Frame allocator created: %u frames (%u KB)", num_frames,
                  num_frames * 4); // Assuming 4KB pages
     return allocator;
@@ -67,35 +180,114 @@ void frame_allocator_destroy(FrameAllocator *allocator)
 {
     if (!allocator)
         return;
+    free(allocator->data);
     free(allocator->bitmap);
+    free(allocator->ref_bitmap);
+    free(allocator->ages);
+    free(allocator->free_pos);
     free(allocator->free_list);
     free(allocator->frames);
     free(allocator);
 }
 
-int32_t frame_alloc(FrameAllocator *allocator)
+bool frame_allocator_enable_data(FrameAllocator *allocator, uint32_t page_size)
 {
-    if (!allocator || allocator->free_list_top == 0) {
-        return -1; // No free frames
+    if (!allocator || page_size == 0)
+        return false;
+
+    // Page alignment keeps frames usable as O_DIRECT buffers
+    size_t align = page_size < 4096 ? 4096 : page_size;
+    uint64_t bytes = align_up((uint64_t)allocator->total_frames * page_size, align);
+    allocator->data = aligned_alloc(align, bytes);
+    if (!allocator->data) {
+        LOG_ERROR_MSG("Failed to allocate %lu MB frame buffer pool", bytes / (1024 * 1024));
+        return false;
     }
+    memset(allocator->data, 0, bytes);
+    allocator->page_size = page_size;
 
-    // Pop from free list
-    uint32_t frame_num = allocator->free_list[--allocator->free_list_top];
+    LOG_INFO_MSG("Frame buffer pool: %lu MB", bytes / (1024 * 1024));
+    return true;
+}
+
+// Mark a frame allocated (already removed from the free list). Every allocation,
+// including a frame reclaimed for the fault taking it, starts newest, referenced
+// and age 0: the page faulted in never inherits its victim's replacement state.
+static void take_frame(FrameAllocator *allocator, uint32_t frame_num)
+{
     allocator->free_frames--;
 
     // Update frame state
     allocator->frames[frame_num].state = FRAME_ALLOCATED;
-    allocator->frames[frame_num].reference_bit = 1;
-    allocator->frames[frame_num].last_access_time = get_timestamp_us();
-    allocator->frames[frame_num].age_counter = 0;
+    allocator->frames[frame_num].last_access_time = ++allocator->access_clock;
+    allocator->ages[frame_num] = 0;
+    allocator->frames[frame_num].readahead = false;
+    allocator->frames[frame_num].untouched = false;
+
+    // Set bitmap bits
+    allocator->bitmap[frame_num / 64] |= 1ULL << (frame_num % 64);
+    allocator->ref_bitmap[frame_num / 64] |= 1ULL << (frame_num % 64);
+}
 
-    // Set bitmap bit
-    allocator->bitmap[frame_num / 8] |= (1 << (frame_num % 8));
+int32_t frame_alloc(FrameAllocator *allocator)
+{
+    if (!allocator || allocator->free_list_top == 0) {
+        return -1; // No free frames
+    }
+
+    // Pop from free list
+    uint32_t frame_num = allocator->free_list[--allocator->free_list_top];
+    take_frame(allocator, frame_num);
 
     LOG_TRACE_MSG("Allocated frame %u (free: %u)", frame_num, allocator->free_frames);
     return (int32_t)frame_num;
 }
 
+static bool block_is_free(FrameAllocator *allocator, uint32_t first, uint32_t count)
+{
+    uint32_t i = first;
+    // Whole bitmap words first, then any bits left over
+    for (; i % 64 == 0 && i + 64 <= first + count; i += 64) {
+        if (allocator->bitmap[i / 64])
+            return false;
+    }
+    for (; i < first + count; i++) {
+        if (allocator->bitmap[i / 64] & (1ULL << (i % 64)))
+            return false;
+    }
+    return true;
+}
+
+int32_t frame_alloc_contig(FrameAllocator *allocator, uint32_t count)
+{
+    if (!allocator || count == 0 || !is_power_of_two(count) || allocator->free_frames < count) {
+        return -1;
+    }
+
+    // Next-fit over aligned blocks
+    uint32_t blocks = allocator->total_frames / count;
+    for (uint32_t n = 0; n < blocks; n++) {
+        uint32_t block = (allocator->contig_cursor + n) % blocks;
+        uint32_t first = block * count;
+        if (!block_is_free(allocator, first, count))
+            continue;
+
+        for (uint32_t f = first; f < first + count; f++) {
+            // Swap the last free entry into this frame's slot
+            uint32_t pos = allocator->free_pos[f];
+            uint32_t last = allocator->free_list[--allocator->free_list_top];
+            allocator->free_list[pos] = last;
+            allocator->free_pos[last] = pos;
+            take_frame(allocator, f);
+        }
+        allocator->contig_cursor = (block + 1) % blocks;
+        LOG_TRACE_MSG("Allocated frames %u-%u (free: %u)", first, first + count - 1,
+                      allocator->free_frames);
+        return (int32_t)first;
+    }
+    return -1;
+}
+
 bool frame_free(FrameAllocator *allocator, uint32_t frame_num)
 {
     if (!allocator || frame_num >= allocator->total_frames) {
@@ -111,14 +303,17 @@ bool frame_free(FrameAllocator *allocator, uint32_t frame_num)
     allocator->frames[frame_num].state = FRAME_FREE;
     allocator->frames[frame_num].pid = 0;
     allocator->frames[frame_num].vpn = 0;
-    allocator->frames[frame_num].reference_bit = 0;
     allocator->frames[frame_num].dirty = false;
+    allocator->frames[frame_num].readahead = false;
+    allocator->frames[frame_num].untouched = false;
     allocator->frames[frame_num].pin_count = 0;
 
-    // Clear bitmap bit
-    allocator->bitmap[frame_num / 8] &= ~(1 << (frame_num % 8));
+    // Clear bitmap bits
+    allocator->bitmap[frame_num / 64] &= ~(1ULL << (frame_num % 64));
+    allocator->ref_bitmap[frame_num / 64] &= ~(1ULL << (frame_num % 64));
 
     // Push to free list
+    allocator->free_pos[frame_num] = allocator->free_list_top;
     allocator->free_list[allocator->free_list_top++] = frame_num;
     allocator->free_frames++;
 
@@ -171,15 +366,19 @@ void frame_set_dirty(FrameAllocator *allocator, uint32_t frame_num, bool dirty)
 void frame_set_reference(FrameAllocator *allocator, uint32_t frame_num, bool referenced)
 {
     if (allocator && frame_num < allocator->total_frames) {
-        allocator->frames[frame_num].reference_bit = referenced ? 1 : 0;
+        uint64_t bit = 1ULL << (frame_num % 64);
+        if (referenced)
+            allocator->ref_bitmap[frame_num / 64] |= bit;
+        else
+            allocator->ref_bitmap[frame_num / 64] &= ~bit;
     }
 }
 
 void frame_update_access_time(FrameAllocator *allocator, uint32_t frame_num)
 {
     if (allocator && frame_num < allocator->total_frames) {
-        allocator->frames[frame_num].last_access_time = get_timestamp_us();
-        allocator->frames[frame_num].reference_bit = 1;
+        allocator->frames[frame_num].last_access_time = ++allocator->access_clock;
+        allocator->ref_bitmap[frame_num / 64] |= 1ULL << (frame_num % 64);
     }
 }
 
@@ -188,15 +387,27 @@ void frame_age_all(FrameAllocator *allocator)
     if (!allocator)
         return;
 
+    // Free frames age too: their reference bits are clear and allocation resets them
+    uint32_t words = (allocator->total_frames + 63) / 64;
+    frame_select_kernel();
+    frame_age(allocator->ages, allocator->ref_bitmap, words);
+    allocator->age_sweeps++;
+
+    // Every reference bit is now folded into an age counter
+    memset(allocator->ref_bitmap, 0, words * sizeof(uint64_t));
+}
+
+uint64_t frame_age_digest(const FrameAllocator *allocator)
+{
+    if (!allocator)
+        return 0;
+
+    // FNV-1a over the age counters
+    uint64_t hash = 0xcbf29ce484222325ULL;
     for (uint32_t i = 0; i < allocator->total_frames; i++) {
-        if (allocator->frames[i].state == FRAME_ALLOCATED) {
-            // Shift age counter right and add reference bit to MSB
-            allocator->frames[i].age_counter >>= 1;
-            if (allocator->frames[i].reference_bit) {
-                allocator->frames[i].age_counter |= 0x80000000;
-                allocator->frames[i].reference_bit = 0;
-            }
-        }
+        hash ^= allocator->ages[i];
+        hash *= 0x100000001b3ULL;
     }
+    return hash;
 }
 
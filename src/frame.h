@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "util.h"
 
 // Frame states
 typedef enum {
@@ -24,10 +26,10 @@ typedef struct {
     uint32_t pid;              // Process ID using this frame
     uint64_t vpn;              // Virtual page number mapped to this frame
     FrameState state;
-    uint32_t reference_bit;    // For Clock algorithm
-    uint32_t age_counter;      // For aging/approximate LRU
-    uint64_t last_access_time; // For exact LRU
+    uint64_t last_access_time; // For exact LRU (logical access clock)
     bool dirty;                // Modified bit
+    bool readahead;            // Loaded by swap readahead, not referenced yet
+    bool untouched;            // Part of a huge page but never referenced
     uint32_t pin_count;        // Reference count (for future shared memory)
 } FrameInfo;
 
@@ -37,16 +39,34 @@ typedef struct {
     uint32_t free_frames;
     FrameInfo *frames;         // Array of frame metadata
     uint32_t *free_list;       // Free frame stack
+    uint32_t *free_pos;        // Index of each free frame in free_list
     uint32_t free_list_top;
-    uint8_t *bitmap;           // Bitmap for quick free/used check
+    uint32_t contig_cursor;    // Next block frame_alloc_contig examines
+    uint64_t *bitmap;          // Allocated frames, one bit each
+    uint64_t *ref_bitmap;      // Reference bits (Clock, aging), one bit each
+    uint32_t *ages;            // Aging counters (approximate LRU), 64-byte aligned and
+                               // padded to whole bitmap words
+    uint64_t age_sweeps;       // frame_age_all calls so far
+    uint64_t access_clock;     // Logical clock stamped into last_access_time
+    uint8_t *data;             // Page-aligned buffer pool (real-data mode only)
+    uint32_t page_size;
 } FrameAllocator;
 
 // Initialize frame allocator
 FrameAllocator *frame_allocator_create(uint32_t num_frames);
 void frame_allocator_destroy(FrameAllocator *allocator);
 
+// Real-data mode: back every frame with a page-aligned buffer
+bool frame_allocator_enable_data(FrameAllocator *allocator, uint32_t page_size);
+static inline uint8_t *frame_get_data(FrameAllocator *allocator, uint32_t frame_num)
+{
+    return allocator->data ? allocator->data + (uint64_t)frame_num * allocator->page_size : NULL;
+}
+
 // Allocate and free frames
 int32_t frame_alloc(FrameAllocator *allocator);
+// Naturally aligned run of count frames (count a power of two), or -1
+int32_t frame_alloc_contig(FrameAllocator *allocator, uint32_t count);
 bool frame_free(FrameAllocator *allocator, uint32_t frame_num);
 
 // Frame information
@@ -59,10 +79,19 @@ void frame_set_pid(FrameAllocator *allocator, uint32_t frame_num, uint32_t pid);
 void frame_set_vpn(FrameAllocator *allocator, uint32_t frame_num, uint64_t vpn);
 void frame_set_dirty(FrameAllocator *allocator, uint32_t frame_num, bool dirty);
 void frame_set_reference(FrameAllocator *allocator, uint32_t frame_num, bool referenced);
+static inline bool frame_is_referenced(const FrameAllocator *allocator, uint32_t frame_num)
+{
+    return (allocator->ref_bitmap[frame_num / 64] >> (frame_num % 64)) & 1;
+}
 void frame_update_access_time(FrameAllocator *allocator, uint32_t frame_num);
 
-// Aging for approximate LRU
+// Aging for approximate LRU: every age shifts right and takes the reference
+// bit as its top bit, then reference bits clear. Vectorized with SSE2 or AVX2,
+// picked at run time, or scalar code elsewhere.
 void frame_age_all(FrameAllocator *allocator);
+const char *frame_aging_kernel_name(void);
+void frame_set_aging_kernel(SimdLevel level);
+uint64_t frame_age_digest(const FrameAllocator *allocator); // Hash of every age
 
 #endif // FRAME_H
 
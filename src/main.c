@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <getopt.h>
 
 static void print_usage(const char *prog_name)
@@ -29,17 +30,52 @@ static void print_usage(const char *prog_name)
     fprintf(stderr, "  -p, --page-size SIZE   Page size in bytes (default: 4096)\n");
     fprintf(stderr, "  -s, --swap SIZE        Swap size in MB (default: 256)\n");
     fprintf(stderr, "  -v, --vspace SIZE      Virtual address space in MB (default: 4096)\n");
+    fprintf(stderr, "  --swap-device DEV      Swap device: FIXED, HDD, SATA_SSD, NVME, ZRAM\n");
+    fprintf(stderr, "                         (default: FIXED)\n");
+    fprintf(stderr, "  --swap-qd N            Swap device queue depth (default: per device)\n");
+    fprintf(stderr, "  --swap-file PATH       Real-data mode: do real swap I/O on a file/device\n");
+    fprintf(stderr, "  --direct-io            Open the swap file with O_DIRECT\n");
+    fprintf(stderr, "  --io-batch N           Dirty pages gathered per write-back batch (default: 16)\n");
+    fprintf(stderr, "  --swap-readahead N     Max swap readahead window in pages, 1 = off\n");
+    fprintf(stderr, "                         (default: 8)\n");
+    fprintf(stderr, "  --kswapd               Reclaim in the background between free-frame\n");
+    fprintf(stderr, "                         watermarks instead of only in the fault path\n");
+    fprintf(stderr, "  --reclaim-batch N      Victims selected and evicted per direct reclaim\n");
+    fprintf(stderr, "                         (default: 1, max: 256)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Algorithms:\n");
     fprintf(stderr, "  -a, --algorithm ALGO   Replacement algorithm:\n");
-    fprintf(stderr, "                         FIFO, LRU, APPROX_LRU, CLOCK, OPT (default: CLOCK)\n");
-    fprintf(stderr, "  -T, --tlb-size SIZE    TLB entries (default: 64)\n");
-    fprintf(stderr, "  --tlb-policy POLICY    TLB policy: FIFO, LRU (default: LRU)\n");
-    fprintf(stderr, "  --pt-type TYPE         Page table type: SINGLE, TWO_LEVEL (default: SINGLE)\n");
+    fprintf(stderr, "                         FIFO, LRU, APPROX_LRU, CLOCK, CLOCK_PRO, ARC, LIRS,\n");
+    fprintf(stderr, "                         OPT (default: CLOCK)\n");
+    fprintf(stderr, "  --aging-interval N     Accesses between APPROX_LRU aging sweeps\n");
+    fprintf(stderr, "                         (default: 1000)\n");
+    fprintf(stderr, "  -T, --tlb-size SIZE    L1 dTLB entries (default: 64)\n");
+    fprintf(stderr, "  --tlb-ways N           L1 dTLB associativity, 0 = fully associative\n");
+    fprintf(stderr, "                         (default: 4)\n");
+    fprintf(stderr, "  --stlb SIZE            Second-level TLB entries, e.g. 1536 (default: none)\n");
+    fprintf(stderr, "  --stlb-ways N          STLB associativity (default: 12)\n");
+    fprintf(stderr, "  --tlb-policy POLICY    TLB policy within a set: FIFO, LRU, PLRU\n");
+    fprintf(stderr, "                         (default: LRU)\n");
+    fprintf(stderr, "  --simd LEVEL           Force the vector kernels: scalar, sse2, avx2\n");
+    fprintf(stderr, "                         (default: auto, the widest the CPU has)\n");
+    fprintf(stderr, "  --walk-cache N         Page-walk cache entries per upper table level,\n");
+    fprintf(stderr, "                         0 = off (default: 32)\n");
+    fprintf(stderr, "  --pt-type TYPE         Page table type: SINGLE, TWO_LEVEL, RADIX_4,\n");
+    fprintf(stderr, "                         RADIX_5, INVERTED (default: SINGLE)\n");
+    fprintf(stderr, "  --pt-reserve           Back SINGLE tables with reserved address space,\n");
+    fprintf(stderr, "                         committing host memory only where touched\n");
+    fprintf(stderr, "  --huge-pages SIZE      Huge page size, 2M or 1G; alone, the first touch\n");
+    fprintf(stderr, "                         of a region maps a whole huge page (needs a\n");
+    fprintf(stderr, "                         multi-level table; SINGLE becomes TWO_LEVEL)\n");
+    fprintf(stderr, "  --thp                  Transparent huge pages: fault base pages, collapse\n");
+    fprintf(stderr, "                         fully populated regions (default size: 2M)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Simulation:\n");
     fprintf(stderr, "  -n, --max-accesses N   Stop after N memory accesses (default: all)\n");
     fprintf(stderr, "  --seed SEED            Random seed (default: 42)\n");
+    fprintf(stderr, "  --opt-spill DIR        OPT out of core: stream the trace and its next-use\n");
+    fprintf(stderr, "                         index through files in DIR instead of memory\n");
+    fprintf(stderr, "  --opt-block N          Accesses per spill block (default: 65536)\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "Output:\n");
     fprintf(stderr, "  -o, --output FILE      Output file (JSON format)\n");
@@ -68,6 +104,10 @@ int main(int argc, char *argv[])
     vmm_config_init_default(&config);
 
     const char *trace_file = NULL;
+    const char *opt_spill_dir = NULL;
+    uint32_t opt_block = NEXTUSE_BLOCK_ENTRIES;
+    bool vspace_set = false;
+    bool tlb_ways_set = false;
     const char *output_file = NULL;
     const char *csv_file = NULL;
     const char *config_name = "default";
@@ -88,6 +128,25 @@ int main(int argc, char *argv[])
         {"output", required_argument, 0, 'o'},
         {"csv", required_argument, 0, 1003},
         {"config-name", required_argument, 0, 1004},
+        {"swap-device", required_argument, 0, 1005},
+        {"swap-qd", required_argument, 0, 1006},
+        {"swap-file", required_argument, 0, 1007},
+        {"direct-io", no_argument, 0, 1008},
+        {"io-batch", required_argument, 0, 1009},
+        {"swap-readahead", required_argument, 0, 1010},
+        {"kswapd", no_argument, 0, 1011},
+        {"reclaim-batch", required_argument, 0, 1012},
+        {"huge-pages", required_argument, 0, 1013},
+        {"thp", no_argument, 0, 1014},
+        {"pt-reserve", no_argument, 0, 1015},
+        {"walk-cache", required_argument, 0, 1016},
+        {"tlb-ways", required_argument, 0, 1017},
+        {"stlb", required_argument, 0, 1018},
+        {"stlb-ways", required_argument, 0, 1019},
+        {"opt-spill", required_argument, 0, 1020},
+        {"opt-block", required_argument, 0, 1021},
+        {"aging-interval", required_argument, 0, 1022},
+        {"simd", required_argument, 0, 1023},
         {"verbose", no_argument, 0, 'V'},
         {"debug", no_argument, 0, 'D'},
         {"quiet", no_argument, 0, 'q'},
@@ -115,7 +174,8 @@ int main(int argc, char *argv[])
             config.swap_size_mb = atoi(optarg);
             break;
         case 'v':
-            config.virtual_addr_space = (uint64_t)atoi(optarg) * 1024 * 1024;
+            config.virtual_addr_space = strtoull(optarg, NULL, 10) * 1024 * 1024;
+            vspace_set = true;
             break;
         case 'a':
             if (strcasecmp(optarg, "FIFO") == 0)
@@ -128,6 +188,12 @@ int main(int argc, char *argv[])
                 config.replacement_algo = REPLACE_CLOCK;
             else if (strcasecmp(optarg, "OPT") == 0)
                 config.replacement_algo = REPLACE_OPT;
+            else if (strcasecmp(optarg, "ARC") == 0)
+                config.replacement_algo = REPLACE_ARC;
+            else if (strcasecmp(optarg, "LIRS") == 0)
+                config.replacement_algo = REPLACE_LIRS;
+            else if (strcasecmp(optarg, "CLOCK_PRO") == 0)
+                config.replacement_algo = REPLACE_CLOCK_PRO;
             else {
                 fprintf(stderr, "Unknown replacement algorithm: %s\n", optarg);
                 return 1;
@@ -141,6 +207,8 @@ int main(int argc, char *argv[])
                 config.tlb_policy = TLB_FIFO;
             else if (strcasecmp(optarg, "LRU") == 0)
                 config.tlb_policy = TLB_LRU;
+            else if (strcasecmp(optarg, "PLRU") == 0)
+                config.tlb_policy = TLB_PLRU;
             else {
                 fprintf(stderr, "Unknown TLB policy: %s\n", optarg);
                 return 1;
@@ -151,6 +219,12 @@ int main(int argc, char *argv[])
                 config.pt_type = PT_SINGLE_LEVEL;
             else if (strcasecmp(optarg, "TWO_LEVEL") == 0)
                 config.pt_type = PT_TWO_LEVEL;
+            else if (strcasecmp(optarg, "RADIX_4") == 0)
+                config.pt_type = PT_RADIX_4;
+            else if (strcasecmp(optarg, "RADIX_5") == 0)
+                config.pt_type = PT_RADIX_5;
+            else if (strcasecmp(optarg, "INVERTED") == 0)
+                config.pt_type = PT_INVERTED;
             else {
                 fprintf(stderr, "Unknown page table type: %s\n", optarg);
                 return 1;
@@ -171,6 +245,78 @@ int main(int argc, char *argv[])
         case 1004: // --config-name
             config_name = optarg;
             break;
+        case 1005: // --swap-device
+            if (!swapdev_parse_type(optarg, &config.swap_device)) {
+                fprintf(stderr, "Unknown swap device: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 1006: // --swap-qd
+            config.swap_queue_depth = atoi(optarg);
+            break;
+        case 1007: // --swap-file
+            config.swap_file = optarg;
+            break;
+        case 1008: // --direct-io
+            config.direct_io = true;
+            break;
+        case 1009: // --io-batch
+            config.io_batch_pages = atoi(optarg);
+            break;
+        case 1010: // --swap-readahead
+            config.swap_readahead = atoi(optarg);
+            break;
+        case 1011: // --kswapd
+            config.kswapd = true;
+            break;
+        case 1012: // --reclaim-batch
+            config.reclaim_batch = atoi(optarg);
+            break;
+        case 1013: // --huge-pages
+            if (strcasecmp(optarg, "2M") == 0)
+                config.huge_page_size = 2ULL * 1024 * 1024;
+            else if (strcasecmp(optarg, "1G") == 0)
+                config.huge_page_size = 1ULL * 1024 * 1024 * 1024;
+            else {
+                fprintf(stderr, "Unknown huge page size: %s (use 2M or 1G)\n", optarg);
+                return 1;
+            }
+            break;
+        case 1014: // --thp
+            config.thp = true;
+            break;
+        case 1015: // --pt-reserve
+            config.pt_reserve = true;
+            break;
+        case 1016: // --walk-cache
+            config.walk_cache_entries = (uint32_t)atoi(optarg);
+            break;
+        case 1017: // --tlb-ways
+            config.tlb_ways = (uint32_t)atoi(optarg);
+            tlb_ways_set = true;
+            break;
+        case 1018: // --stlb
+            config.stlb_size = (uint32_t)atoi(optarg);
+            break;
+        case 1019: // --stlb-ways
+            config.stlb_ways = (uint32_t)atoi(optarg);
+            break;
+        case 1020: // --opt-spill
+            opt_spill_dir = optarg;
+            break;
+        case 1021: // --opt-block
+            opt_block = (uint32_t)atoi(optarg);
+            break;
+        case 1022: // --aging-interval
+            config.aging_interval = (uint32_t)atoi(optarg);
+            break;
+        case 1023: // --simd
+            if (!simd_parse(optarg, &config.simd)) {
+                fprintf(stderr, "Unknown SIMD level: %s (use scalar, sse2, avx2 or auto)\n",
+                        optarg);
+                return 1;
+            }
+            break;
         case 'V':
             config.verbose = true;
             set_log_level(LOG_INFO);
@@ -204,10 +350,43 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (opt_spill_dir && config.replacement_algo != REPLACE_OPT) {
+        fprintf(stderr, "Error: --opt-spill needs the OPT algorithm\n");
+        return 1;
+    }
+    if (opt_block == 0) {
+        fprintf(stderr, "Error: OPT spill block must be > 0 accesses\n");
+        return 1;
+    }
+
+    if (config.aging_interval == 0) {
+        fprintf(stderr, "Error: Aging interval must be > 0 accesses\n");
+        return 1;
+    }
+
     if (config.tlb_size == 0) {
         fprintf(stderr, "Error: TLB size must be > 0\n");
         return 1;
     }
+    // A -T size the default associativity does not divide stays fully associative
+    if (!tlb_ways_set && config.tlb_size % config.tlb_ways != 0)
+        config.tlb_ways = 0;
+
+    // Huge-page leaves live at L1 of a two-level table
+    if (config.thp && config.huge_page_size == 0)
+        config.huge_page_size = 2ULL * 1024 * 1024;
+    if (config.huge_page_size && config.huge_page_size <= config.page_size) {
+        fprintf(stderr, "Error: Huge page size must be larger than the page size\n");
+        return 1;
+    }
+    if (config.huge_page_size &&
+        (config.pt_type == PT_SINGLE_LEVEL || config.pt_type == PT_INVERTED))
+        config.pt_type = PT_TWO_LEVEL;
+
+    // Radix tables translate their whole layout (48 or 57 bits) unless told otherwise,
+    // and an inverted table any address at all
+    if (!vspace_set && pagetable_max_address_space(config.pt_type, config.page_size) > 0)
+        config.virtual_addr_space = pagetable_max_address_space(config.pt_type, config.page_size);
 
     // Print configuration
     printf("==================== VMM SIMULATOR ====================\n");
@@ -215,9 +394,15 @@ int main(int argc, char *argv[])
     printf("Trace file:       %s\n", trace_file);
     printf("=======================================================\n\n");
 
-    // Load trace
-    Trace *trace = trace_load(trace_file);
-    if (!trace) {
+    // Load trace, or spill it with its next-use index for out-of-core OPT
+    Trace *trace = NULL;
+    NextUseSpill *spill = NULL;
+    if (opt_spill_dir) {
+        spill = nextuse_spill_create(trace_file, opt_spill_dir, config.page_size, opt_block);
+    } else {
+        trace = trace_load(trace_file);
+    }
+    if (!trace && !spill) {
         fprintf(stderr, "Error: Failed to load trace file: %s\n", trace_file);
         return 1;
     }
@@ -227,15 +412,17 @@ int main(int argc, char *argv[])
     if (!vmm) {
         fprintf(stderr, "Error: Failed to create VMM\n");
         trace_destroy(trace);
+        nextuse_spill_destroy(spill);
         return 1;
     }
 
     // Run simulation
-    bool success = vmm_run_trace(vmm, trace);
+    bool success = spill ? vmm_run_spilled(vmm, spill) : vmm_run_trace(vmm, trace);
     if (!success) {
         fprintf(stderr, "Error: Simulation failed\n");
         vmm_destroy(vmm);
         trace_destroy(trace);
+        nextuse_spill_destroy(spill);
         return 1;
     }
 
@@ -257,6 +444,7 @@ int main(int argc, char *argv[])
     // Cleanup
     vmm_destroy(vmm);
     trace_destroy(trace);
+    nextuse_spill_destroy(spill);
 
     printf("\nSimulation completed successfully.\n");
     return 0;
@@ -7,6 +7,58 @@
 #include <stdlib.h>
 #include <string.h>
 
+static uint32_t histogram_bucket(uint64_t v)
+{
+    if (v < (1u << LATENCY_HIST_SUB_BITS))
+        return (uint32_t)v;
+
+    uint32_t exp = 63 - __builtin_clzll(v);
+    uint32_t sub = (v >> (exp - LATENCY_HIST_SUB_BITS)) & ((1u << LATENCY_HIST_SUB_BITS) - 1);
+    return ((exp - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS) + sub;
+}
+
+// Largest value that maps to bucket b
+static uint64_t histogram_bucket_ceiling(uint32_t b)
+{
+    if (b < (1u << LATENCY_HIST_SUB_BITS))
+        return b;
+
+    uint32_t exp = (b >> LATENCY_HIST_SUB_BITS) + LATENCY_HIST_SUB_BITS - 1;
+    uint64_t sub = b & ((1u << LATENCY_HIST_SUB_BITS) - 1);
+    uint64_t floor = (1ULL << exp) | (sub << (exp - LATENCY_HIST_SUB_BITS));
+    return floor + (1ULL << (exp - LATENCY_HIST_SUB_BITS)) - 1;
+}
+
+void histogram_record(LatencyHistogram *h, uint64_t value_ns)
+{
+    if (!h)
+        return;
+    h->counts[histogram_bucket(value_ns)]++;
+    h->total++;
+    if (value_ns > h->max_ns)
+        h->max_ns = value_ns;
+}
+
+uint64_t histogram_percentile(const LatencyHistogram *h, double percentile)
+{
+    if (!h || h->total == 0)
+        return 0;
+
+    uint64_t target = (uint64_t)(percentile / 100.0 * h->total);
+    if (target >= h->total)
+        return h->max_ns;
+
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen > target) {
+            uint64_t ceiling = histogram_bucket_ceiling(b);
+            return ceiling < h->max_ns ? ceiling : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
 Metrics *metrics_create(uint32_t max_processes)
 {
     Metrics *m = calloc(1, sizeof(Metrics));
@@ -128,12 +180,126 @@ void metrics_record_swap_out(Metrics *m)
         m->swap_outs++;
 }
 
+void metrics_record_readahead(Metrics *m, uint32_t pages)
+{
+    if (m) {
+        m->readahead_windows++;
+        m->readahead_pages += pages;
+    }
+}
+
+void metrics_record_readahead_hit(Metrics *m)
+{
+    if (m)
+        m->readahead_hits++;
+}
+
+void metrics_record_readahead_wasted(Metrics *m)
+{
+    if (m)
+        m->readahead_wasted++;
+}
+
+void metrics_record_huge_fault(Metrics *m, bool fell_back)
+{
+    if (!m)
+        return;
+    if (fell_back)
+        m->huge_fallbacks++;
+    else
+        m->huge_faults++;
+}
+
+void metrics_record_thp_collapse(Metrics *m, bool collapsed)
+{
+    if (!m)
+        return;
+    if (collapsed)
+        m->thp_collapses++;
+    else
+        m->thp_collapse_failures++;
+}
+
+void metrics_record_thp_split(Metrics *m)
+{
+    if (m)
+        m->thp_splits++;
+}
+
+void metrics_record_base_tlb_hit(Metrics *m)
+{
+    if (m)
+        m->base_tlb_hits++;
+}
+
+void metrics_record_fast_path_hit(Metrics *m)
+{
+    if (m)
+        m->fast_path_hits++;
+}
+
 void metrics_record_replacement(Metrics *m)
 {
     if (m)
         m->replacements++;
 }
 
+void metrics_record_reclaim(Metrics *m, bool background)
+{
+    if (!m)
+        return;
+    if (background)
+        m->background_reclaims++;
+    else
+        m->direct_reclaims++;
+}
+
+void metrics_record_victim_selection(Metrics *m, uint32_t victims, uint64_t steps)
+{
+    if (!m)
+        return;
+    m->victim_selections++;
+    m->victims_selected += victims;
+    m->victim_select_steps += steps;
+}
+
+void metrics_record_aging(Metrics *m, uint32_t frames, uint64_t host_ns)
+{
+    if (!m)
+        return;
+    m->aging_sweeps++;
+    m->aging_frames += frames;
+    m->aging_ns += host_ns;
+}
+
+void metrics_record_fault_latency(Metrics *m, uint64_t latency_ns)
+{
+    if (m)
+        histogram_record(&m->fault_latency, latency_ns);
+}
+
+void metrics_record_access_time(Metrics *m, uint32_t pid, uint64_t latency_ns,
+                                uint64_t stall_ns)
+{
+    if (!m)
+        return;
+
+    m->total_memory_access_time_ns += latency_ns;
+    m->total_stall_time_ns += stall_ns;
+
+    ProcessMetrics *pm = get_process_metrics(m, pid);
+    if (pm) {
+        pm->access_time_ns += latency_ns;
+        pm->stall_time_ns += stall_ns;
+    }
+}
+
+void metrics_set_sim_time(Metrics *m, uint64_t sim_time_ns)
+{
+    if (m)
+        m->sim_time_ns = sim_time_ns;
+}
+
 void metrics_start_simulation(Metrics *m)
 {
     if (m)
@@ -168,18 +334,27 @@ double metrics_get_avg_memory_access_time(Metrics *m, AccessTimeConfig *config)
     if (!m || !config || m->total_accesses == 0)
         return 0.0;
 
-    // AMT = TLB_hit_time + (TLB_miss_rate × page_table_time) + (page_fault_rate × page_fault_time)
+    // AMT = TLB_hit_time + (TLB_miss_rate × walk_refs × memory_time) + (page_fault_rate × page_fault_time)
     double tlb_hit_rate = metrics_get_tlb_hit_rate(m);
     double tlb_miss_rate = 1.0 - tlb_hit_rate;
     double page_fault_rate = metrics_get_page_fault_rate(m);
+    double walk_refs = m->walks.walks ? (double)m->walks.refs / m->walks.walks : 1.0;
+    double stlb_rate = (double)m->stlb_lookups / m->total_accesses;
 
-    double amt_ns = config->tlb_hit_time_ns +
-                    (tlb_miss_rate * config->memory_access_time_ns) +
+    double amt_ns = config->tlb_hit_time_ns + (stlb_rate * config->stlb_hit_time_ns) +
+                    (tlb_miss_rate * walk_refs * config->memory_access_time_ns) +
                     (page_fault_rate * config->page_fault_time_us * 1000);
 
     return amt_ns;
 }
 
+double metrics_get_simulated_access_time(Metrics *m)
+{
+    if (!m || m->total_accesses == 0)
+        return 0.0;
+    return (double)m->total_memory_access_time_ns / m->total_accesses;
+}
+
 void metrics_print_summary(Metrics *m, FILE *out, AccessTimeConfig *config)
 {
     if (!m || !out)
@@ -211,8 +386,79 @@ void metrics_print_summary(Metrics *m, FILE *out, AccessTimeConfig *config)
     fprintf(out, "  Hits:         %12lu\n", m->tlb_hits);
     fprintf(out, "  Misses:       %12lu\n", m->tlb_misses);
     fprintf(out, "  Hit Rate:     %12.2f%%\n", 100.0 * metrics_get_tlb_hit_rate(m));
+    if (m->stlb_lookups > 0) {
+        uint64_t l1_hits = m->tlb_hits - m->stlb_hits;
+        uint64_t lookups = m->tlb_hits + m->tlb_misses;
+        fprintf(out, "  L1 dTLB:      %12.2f%% (%lu hits)\n",
+                lookups ? 100.0 * l1_hits / lookups : 0.0, l1_hits);
+        fprintf(out, "  L2 STLB:      %12.2f%% of L1 misses (%lu hits)\n",
+                100.0 * m->stlb_hits / m->stlb_lookups, m->stlb_hits);
+    }
+    if (m->fast_path_hits > 0) {
+        fprintf(out, "  Fast path:    %12.2f%% of accesses (%lu)\n",
+                100.0 * m->fast_path_hits / m->total_accesses, m->fast_path_hits);
+    }
     fprintf(out, "\n");
 
+    // Page tables: what translation structures cost in host memory
+    if (m->pt_processes > 0) {
+        fprintf(out, "Page Tables:\n");
+        fprintf(out, "  Memory:       %12.1f KB (%u processes)\n", m->pt_memory_bytes / 1024.0,
+                m->pt_processes);
+        if (m->pt_levels > 0) {
+            fprintf(out, "  Nodes:       ");
+            for (uint32_t l = m->pt_levels; l > 0; l--)
+                fprintf(out, " L%u %lu%s", l, m->pt_nodes[l - 1], l > 1 ? "," : "\n");
+        }
+        const InvertedTableMetrics *inv = &m->inverted;
+        if (inv->capacity > 0) {
+            fprintf(out, "  Inverted:     %12lu entries in %lu slots\n", inv->entries,
+                    inv->capacity);
+            fprintf(out, "  Probes:       %12.2f avg, %lu max\n",
+                    inv->lookups ? (double)inv->probes / inv->lookups : 0.0, inv->max_probe);
+            fprintf(out, "  Collisions:   %12lu of %lu inserts, %lu rebuilds\n", inv->collisions,
+                    inv->inserts, inv->rebuilds);
+        }
+        fprintf(out, "\n");
+    }
+
+    // Page walks: what TLB misses cost in memory references
+    const WalkMetrics *w = &m->walks;
+    if (w->walks > 0) {
+        fprintf(out, "Page Walks:\n");
+        fprintf(out, "  Walks:        %12lu\n", w->walks);
+        fprintf(out, "  Refs/walk:    %12.2f (%.2f without walk cache)\n",
+                (double)w->refs / w->walks, (double)w->refs_uncached / w->walks);
+        if (w->entries_per_level > 0 && w->levels > 1) {
+            fprintf(out, "  Cache hits:  ");
+            for (uint32_t l = w->levels - 1; l > 0; l--)
+                fprintf(out, " L%u %.1f%%%s", l + 1, 100.0 * w->hits[l] / w->walks,
+                        l > 1 ? "," : "\n");
+        }
+        fprintf(out, "\n");
+    }
+
+    // Huge pages: TLB reach gained against the memory they hold unused
+    if (m->huge_page_size > 0) {
+        uint64_t lookups = m->tlb_hits + m->tlb_misses;
+        double base_rate = lookups ? (double)m->base_tlb_hits / lookups : 0.0;
+        double huge_rate = metrics_get_tlb_hit_rate(m);
+        if (m->huge_page_size >= 1024 * 1024 * 1024)
+            fprintf(out, "Huge Pages (%lu GB):\n", m->huge_page_size / (1024 * 1024 * 1024));
+        else
+            fprintf(out, "Huge Pages (%lu MB):\n", m->huge_page_size / (1024 * 1024));
+        fprintf(out, "  Huge faults:  %12lu (%lu fell back to base pages)\n", m->huge_faults,
+                m->huge_fallbacks);
+        fprintf(out, "  Collapses:    %12lu (%lu without free aligned frames)\n",
+                m->thp_collapses, m->thp_collapse_failures);
+        fprintf(out, "  Splits:       %12lu\n", m->thp_splits);
+        fprintf(out, "  TLB gain:     %+12.2f points (%.2f%% vs %.2f%% with base pages only)\n",
+                100.0 * (huge_rate - base_rate), 100.0 * huge_rate, 100.0 * base_rate);
+        fprintf(out, "  Bloat:        %12.2f MB peak (huge-page memory never referenced)\n",
+                m->huge_bloat_bytes / (1024.0 * 1024.0));
+        fprintf(out, "\n");
+    }
+
     // Swap I/O
     fprintf(out, "Swap I/O:\n");
     fprintf(out, "  Swap-ins:     %12lu\n", m->swap_ins);
@@ -220,6 +466,54 @@ void metrics_print_summary(Metrics *m, FILE *out, AccessTimeConfig *config)
     fprintf(out, "  Replacements: %12lu\n", m->replacements);
     fprintf(out, "\n");
 
+    // Reclaim: who freed the frames, and what faults paid for it
+    fprintf(out, "Reclaim:\n");
+    fprintf(out, "  Direct:       %12lu frames\n", m->direct_reclaims);
+    fprintf(out, "  Background:   %12lu frames (%lu kswapd wakeups)\n", m->background_reclaims,
+            m->kswapd_wakeups);
+    if (m->victims_selected > 0) {
+        fprintf(out, "  Selection:    %12.2f steps/victim (%.1f victims/pass)\n",
+                (double)m->victim_select_steps / m->victims_selected,
+                (double)m->victims_selected / m->victim_selections);
+    }
+    if (m->aging_frames > 0) {
+        fprintf(out, "  Aging:        %12.3f ns/frame (host, %lu sweeps, %s)\n",
+                (double)m->aging_ns / m->aging_frames, m->aging_sweeps,
+                m->aging_kernel ? m->aging_kernel : "scalar");
+    }
+    uint64_t hand_moves = m->hand_moves[0] + m->hand_moves[1] + m->hand_moves[2];
+    if (hand_moves > 0 && m->page_faults > 0) {
+        fprintf(out, "  Hand moves:   %12.2f per fault (cold %lu, hot %lu, test %lu)\n",
+                (double)hand_moves / m->page_faults, m->hand_moves[0], m->hand_moves[1],
+                m->hand_moves[2]);
+    }
+    if (m->arc_capacity > 0) {
+        fprintf(out, "  ARC L1 max:   %12u pages in T1 + B1 (c = %u)\n", m->arc_l1_max,
+                m->arc_capacity);
+    }
+    if (m->fault_latency.total > 0) {
+        fprintf(out, "  Fault p50:    %12.1f us\n",
+                histogram_percentile(&m->fault_latency, 50) / 1e3);
+        fprintf(out, "  Fault p99:    %12.1f us\n",
+                histogram_percentile(&m->fault_latency, 99) / 1e3);
+    }
+    fprintf(out, "\n");
+
+    // Swap readahead: every hit is a major fault that did not happen
+    if (m->readahead_windows > 0) {
+        uint64_t would_be_major = m->major_faults + m->readahead_hits;
+        fprintf(out, "Swap Readahead:\n");
+        fprintf(out, "  Windows:      %12lu (%.1f pages avg)\n", m->readahead_windows,
+                (double)m->readahead_pages / m->readahead_windows);
+        fprintf(out, "  Pages read:   %12lu\n", m->readahead_pages);
+        fprintf(out, "  Hits:         %12lu (%.1f%%)\n", m->readahead_hits,
+                m->readahead_pages ? 100.0 * m->readahead_hits / m->readahead_pages : 0.0);
+        fprintf(out, "  Wasted:       %12lu\n", m->readahead_wasted);
+        fprintf(out, "  Major saved:  %12lu (%.1f%% fewer major faults)\n", m->readahead_hits,
+                would_be_major ? 100.0 * m->readahead_hits / would_be_major : 0.0);
+        fprintf(out, "\n");
+    }
+
     // Timing
     if (config) {
         double amt = metrics_get_avg_memory_access_time(m, config);
@@ -230,6 +524,63 @@ void metrics_print_summary(Metrics *m, FILE *out, AccessTimeConfig *config)
         fprintf(out, "\n");
     }
 
+    // Simulated time (logical clock)
+    fprintf(out, "Simulated Time:\n");
+    fprintf(out, "  Total:        %12.3f ms\n", m->sim_time_ns / 1e6);
+    fprintf(out, "  Sim AMT:      %12.2f ns\n", metrics_get_simulated_access_time(m));
+    fprintf(out, "  Stall time:   %12.3f ms\n", m->total_stall_time_ns / 1e6);
+    fprintf(out, "\n");
+
+    // Swap device model
+    SwapDeviceMetrics *sd = &m->swap_device;
+    if (sd->device_name) {
+        if (sd->queue_depth > 0)
+            fprintf(out, "Swap Device (%s, QD %u):\n", sd->device_name, sd->queue_depth);
+        else
+            fprintf(out, "Swap Device (%s, unlimited QD):\n", sd->device_name);
+        fprintf(out, "  Requests:     %12lu (%lu reads, %lu writes)\n", sd->requests, sd->reads,
+                sd->writes);
+        fprintf(out, "  Utilization:  %12.2f%%\n",
+                m->sim_time_ns ? 100.0 * sd->busy_time_ns / m->sim_time_ns : 0.0);
+        fprintf(out, "  Avg queue:    %12.2f\n",
+                m->sim_time_ns ? (double)sd->total_latency_ns / m->sim_time_ns : 0.0);
+        fprintf(out, "  Avg I/O size: %12.1f KB (%lu pages)\n",
+                sd->requests ? sd->bytes / 1024.0 / sd->requests : 0.0, sd->pages);
+        fprintf(out, "  Seeks avoided:%12lu\n", sd->seeks_avoided);
+        fprintf(out, "  Batch hits:   %12lu\n", sd->batch_hits);
+        fprintf(out, "  Clusters:     %12u free of %u (%lu fallback slots)\n", sd->free_clusters,
+                sd->clusters, sd->cluster_fallbacks);
+        fprintf(out, "  Max queue:    %12u\n", sd->max_queue_length);
+        fprintf(out, "  Queue-full:   %12lu waits\n", sd->queue_full_waits);
+        fprintf(out, "  Latency p50:  %12.1f us\n", histogram_percentile(&sd->latency, 50) / 1e3);
+        fprintf(out, "  Latency p90:  %12.1f us\n", histogram_percentile(&sd->latency, 90) / 1e3);
+        fprintf(out, "  Latency p99:  %12.1f us\n", histogram_percentile(&sd->latency, 99) / 1e3);
+        fprintf(out, "  Latency max:  %12.1f us\n", sd->latency.max_ns / 1e3);
+        fprintf(out, "\n");
+    }
+
+    // Real I/O measured on the host, next to the simulated device numbers
+    RealIOMetrics *rio = &m->real_io;
+    if (rio->enabled) {
+        uint64_t io_ns = rio->read_time_ns + rio->write_time_ns;
+        uint64_t io_bytes = rio->bytes_read + rio->bytes_written;
+        fprintf(out, "Real Swap I/O (measured%s):\n", rio->direct_io ? ", O_DIRECT" : "");
+        fprintf(out, "  Reads:        %12lu calls (%.1f KB)\n", rio->read_calls,
+                rio->bytes_read / 1024.0);
+        fprintf(out, "  Writes:       %12lu calls (%.1f KB)\n", rio->write_calls,
+                rio->bytes_written / 1024.0);
+        fprintf(out, "  Read p50/p99: %12.1f / %.1f us\n",
+                histogram_percentile(&rio->read_latency, 50) / 1e3,
+                histogram_percentile(&rio->read_latency, 99) / 1e3);
+        fprintf(out, "  Write p50/p99:%12.1f / %.1f us\n",
+                histogram_percentile(&rio->write_latency, 50) / 1e3,
+                histogram_percentile(&rio->write_latency, 99) / 1e3);
+        fprintf(out, "  Throughput:   %12.1f MB/s\n",
+                io_ns ? (io_bytes / (1024.0 * 1024.0)) / (io_ns / 1e9) : 0.0);
+        fprintf(out, "  Verify errors:%12lu\n", rio->verify_errors);
+        fprintf(out, "\n");
+    }
+
     // Simulation time
     uint64_t sim_time_us = m->simulation_end_time_us - m->simulation_start_time_us;
     fprintf(out, "Simulation Time:\n");
@@ -249,14 +600,16 @@ void metrics_print_per_process(Metrics *m, FILE *out)
     fprintf(out, "\n");
     fprintf(out, "==================== PER-PROCESS METRICS ====================\n");
     fprintf(out, "\n");
-    fprintf(out, "  PID | Accesses  | Reads     | Writes    | Faults    | TLB Hits  | TLB Misses\n");
-    fprintf(out, "------+-----------+-----------+-----------+-----------+-----------+-----------\n");
+    fprintf(out, "  PID | Accesses  | Reads     | Writes    | Faults    | TLB Hits  | TLB Misses"
+                 " | Stall (ms)\n");
+    fprintf(out, "------+-----------+-----------+-----------+-----------+-----------+-----------"
+                 "+-----------\n");
 
     for (uint32_t i = 0; i < m->num_processes; i++) {
         ProcessMetrics *pm = &m->process_metrics[i];
-        fprintf(out, " %4u | %9lu | %9lu | %9lu | %9lu | %9lu | %9lu\n", pm->pid,
+        fprintf(out, " %4u | %9lu | %9lu | %9lu | %9lu | %9lu | %9lu  | %9.3f\n", pm->pid,
                 pm->total_accesses, pm->reads, pm->writes, pm->page_faults, pm->tlb_hits,
-                pm->tlb_misses);
+                pm->tlb_misses, pm->stall_time_ns / 1e6);
     }
 
     fprintf(out, "=================================================================\n");
@@ -276,17 +629,37 @@ bool metrics_save_csv(Metrics *m, const char *filename, const char *config_name,
 
     // Header
     fprintf(fp, "config,total_accesses,reads,writes,page_faults,pf_rate,tlb_hits,tlb_misses,"
-                "tlb_hit_rate,swap_ins,swap_outs,replacements,amt_ns,runtime_ms\n");
+                "tlb_hit_rate,swap_ins,swap_outs,replacements,amt_ns,runtime_ms,sim_time_ms,"
+                "sim_amt_ns,stall_ms,swap_util,swap_avg_queue,swap_p50_us,swap_p99_us,swap_avg_io_kb,"
+                "swap_seeks_avoided,ra_pages,ra_hits,ra_wasted,direct_reclaims,background_reclaims,"
+                "fault_p50_us,fault_p99_us,huge_faults,thp_collapses,thp_splits,base_tlb_hit_rate,"
+                "huge_bloat_mb,pt_memory_kb,walk_refs\n");
 
     // Data
     double amt = time_config ? metrics_get_avg_memory_access_time(m, time_config) : 0.0;
     uint64_t runtime_us = m->simulation_end_time_us - m->simulation_start_time_us;
 
-    fprintf(fp, "%s,%lu,%lu,%lu,%lu,%.6f,%lu,%lu,%.4f,%lu,%lu,%lu,%.2f,%.3f\n",
+    SwapDeviceMetrics *sd = &m->swap_device;
+    double sim_ns = m->sim_time_ns ? (double)m->sim_time_ns : 1.0;
+    uint64_t lookups = m->tlb_hits + m->tlb_misses;
+    fprintf(fp, "%s,%lu,%lu,%lu,%lu,%.6f,%lu,%lu,%.4f,%lu,%lu,%lu,%.2f,%.3f,%.3f,%.2f,%.3f,"
+                "%.4f,%.3f,%.1f,%.1f,%.2f,%lu,%lu,%lu,%lu,%lu,%lu,%.1f,%.1f,%lu,%lu,%lu,%.4f,"
+                "%.2f,%.1f,%.3f\n",
             config_name ? config_name : "default", m->total_accesses, m->total_reads,
             m->total_writes, m->page_faults, metrics_get_page_fault_rate(m), m->tlb_hits,
             m->tlb_misses, metrics_get_tlb_hit_rate(m), m->swap_ins, m->swap_outs,
-            m->replacements, amt, runtime_us / 1000.0);
+            m->replacements, amt, runtime_us / 1000.0, m->sim_time_ns / 1e6,
+            metrics_get_simulated_access_time(m), m->total_stall_time_ns / 1e6,
+            sd->busy_time_ns / sim_ns, sd->total_latency_ns / sim_ns,
+            histogram_percentile(&sd->latency, 50) / 1e3,
+            histogram_percentile(&sd->latency, 99) / 1e3,
+            sd->requests ? sd->bytes / 1024.0 / sd->requests : 0.0, sd->seeks_avoided,
+            m->readahead_pages, m->readahead_hits, m->readahead_wasted, m->direct_reclaims,
+            m->background_reclaims, histogram_percentile(&m->fault_latency, 50) / 1e3,
+            histogram_percentile(&m->fault_latency, 99) / 1e3, m->huge_faults, m->thp_collapses,
+            m->thp_splits, lookups ? (double)m->base_tlb_hits / lookups : 0.0,
+            m->huge_bloat_bytes / (1024.0 * 1024.0), m->pt_memory_bytes / 1024.0,
+            m->walks.walks ? (double)m->walks.refs / m->walks.walks : 0.0);
 
     fclose(fp);
     LOG_INFO_MSG("Saved CSV metrics to %s", filename);
@@ -318,6 +691,62 @@ bool metrics_save_json(Metrics *m, const char *filename, AccessTimeConfig *time_
     fprintf(fp, "  \"swap_ins\": %lu,\n", m->swap_ins);
     fprintf(fp, "  \"swap_outs\": %lu,\n", m->swap_outs);
     fprintf(fp, "  \"replacements\": %lu,\n", m->replacements);
+    fprintf(fp, "  \"direct_reclaims\": %lu,\n", m->direct_reclaims);
+    fprintf(fp, "  \"background_reclaims\": %lu,\n", m->background_reclaims);
+    fprintf(fp, "  \"kswapd_wakeups\": %lu,\n", m->kswapd_wakeups);
+    fprintf(fp, "  \"victim_selections\": %lu,\n", m->victim_selections);
+    fprintf(fp, "  \"victims_selected\": %lu,\n", m->victims_selected);
+    fprintf(fp, "  \"victim_select_steps\": %lu,\n", m->victim_select_steps);
+    fprintf(fp, "  \"aging\": {\"sweeps\": %lu, \"frames\": %lu, \"host_ns\": %lu},\n",
+            m->aging_sweeps, m->aging_frames, m->aging_ns);
+    fprintf(fp, "  \"hand_moves\": {\"cold\": %lu, \"hot\": %lu, \"test\": %lu},\n",
+            m->hand_moves[0], m->hand_moves[1], m->hand_moves[2]);
+    fprintf(fp, "  \"arc_l1_max\": %u,\n", m->arc_l1_max);
+    fprintf(fp, "  \"fault_latency_p50_us\": %.1f,\n",
+            histogram_percentile(&m->fault_latency, 50) / 1e3);
+    fprintf(fp, "  \"fault_latency_p99_us\": %.1f,\n",
+            histogram_percentile(&m->fault_latency, 99) / 1e3);
+    fprintf(fp, "  \"readahead\": {\n");
+    fprintf(fp, "    \"windows\": %lu,\n", m->readahead_windows);
+    fprintf(fp, "    \"pages\": %lu,\n", m->readahead_pages);
+    fprintf(fp, "    \"hits\": %lu,\n", m->readahead_hits);
+    fprintf(fp, "    \"wasted\": %lu\n", m->readahead_wasted);
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"huge_pages\": {\n");
+    fprintf(fp, "    \"page_size\": %lu,\n", m->huge_page_size);
+    fprintf(fp, "    \"faults\": %lu,\n", m->huge_faults);
+    fprintf(fp, "    \"fallbacks\": %lu,\n", m->huge_fallbacks);
+    fprintf(fp, "    \"collapses\": %lu,\n", m->thp_collapses);
+    fprintf(fp, "    \"collapse_failures\": %lu,\n", m->thp_collapse_failures);
+    fprintf(fp, "    \"splits\": %lu,\n", m->thp_splits);
+    fprintf(fp, "    \"base_tlb_hits\": %lu,\n", m->base_tlb_hits);
+    fprintf(fp, "    \"bloat_bytes\": %lu\n", m->huge_bloat_bytes);
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"stlb\": {\"lookups\": %lu, \"hits\": %lu},\n", m->stlb_lookups,
+            m->stlb_hits);
+    fprintf(fp, "  \"fast_path_hits\": %lu,\n", m->fast_path_hits);
+    fprintf(fp, "  \"page_walks\": {\n");
+    fprintf(fp, "    \"walk_cache_entries\": %u,\n", m->walks.entries_per_level);
+    fprintf(fp, "    \"walks\": %lu,\n", m->walks.walks);
+    fprintf(fp, "    \"refs\": %lu,\n", m->walks.refs);
+    fprintf(fp, "    \"refs_without_cache\": %lu,\n", m->walks.refs_uncached);
+    fprintf(fp, "    \"cache_hits_per_level\": [");
+    for (uint32_t l = 0; l < m->walks.levels; l++)
+        fprintf(fp, "%s%lu", l ? ", " : "", m->walks.hits[l]);
+    fprintf(fp, "]\n");
+    fprintf(fp, "  },\n");
+    fprintf(fp, "  \"page_tables\": {\n");
+    fprintf(fp, "    \"memory_bytes\": %lu,\n", m->pt_memory_bytes);
+    fprintf(fp, "    \"levels\": %u,\n", m->pt_levels);
+    fprintf(fp, "    \"nodes_per_level\": [");
+    for (uint32_t l = 0; l < m->pt_levels; l++)
+        fprintf(fp, "%s%lu", l ? ", " : "", m->pt_nodes[l]);
+    fprintf(fp, "],\n");
+    fprintf(fp, "    \"inverted\": {\"capacity\": %lu, \"entries\": %lu, \"lookups\": %lu, "
+                "\"probes\": %lu, \"max_probe\": %lu, \"collisions\": %lu, \"rebuilds\": %lu}\n",
+            m->inverted.capacity, m->inverted.entries, m->inverted.lookups, m->inverted.probes,
+            m->inverted.max_probe, m->inverted.collisions, m->inverted.rebuilds);
+    fprintf(fp, "  },\n");
 
     if (time_config) {
         fprintf(fp, "  \"avg_memory_access_time_ns\": %.2f,\n",
@@ -326,6 +755,63 @@ bool metrics_save_json(Metrics *m, const char *filename, AccessTimeConfig *time_
 
     uint64_t runtime_us = m->simulation_end_time_us - m->simulation_start_time_us;
     fprintf(fp, "  \"simulation_time_ms\": %.3f,\n", runtime_us / 1000.0);
+    fprintf(fp, "  \"sim_time_ms\": %.3f,\n", m->sim_time_ns / 1e6);
+    fprintf(fp, "  \"sim_avg_access_time_ns\": %.2f,\n", metrics_get_simulated_access_time(m));
+    fprintf(fp, "  \"stall_time_ms\": %.3f,\n", m->total_stall_time_ns / 1e6);
+
+    SwapDeviceMetrics *sd = &m->swap_device;
+    if (sd->device_name) {
+        double sim_ns = m->sim_time_ns ? (double)m->sim_time_ns : 1.0;
+        fprintf(fp, "  \"swap_device\": {\n");
+        fprintf(fp, "    \"name\": \"%s\",\n", sd->device_name);
+        fprintf(fp, "    \"queue_depth\": %u,\n", sd->queue_depth);
+        fprintf(fp, "    \"requests\": %lu,\n", sd->requests);
+        fprintf(fp, "    \"reads\": %lu,\n", sd->reads);
+        fprintf(fp, "    \"writes\": %lu,\n", sd->writes);
+        fprintf(fp, "    \"pages\": %lu,\n", sd->pages);
+        fprintf(fp, "    \"bytes\": %lu,\n", sd->bytes);
+        fprintf(fp, "    \"avg_io_kb\": %.2f,\n",
+                sd->requests ? sd->bytes / 1024.0 / sd->requests : 0.0);
+        fprintf(fp, "    \"seeks_avoided\": %lu,\n", sd->seeks_avoided);
+        fprintf(fp, "    \"batch_hits\": %lu,\n", sd->batch_hits);
+        fprintf(fp, "    \"free_clusters\": %u,\n", sd->free_clusters);
+        fprintf(fp, "    \"cluster_fallbacks\": %lu,\n", sd->cluster_fallbacks);
+        fprintf(fp, "    \"utilization\": %.4f,\n", sd->busy_time_ns / sim_ns);
+        fprintf(fp, "    \"avg_queue_length\": %.3f,\n", sd->total_latency_ns / sim_ns);
+        fprintf(fp, "    \"max_queue_length\": %u,\n", sd->max_queue_length);
+        fprintf(fp, "    \"queue_full_waits\": %lu,\n", sd->queue_full_waits);
+        fprintf(fp, "    \"latency_p50_us\": %.1f,\n", histogram_percentile(&sd->latency, 50) / 1e3);
+        fprintf(fp, "    \"latency_p90_us\": %.1f,\n", histogram_percentile(&sd->latency, 90) / 1e3);
+        fprintf(fp, "    \"latency_p99_us\": %.1f,\n", histogram_percentile(&sd->latency, 99) / 1e3);
+        fprintf(fp, "    \"latency_p999_us\": %.1f,\n",
+                histogram_percentile(&sd->latency, 99.9) / 1e3);
+        fprintf(fp, "    \"latency_max_us\": %.1f\n", sd->latency.max_ns / 1e3);
+        fprintf(fp, "  },\n");
+    }
+
+    RealIOMetrics *rio = &m->real_io;
+    if (rio->enabled) {
+        uint64_t io_ns = rio->read_time_ns + rio->write_time_ns;
+        uint64_t io_bytes = rio->bytes_read + rio->bytes_written;
+        fprintf(fp, "  \"real_io\": {\n");
+        fprintf(fp, "    \"direct_io\": %s,\n", rio->direct_io ? "true" : "false");
+        fprintf(fp, "    \"read_calls\": %lu,\n", rio->read_calls);
+        fprintf(fp, "    \"write_calls\": %lu,\n", rio->write_calls);
+        fprintf(fp, "    \"bytes_read\": %lu,\n", rio->bytes_read);
+        fprintf(fp, "    \"bytes_written\": %lu,\n", rio->bytes_written);
+        fprintf(fp, "    \"read_p50_us\": %.1f,\n",
+                histogram_percentile(&rio->read_latency, 50) / 1e3);
+        fprintf(fp, "    \"read_p99_us\": %.1f,\n",
+                histogram_percentile(&rio->read_latency, 99) / 1e3);
+        fprintf(fp, "    \"write_p50_us\": %.1f,\n",
+                histogram_percentile(&rio->write_latency, 50) / 1e3);
+        fprintf(fp, "    \"write_p99_us\": %.1f,\n",
+                histogram_percentile(&rio->write_latency, 99) / 1e3);
+        fprintf(fp, "    \"throughput_mb_s\": %.1f,\n",
+                io_ns ? (io_bytes / (1024.0 * 1024.0)) / (io_ns / 1e9) : 0.0);
+        fprintf(fp, "    \"verify_errors\": %lu\n", rio->verify_errors);
+        fprintf(fp, "  },\n");
+    }
 
     fprintf(fp, "  \"per_process\": [\n");
     for (uint32_t i = 0; i < m->num_processes; i++) {
@@ -337,7 +823,8 @@ bool metrics_save_json(Metrics *m, const char *filename, AccessTimeConfig *time_
         fprintf(fp, "      \"writes\": %lu,\n", pm->writes);
         fprintf(fp, "      \"page_faults\": %lu,\n", pm->page_faults);
         fprintf(fp, "      \"tlb_hits\": %lu,\n", pm->tlb_hits);
-        fprintf(fp, "      \"tlb_misses\": %lu\n", pm->tlb_misses);
+        fprintf(fp, "      \"tlb_misses\": %lu,\n", pm->tlb_misses);
+        fprintf(fp, "      \"stall_time_ms\": %.3f\n", pm->stall_time_ns / 1e6);
         fprintf(fp, "    }%s\n", i < m->num_processes - 1 ? "," : "");
     }
     fprintf(fp, "  ]\n");
@@ -21,8 +21,81 @@ typedef struct {
     uint64_t page_faults;
     uint64_t tlb_hits;
     uint64_t tlb_misses;
+    uint64_t access_time_ns; // Simulated latency of all accesses
+    uint64_t stall_time_ns;  // Time blocked in fault handling and swap I/O
 } ProcessMetrics;
 
+// Log-linear latency histogram (16 sub-buckets per power of two)
+#define LATENCY_HIST_SUB_BITS 4
+#define LATENCY_HIST_BUCKETS (64 << LATENCY_HIST_SUB_BITS)
+
+typedef struct {
+    uint64_t counts[LATENCY_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max_ns;
+} LatencyHistogram;
+
+// Swap device statistics (maintained by the device model and swap manager)
+typedef struct {
+    const char *device_name;
+    uint32_t queue_depth;
+    uint64_t requests;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t pages;            // Pages transferred (a request covers a run of slots)
+    uint64_t bytes;
+    uint64_t seeks_avoided;    // Pages that needed no positioning of their own
+    uint64_t batch_hits;       // Swap-ins served from the pending write batch
+    uint64_t busy_time_ns;     // Time with at least one request outstanding
+    uint64_t total_latency_ns; // Sum of request latencies (Little's law queue length)
+    uint32_t max_queue_length; // Peak outstanding requests
+    uint64_t queue_full_waits; // Submissions delayed by a full queue
+    LatencyHistogram latency;
+    uint32_t clusters;         // Slot clusters, and those empty at the end of the run
+    uint32_t free_clusters;
+    uint64_t cluster_fallbacks; // Slots handed out away from their page's cluster
+} SwapDeviceMetrics;
+
+// Real swap I/O measured on the host (real-data mode only)
+typedef struct {
+    bool enabled;
+    bool direct_io;
+    uint64_t read_calls;       // preadv() calls
+    uint64_t write_calls;      // pwritev() calls
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t read_time_ns;     // Host time spent in reads
+    uint64_t write_time_ns;    // Host time spent in writes
+    uint64_t verify_errors;    // Pages that came back with the wrong contents
+    LatencyHistogram read_latency;
+    LatencyHistogram write_latency;
+} RealIOMetrics;
+
+// Hashed inverted page table statistics (maintained by the table)
+typedef struct {
+    uint64_t capacity;   // Slots
+    uint64_t entries;    // Live (pid, vpn) entries
+    uint64_t lookups;
+    uint64_t probes;     // Slots examined by all lookups
+    uint64_t max_probe;  // Longest single lookup
+    uint64_t inserts;
+    uint64_t collisions; // Inserts that could not use their home slot
+    uint64_t rebuilds;   // Rehashes to grow or clear tombstones
+} InvertedTableMetrics;
+
+// Deepest page table the report breaks down by level
+#define METRICS_PT_MAX_LEVELS 5
+
+// Page walks on TLB misses (maintained by the walk cache)
+typedef struct {
+    uint32_t entries_per_level;              // Walk cache size, 0 = disabled
+    uint32_t levels;                         // Deepest table walked
+    uint64_t walks;
+    uint64_t refs;                           // Memory references made
+    uint64_t refs_uncached;                  // References without the walk cache
+    uint64_t hits[METRICS_PT_MAX_LEVELS];    // Walks resumed below each level
+} WalkMetrics;
+
 // Global metrics
 typedef struct {
     // Access counts
@@ -38,16 +111,65 @@ typedef struct {
     // TLB
     uint64_t tlb_hits;
     uint64_t tlb_misses;
+    uint64_t fast_path_hits; // Of tlb_hits, served by the last-translation cache
     
     // Swap I/O
     uint64_t swap_ins;
     uint64_t swap_outs;
+
+    // Swap readahead
+    uint64_t readahead_windows; // Swap-ins that read ahead
+    uint64_t readahead_pages;   // Pages brought in speculatively
+    uint64_t readahead_hits;    // Read-ahead pages later used (major faults avoided)
+    uint64_t readahead_wasted;  // Read-ahead pages evicted unused
+
+    // Huge pages
+    uint64_t huge_page_size;        // 0 = base pages only
+    uint64_t huge_faults;           // Faults that mapped a whole huge page
+    uint64_t huge_fallbacks;        // Huge-eligible faults with no free aligned frames
+    uint64_t thp_collapses;         // Fully populated regions remapped huge
+    uint64_t thp_collapse_failures; // Collapses with no free aligned frames
+    uint64_t thp_splits;            // Huge pages split by reclaim
+    uint64_t base_tlb_hits;         // Hits of a same-sized TLB holding base pages only
+    uint64_t stlb_lookups;          // L1 dTLB misses probed in the STLB
+    uint64_t stlb_hits;             // Of those, hits (counted in tlb_hits too)
+    uint64_t huge_bloat_bytes;      // Peak memory in huge pages never referenced
     
     // Page replacements
     uint64_t replacements;
+    uint64_t direct_reclaims;     // Frames reclaimed in the fault path
+    uint64_t background_reclaims; // Frames reclaimed by kswapd
+    uint64_t kswapd_wakeups;
+    uint64_t victim_selections;   // Policy passes
+    uint64_t victims_selected;
+    uint64_t victim_select_steps; // Policy work choosing them (see ReplacementPolicy)
+    uint64_t aging_sweeps;        // Approx-LRU aging passes
+    uint64_t aging_frames;        // Frames aged over all passes
+    uint64_t aging_ns;            // Host time spent aging
+    const char *aging_kernel;     // Aging code in use
+    uint64_t hand_moves[3];       // CLOCK-Pro: entries passed by the cold, hot and test hands
+    uint32_t arc_l1_max;          // ARC: largest |T1| + |B1| after a miss
+    uint32_t arc_capacity;        // ARC: c, the frames it manages
+    LatencyHistogram fault_latency; // Fault handling plus I/O wait per fault
     
     // Timing (simulated)
-    uint64_t total_memory_access_time_us; // Microseconds
+    uint64_t total_memory_access_time_ns; // Sum of per-access simulated latency
+    uint64_t total_stall_time_ns;         // Sum of fault/swap stalls
+    uint64_t sim_time_ns;                 // Logical clock at end of run
+
+    // Page tables (sampled at the end of the run)
+    uint64_t pt_memory_bytes;                      // All processes
+    uint32_t pt_processes;
+    uint32_t pt_levels;                            // Radix levels (0 = not a radix table)
+    uint64_t pt_nodes[METRICS_PT_MAX_LEVELS];      // Radix nodes per level, leaf level first
+    InvertedTableMetrics inverted;                 // Shared inverted table, if used
+    WalkMetrics walks;                             // TLB-miss walks and walk cache
+
+    // Swap device model
+    SwapDeviceMetrics swap_device;
+    RealIOMetrics real_io;
+
+    // Timing (host wall clock, start/end only)
     uint64_t simulation_start_time_us;
     uint64_t simulation_end_time_us;
     
@@ -61,11 +183,16 @@ typedef struct {
 // Configuration for AMT calculation
 typedef struct {
     uint64_t tlb_hit_time_ns;      // TLB hit latency (nanoseconds)
+    uint64_t stlb_hit_time_ns;     // Extra latency of a second-level TLB hit
     uint64_t memory_access_time_ns; // Memory access time
     uint64_t page_fault_time_us;    // Page fault handling time (microseconds)
     uint64_t swap_io_time_us;       // Swap I/O time
 } AccessTimeConfig;
 
+// Latency histogram
+void histogram_record(LatencyHistogram *h, uint64_t value_ns);
+uint64_t histogram_percentile(const LatencyHistogram *h, double percentile);
+
 // Metrics operations
 Metrics *metrics_create(uint32_t max_processes);
 void metrics_destroy(Metrics *metrics);
@@ -77,7 +204,22 @@ void metrics_record_tlb_miss(Metrics *m, uint32_t pid);
 void metrics_record_page_fault(Metrics *m, uint32_t pid, bool is_major);
 void metrics_record_swap_in(Metrics *m);
 void metrics_record_swap_out(Metrics *m);
+void metrics_record_readahead(Metrics *m, uint32_t pages);
+void metrics_record_readahead_hit(Metrics *m);
+void metrics_record_readahead_wasted(Metrics *m);
+void metrics_record_huge_fault(Metrics *m, bool fell_back);
+void metrics_record_thp_collapse(Metrics *m, bool collapsed);
+void metrics_record_thp_split(Metrics *m);
+void metrics_record_base_tlb_hit(Metrics *m);
+void metrics_record_fast_path_hit(Metrics *m);
 void metrics_record_replacement(Metrics *m);
+void metrics_record_reclaim(Metrics *m, bool background);
+void metrics_record_victim_selection(Metrics *m, uint32_t victims, uint64_t steps);
+void metrics_record_aging(Metrics *m, uint32_t frames, uint64_t host_ns);
+void metrics_record_fault_latency(Metrics *m, uint64_t latency_ns);
+void metrics_record_access_time(Metrics *m, uint32_t pid, uint64_t latency_ns,
+                                uint64_t stall_ns);
+void metrics_set_sim_time(Metrics *m, uint64_t sim_time_ns);
 
 // Simulation timing
 void metrics_start_simulation(Metrics *m);
@@ -87,6 +229,7 @@ void metrics_end_simulation(Metrics *m);
 double metrics_get_page_fault_rate(Metrics *m);
 double metrics_get_tlb_hit_rate(Metrics *m);
 double metrics_get_avg_memory_access_time(Metrics *m, AccessTimeConfig *config);
+double metrics_get_simulated_access_time(Metrics *m);
 
 // Reporting
 void metrics_print_summary(Metrics *m, FILE *out, AccessTimeConfig *config);
@@ -0,0 +1,199 @@
+/**
+ * nextuse.c - Out-of-core next-use index implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L // mkstemp, pread/pwrite
+
+#include "nextuse.h"
+#include "util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Unlinked temp file in dir: gone with the descriptor, whatever happens
+static int spill_open(const char *dir, const char *name)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/vmm-%s-XXXXXX", dir, name);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        LOG_ERROR_MSG("Failed to create spill file in %s", dir);
+        return -1;
+    }
+    unlink(path);
+    return fd;
+}
+
+static bool spill_pread(int fd, void *buf, size_t bytes, uint64_t offset)
+{
+    uint8_t *p = buf;
+    while (bytes > 0) {
+        ssize_t got = pread(fd, p, bytes, (off_t)offset);
+        if (got <= 0)
+            return false;
+        p += got;
+        bytes -= (size_t)got;
+        offset += (uint64_t)got;
+    }
+    return true;
+}
+
+static bool spill_pwrite(int fd, const void *buf, size_t bytes, uint64_t offset)
+{
+    const uint8_t *p = buf;
+    while (bytes > 0) {
+        ssize_t put = pwrite(fd, p, bytes, (off_t)offset);
+        if (put <= 0)
+            return false;
+        p += put;
+        bytes -= (size_t)put;
+        offset += (uint64_t)put;
+    }
+    return true;
+}
+
+// Pass 1: parse the text trace into the entry column
+static bool spill_entries(NextUseSpill *spill, const char *trace_file)
+{
+    FILE *fp = fopen(trace_file, "r");
+    if (!fp) {
+        LOG_ERROR_MSG("Failed to open trace file: %s", trace_file);
+        return false;
+    }
+
+    char line[256];
+    uint64_t n = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) {
+        if (!trace_parse_line(line, &spill->entries[n]))
+            continue;
+        if (++n == spill->block_entries) {
+            ok = spill_pwrite(spill->entries_fd, spill->entries, n * sizeof(TraceEntry),
+                              spill->count * sizeof(TraceEntry));
+            spill->count += n;
+            n = 0;
+        }
+    }
+    if (ok && n > 0) {
+        ok = spill_pwrite(spill->entries_fd, spill->entries, n * sizeof(TraceEntry),
+                          spill->count * sizeof(TraceEntry));
+        spill->count += n;
+    }
+    fclose(fp);
+
+    if (!ok)
+        LOG_ERROR_MSG("Failed to write trace spill");
+    return ok;
+}
+
+// Pass 2: blocks from last to first, each scanned backward; the map holds the
+// nearest later access of every page seen so far
+static bool spill_next_uses(NextUseSpill *spill, uint32_t page_size)
+{
+    uint64_t blocks = (spill->count + spill->block_entries - 1) / spill->block_entries;
+    for (uint64_t b = blocks; b-- > 0;) {
+        uint64_t start = b * spill->block_entries;
+        uint64_t n = spill->count - start < spill->block_entries ? spill->count - start
+                                                                 : spill->block_entries;
+        if (!spill_pread(spill->entries_fd, spill->entries, n * sizeof(TraceEntry),
+                         start * sizeof(TraceEntry))) {
+            LOG_ERROR_MSG("Failed to read trace spill");
+            return false;
+        }
+
+        for (uint64_t i = n; i-- > 0;) {
+            const TraceEntry *e = &spill->entries[i];
+            uint64_t vpn = e->virtual_addr / page_size;
+            if (!pagemap_get(spill->first_use, e->pid, vpn, &spill->next_use[i]))
+                spill->next_use[i] = UINT64_MAX;
+            if (!pagemap_put(spill->first_use, e->pid, vpn, start + i)) {
+                LOG_ERROR_MSG("Failed to grow next-use map");
+                return false;
+            }
+        }
+
+        if (!spill_pwrite(spill->next_fd, spill->next_use, n * sizeof(uint64_t),
+                          start * sizeof(uint64_t))) {
+            LOG_ERROR_MSG("Failed to write next-use spill");
+            return false;
+        }
+    }
+    return true;
+}
+
+NextUseSpill *nextuse_spill_create(const char *trace_file, const char *dir, uint32_t page_size,
+                                   uint32_t block_entries)
+{
+    if (!trace_file || !dir || page_size == 0 || block_entries == 0)
+        return NULL;
+
+    NextUseSpill *spill = calloc(1, sizeof(NextUseSpill));
+    if (!spill) {
+        LOG_ERROR_MSG("Failed to allocate next-use spill");
+        return NULL;
+    }
+    spill->block_entries = block_entries;
+    spill->entries_fd = spill_open(dir, "trace");
+    spill->next_fd = spill->entries_fd < 0 ? -1 : spill_open(dir, "nextuse");
+    spill->entries = malloc((size_t)block_entries * sizeof(TraceEntry));
+    spill->next_use = malloc((size_t)block_entries * sizeof(uint64_t));
+    spill->first_use = pagemap_create(1024);
+    if (spill->next_fd < 0 || !spill->entries || !spill->next_use || !spill->first_use) {
+        LOG_ERROR_MSG("Failed to set up next-use spill");
+        nextuse_spill_destroy(spill);
+        return NULL;
+    }
+
+    uint64_t start = get_monotonic_ns();
+    if (!spill_entries(spill, trace_file) || !spill_next_uses(spill, page_size)) {
+        nextuse_spill_destroy(spill);
+        return NULL;
+    }
+
+    LOG_INFO_MSG("OPT spill: %lu accesses, %lu distinct pages, %lu KB on disk in %.1f ms",
+                 spill->count, spill->first_use->count,
+                 spill->count * (sizeof(TraceEntry) + sizeof(uint64_t)) / 1024,
+                 (get_monotonic_ns() - start) / 1e6);
+    return spill;
+}
+
+void nextuse_spill_destroy(NextUseSpill *spill)
+{
+    if (!spill)
+        return;
+    if (spill->entries_fd >= 0)
+        close(spill->entries_fd);
+    if (spill->next_fd >= 0)
+        close(spill->next_fd);
+    free(spill->entries);
+    free(spill->next_use);
+    pagemap_destroy(spill->first_use);
+    free(spill);
+}
+
+bool nextuse_spill_get(NextUseSpill *spill, uint64_t index, TraceEntry *entry, uint64_t *next)
+{
+    if (!spill || index >= spill->count)
+        return false;
+
+    if (index < spill->block_start || index >= spill->block_start + spill->block_count) {
+        uint64_t start = index - index % spill->block_entries;
+        uint64_t n = spill->count - start < spill->block_entries ? spill->count - start
+                                                                 : spill->block_entries;
+        if (!spill_pread(spill->entries_fd, spill->entries, n * sizeof(TraceEntry),
+                         start * sizeof(TraceEntry)) ||
+            !spill_pread(spill->next_fd, spill->next_use, n * sizeof(uint64_t),
+                         start * sizeof(uint64_t))) {
+            LOG_ERROR_MSG("Failed to read spill block at access %lu", start);
+            spill->block_count = 0;
+            return false;
+        }
+        spill->block_start = start;
+        spill->block_count = n;
+    }
+
+    *entry = spill->entries[index - spill->block_start];
+    *next = spill->next_use[index - spill->block_start];
+    return true;
+}
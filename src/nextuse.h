@@ -0,0 +1,46 @@
+/**
+ * nextuse.h - Out-of-core next-use index for OPT
+ *
+ * Lets OPT run on traces larger than memory. The trace file is streamed once
+ * into a binary column of entries in a spill directory, then read backward a
+ * block at a time to give every access the index of its page's next access,
+ * written to a second column at the same position. The replay reads both
+ * columns forward, a block at a time. Memory stays at one block of each plus
+ * one map entry per distinct page, however long the trace is.
+ */
+
+#ifndef NEXTUSE_H
+#define NEXTUSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace.h"
+#include "pagemap.h"
+
+// Accesses per spill block (default)
+#define NEXTUSE_BLOCK_ENTRIES 65536
+
+typedef struct {
+    int entries_fd;         // TraceEntry per access (unlinked temp file)
+    int next_fd;            // uint64_t next use per access, UINT64_MAX = never
+    uint64_t count;         // Accesses in the trace
+    uint32_t block_entries;
+    PageMap *first_use;     // (pid, vpn) -> first access; NULL once taken by the policy
+
+    // Forward replay: the block holding the last access read
+    TraceEntry *entries;
+    uint64_t *next_use;
+    uint64_t block_start;
+    uint64_t block_count;
+} NextUseSpill;
+
+// Build both columns for trace_file in dir, splitting addresses by page_size
+NextUseSpill *nextuse_spill_create(const char *trace_file, const char *dir, uint32_t page_size,
+                                   uint32_t block_entries);
+void nextuse_spill_destroy(NextUseSpill *spill);
+
+// Access index and its next use; reads a new block whenever index leaves the
+// current one, so a forward replay reads each column sequentially
+bool nextuse_spill_get(NextUseSpill *spill, uint64_t index, TraceEntry *entry, uint64_t *next);
+
+#endif // NEXTUSE_H
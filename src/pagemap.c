@@ -0,0 +1,157 @@
+/**
+ * pagemap.c - (pid, vpn) hash map implementation
+ */
+
+#include "pagemap.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PAGEMAP_MIN_CAPACITY 16
+
+static uint64_t capacity_for(uint64_t expected_entries)
+{
+    // Keep the load factor at or below one half
+    uint64_t capacity = PAGEMAP_MIN_CAPACITY;
+    while (capacity < expected_entries * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+PageMap *pagemap_create(uint64_t expected_entries)
+{
+    PageMap *map = malloc(sizeof(PageMap));
+    if (!map) {
+        LOG_ERROR_MSG("Failed to allocate page map");
+        return NULL;
+    }
+
+    map->capacity = capacity_for(expected_entries);
+    map->count = 0;
+    map->entries = calloc(map->capacity, sizeof(PageMapEntry));
+    if (!map->entries) {
+        LOG_ERROR_MSG("Failed to allocate page map entries");
+        free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+void pagemap_destroy(PageMap *map)
+{
+    if (!map)
+        return;
+    free(map->entries);
+    free(map);
+}
+
+void pagemap_clear(PageMap *map)
+{
+    if (!map)
+        return;
+    memset(map->entries, 0, map->capacity * sizeof(PageMapEntry));
+    map->count = 0;
+}
+
+// Slot holding the key, or the empty slot where it would go
+static uint64_t find_slot(const PageMap *map, uint32_t pid, uint64_t vpn)
+{
+    uint64_t mask = map->capacity - 1;
+    uint64_t i = pagemap_hash(pid, vpn) & mask;
+    while (map->entries[i].used && (map->entries[i].vpn != vpn || map->entries[i].pid != pid)) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool grow(PageMap *map)
+{
+    uint64_t old_capacity = map->capacity;
+    PageMapEntry *old_entries = map->entries;
+
+    map->entries = calloc(old_capacity * 2, sizeof(PageMapEntry));
+    if (!map->entries) {
+        LOG_ERROR_MSG("Failed to grow page map");
+        map->entries = old_entries;
+        return false;
+    }
+    map->capacity = old_capacity * 2;
+
+    for (uint64_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].used) {
+            map->entries[find_slot(map, old_entries[i].pid, old_entries[i].vpn)] = old_entries[i];
+        }
+    }
+    free(old_entries);
+    return true;
+}
+
+bool pagemap_get(const PageMap *map, uint32_t pid, uint64_t vpn, uint64_t *value)
+{
+    if (!map)
+        return false;
+
+    const PageMapEntry *e = &map->entries[find_slot(map, pid, vpn)];
+    if (!e->used)
+        return false;
+    if (value)
+        *value = e->value;
+    return true;
+}
+
+bool pagemap_put(PageMap *map, uint32_t pid, uint64_t vpn, uint64_t value)
+{
+    if (!map)
+        return false;
+
+    if ((map->count + 1) * 2 > map->capacity && !grow(map)) {
+        return false;
+    }
+
+    PageMapEntry *e = &map->entries[find_slot(map, pid, vpn)];
+    if (!e->used) {
+        e->used = 1;
+        e->pid = pid;
+        e->vpn = vpn;
+        map->count++;
+    }
+    e->value = value;
+    return true;
+}
+
+bool pagemap_remove(PageMap *map, uint32_t pid, uint64_t vpn)
+{
+    if (!map)
+        return false;
+
+    uint64_t mask = map->capacity - 1;
+    uint64_t hole = find_slot(map, pid, vpn);
+    if (!map->entries[hole].used)
+        return false;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    uint64_t i = hole;
+    while (1) {
+        i = (i + 1) & mask;
+        PageMapEntry *e = &map->entries[i];
+        if (!e->used)
+            break;
+        uint64_t home = pagemap_hash(e->pid, e->vpn) & mask;
+        // Move e into the hole unless its home lies cyclically in (hole, i]
+        bool stays = hole <= i ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!stays) {
+            map->entries[hole] = *e;
+            hole = i;
+        }
+    }
+    map->entries[hole].used = 0;
+    map->count--;
+    return true;
+}
+
+uint64_t pagemap_memory_bytes(const PageMap *map)
+{
+    return map ? sizeof(PageMap) + map->capacity * sizeof(PageMapEntry) : 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * pagemap.h - Hash map keyed by (pid, vpn)
+ *
+ * Open-addressing table with linear probing and backward-shift deletion.
+ * Used wherever a virtual page has to be found without walking a page
+ * table: swap clusters, replacement-policy history, trace pre-passes.
+ */
+
+#ifndef PAGEMAP_H
+#define PAGEMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint64_t vpn;
+    uint32_t pid;
+    uint32_t used;
+    uint64_t value;
+} PageMapEntry;
+
+typedef struct {
+    PageMapEntry *entries;
+    uint64_t capacity;   // Power of two
+    uint64_t count;
+} PageMap;
+
+// Map lifecycle
+PageMap *pagemap_create(uint64_t expected_entries);
+void pagemap_destroy(PageMap *map);
+void pagemap_clear(PageMap *map);
+
+// Lookup and update
+bool pagemap_get(const PageMap *map, uint32_t pid, uint64_t vpn, uint64_t *value);
+bool pagemap_put(PageMap *map, uint32_t pid, uint64_t vpn, uint64_t value);
+bool pagemap_remove(PageMap *map, uint32_t pid, uint64_t vpn);
+
+// Bytes used by the table
+uint64_t pagemap_memory_bytes(const PageMap *map);
+
+// Hash shared with other (pid, vpn) keyed structures
+static inline uint64_t pagemap_hash(uint32_t pid, uint64_t vpn)
+{
+    uint64_t h = vpn ^ ((uint64_t)pid << 40) ^ ((uint64_t)pid >> 24);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+#endif // PAGEMAP_H
@@ -2,18 +2,391 @@
  * pagetable.c - Page table implementation
  */
 
+#define _GNU_SOURCE // MAP_NORESERVE
 #include "pagetable.h"
+#include "pagemap.h"
 #include "util.h"
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ---- Radix tables ----
+
+static size_t radix_node_size(uint32_t level)
+{
+    size_t entry = level == 0 ? sizeof(PageTableEntry) : sizeof(RadixNode *);
+    return offsetof(RadixNode, child) + entry * PT_RADIX_FANOUT;
+}
+
+static RadixNode *radix_alloc_node(RadixPageTable *rt, uint32_t level)
+{
+    RadixNode *node = calloc(1, radix_node_size(level));
+    if (!node) {
+        LOG_ERROR_MSG("Failed to allocate level %u page table node", level + 1);
+        return NULL;
+    }
+    rt->nodes[level]++;
+    rt->bytes += radix_node_size(level);
+    return node;
+}
+
+static void radix_free_node(RadixPageTable *rt, RadixNode *node, uint32_t level)
+{
+    if (!node)
+        return;
+    if (level > 0) {
+        for (uint32_t i = 0; i < PT_RADIX_FANOUT; i++) {
+            radix_free_node(rt, node->child[i], level - 1);
+        }
+    }
+    if (node->huge) {
+        free(node->huge);
+        rt->bytes -= PT_RADIX_FANOUT * sizeof(PageTableEntry);
+    }
+    rt->nodes[level]--;
+    rt->bytes -= radix_node_size(level);
+    free(node);
+}
+
+static inline uint32_t radix_index(uint64_t vpn, uint32_t level)
+{
+    return (vpn >> (level * PT_RADIX_BITS)) & (PT_RADIX_FANOUT - 1);
+}
+
+static inline bool radix_is_huge(const RadixNode *node, uint32_t i)
+{
+    return node->huge && (pte_flags(&node->huge[i]) & PTE_HUGE);
+}
+
+// Node at level covering vpn, optionally allocating missing nodes on the way.
+// path[l] receives each node passed from the root down. NULL if absent or if a
+// huge-page leaf above level covers vpn.
+static RadixNode *radix_descend(RadixPageTable *rt, uint64_t vpn, uint32_t level, bool alloc,
+                                RadixNode **path)
+{
+    RadixNode *node = rt->root;
+    for (uint32_t l = rt->levels - 1; l > level; l--) {
+        path[l] = node;
+        uint32_t i = radix_index(vpn, l);
+        if (radix_is_huge(node, i))
+            return NULL;
+        if (!node->child[i]) {
+            if (!alloc)
+                return NULL;
+            node->child[i] = radix_alloc_node(rt, l - 1);
+            if (!node->child[i])
+                return NULL;
+        }
+        node = node->child[i];
+    }
+    path[level] = node;
+    return node;
+}
+
+// Valid-page counts cover everything below a node
+static void radix_add_valid(RadixPageTable *rt, RadixNode **path, uint32_t level, int64_t delta)
+{
+    for (uint32_t l = level; l < rt->levels; l++) {
+        path[l]->valid += delta;
+    }
+}
+
+static PageTableEntry *radix_lookup(RadixPageTable *rt, uint64_t vpn)
+{
+    RadixNode *node = rt->root;
+    for (uint32_t l = rt->levels - 1; l > 0; l--) {
+        uint32_t i = radix_index(vpn, l);
+        if (radix_is_huge(node, i))
+            return &node->huge[i];
+        node = node->child[i];
+        if (!node)
+            return NULL;
+    }
+    return &node->pte[radix_index(vpn, 0)];
+}
+
+// Fully populated subtree mapping consecutive frames from first_frame
+static RadixNode *radix_build(RadixPageTable *rt, uint32_t level, uint32_t first_frame,
+                              uint32_t flags)
+{
+    RadixNode *node = radix_alloc_node(rt, level);
+    if (!node)
+        return NULL;
+
+    if (level == 0) {
+        for (uint32_t i = 0; i < PT_RADIX_FANOUT; i++) {
+            pte_set(&node->pte[i], first_frame + i, flags);
+        }
+        node->valid = PT_RADIX_FANOUT;
+        return node;
+    }
+
+    uint32_t span = 1u << (level * PT_RADIX_BITS);
+    for (uint32_t i = 0; i < PT_RADIX_FANOUT; i++) {
+        node->child[i] = radix_build(rt, level - 1, first_frame + i * span, flags);
+        if (!node->child[i]) {
+            radix_free_node(rt, node, level);
+            return NULL;
+        }
+        node->valid += node->child[i]->valid;
+    }
+    return node;
+}
+
+static uint64_t radix_huge_pages(const RadixPageTable *rt)
+{
+    return 1ULL << (rt->huge_level * PT_RADIX_BITS);
+}
+
+static bool radix_map_huge(RadixPageTable *rt, uint64_t vpn, uint32_t first_frame, uint32_t flags)
+{
+    RadixNode *path[PT_RADIX_MAX_LEVELS];
+    RadixNode *node = radix_descend(rt, vpn, rt->huge_level, true, path);
+    if (!node)
+        return false;
+
+    if (!node->huge) {
+        node->huge = calloc(PT_RADIX_FANOUT, sizeof(PageTableEntry));
+        if (!node->huge) {
+            LOG_ERROR_MSG("Failed to allocate huge-page entries");
+            return false;
+        }
+        rt->bytes += PT_RADIX_FANOUT * sizeof(PageTableEntry);
+    }
+
+    // The caller has moved whatever the subtree mapped
+    uint32_t i = radix_index(vpn, rt->huge_level);
+    uint64_t before = node->child[i] ? node->child[i]->valid : 0;
+    radix_free_node(rt, node->child[i], rt->huge_level - 1);
+    node->child[i] = NULL;
+    pte_set(&node->huge[i], first_frame, flags | PTE_VALID | PTE_HUGE);
+    radix_add_valid(rt, path, rt->huge_level, (int64_t)(radix_huge_pages(rt) - before));
+    return true;
+}
+
+static bool radix_split_huge(RadixPageTable *rt, uint64_t vpn)
+{
+    RadixNode *path[PT_RADIX_MAX_LEVELS];
+    RadixNode *node = radix_descend(rt, vpn, rt->huge_level, false, path);
+    uint32_t i = radix_index(vpn, rt->huge_level);
+    if (!node || !radix_is_huge(node, i))
+        return false;
+
+    RadixNode *child = radix_build(rt, rt->huge_level - 1, pte_frame(&node->huge[i]),
+                                   pte_flags(&node->huge[i]) & ~PTE_HUGE);
+    if (!child) {
+        LOG_ERROR_MSG("Failed to allocate page table nodes for huge page split");
+        return false;
+    }
+    node->child[i] = child;
+    memset(&node->huge[i], 0, sizeof(node->huge[i]));
+    return true;
+}
+
+static uint64_t radix_region_valid(RadixPageTable *rt, uint64_t vpn)
+{
+    RadixNode *path[PT_RADIX_MAX_LEVELS];
+    RadixNode *node = radix_descend(rt, vpn, rt->huge_level, false, path);
+    if (!node)
+        return 0;
+    uint32_t i = radix_index(vpn, rt->huge_level);
+    if (radix_is_huge(node, i))
+        return radix_huge_pages(rt);
+    return node->child[i] ? node->child[i]->valid : 0;
+}
+
+// ---- Hashed inverted table ----
+
+#define IPT_EMPTY 0
+#define IPT_USED 1
+#define IPT_TOMBSTONE 2
+#define IPT_MIN_CAPACITY 64
+
+InvertedTable *inverted_table_create(uint32_t num_frames)
+{
+    InvertedTable *ipt = calloc(1, sizeof(InvertedTable));
+    if (!ipt) {
+        LOG_ERROR_MSG("Failed to allocate inverted page table");
+        return NULL;
+    }
+
+    // Load factor at most one half while every frame is mapped
+    ipt->capacity = IPT_MIN_CAPACITY;
+    while (ipt->capacity < (uint64_t)num_frames * 2)
+        ipt->capacity <<= 1;
+    ipt->entries = calloc(ipt->capacity, sizeof(InvertedEntry));
+    if (!ipt->entries) {
+        LOG_ERROR_MSG("Failed to allocate inverted page table entries");
+        free(ipt);
+        return NULL;
+    }
+    ipt->stats.capacity = ipt->capacity;
+    LOG_INFO_MSG("Created inverted page table: %lu slots", ipt->capacity);
+    return ipt;
+}
+
+void inverted_table_destroy(InvertedTable *ipt)
+{
+    if (!ipt)
+        return;
+    free(ipt->entries);
+    free(ipt);
+}
+
+uint64_t inverted_table_memory_bytes(InvertedTable *ipt)
+{
+    return ipt ? sizeof(InvertedTable) + ipt->capacity * sizeof(InvertedEntry) : 0;
+}
+
+static InvertedEntry *ipt_find(InvertedTable *ipt, uint32_t pid, uint64_t vpn)
+{
+    uint64_t mask = ipt->capacity - 1;
+    uint64_t i = pagemap_hash(pid, vpn) & mask;
+    uint64_t probes = 1;
+    InvertedEntry *found = NULL;
+    for (;; i = (i + 1) & mask, probes++) {
+        InvertedEntry *e = &ipt->entries[i];
+        if (e->state == IPT_EMPTY)
+            break;
+        if (e->state == IPT_USED && e->vpn == vpn && e->pid == pid) {
+            found = e;
+            break;
+        }
+    }
+    ipt->last_probes = (uint32_t)probes;
+    ipt->stats.lookups++;
+    ipt->stats.probes += probes;
+    if (probes > ipt->stats.max_probe)
+        ipt->stats.max_probe = probes;
+    return found;
+}
+
+// Rehash live entries into a table of new_capacity slots, dropping tombstones
+static bool ipt_rebuild(InvertedTable *ipt, uint64_t new_capacity)
+{
+    InvertedEntry *entries = calloc(new_capacity, sizeof(InvertedEntry));
+    if (!entries) {
+        LOG_ERROR_MSG("Failed to rebuild inverted page table");
+        return false;
+    }
+    uint64_t mask = new_capacity - 1;
+    for (uint64_t i = 0; i < ipt->capacity; i++) {
+        InvertedEntry *e = &ipt->entries[i];
+        if (e->state != IPT_USED)
+            continue;
+        uint64_t j = pagemap_hash(e->pid, e->vpn) & mask;
+        while (entries[j].state != IPT_EMPTY)
+            j = (j + 1) & mask;
+        entries[j] = *e;
+    }
+    free(ipt->entries);
+    ipt->entries = entries;
+    ipt->capacity = new_capacity;
+    ipt->tombstones = 0;
+    ipt->stats.capacity = new_capacity;
+    ipt->stats.rebuilds++;
+    return true;
+}
+
+// Entry for (pid, vpn), inserting an empty one if absent. Only an insert can
+// rebuild the table, so pointers to existing entries stay valid across lookups,
+// updates and removals.
+static InvertedEntry *ipt_insert(InvertedTable *ipt, uint32_t pid, uint64_t vpn)
+{
+    InvertedEntry *e = ipt_find(ipt, pid, vpn);
+    if (e)
+        return e;
+
+    if ((ipt->count + ipt->tombstones + 1) * 4 > ipt->capacity * 3) {
+        uint64_t capacity = (ipt->count + 1) * 2 > ipt->capacity ? ipt->capacity * 2
+                                                                  : ipt->capacity;
+        if (!ipt_rebuild(ipt, capacity))
+            return NULL;
+    }
+
+    uint64_t mask = ipt->capacity - 1;
+    uint64_t home = pagemap_hash(pid, vpn) & mask;
+    uint64_t i = home;
+    while (ipt->entries[i].state == IPT_USED)
+        i = (i + 1) & mask;
+    e = &ipt->entries[i];
+    if (e->state == IPT_TOMBSTONE)
+        ipt->tombstones--;
+    memset(e, 0, sizeof(*e));
+    e->state = IPT_USED;
+    e->pid = pid;
+    e->vpn = vpn;
+    ipt->count++;
+    ipt->stats.entries = ipt->count;
+    ipt->stats.inserts++;
+    if (i != home)
+        ipt->stats.collisions++;
+    return e;
+}
+
+static void ipt_remove(InvertedTable *ipt, InvertedEntry *e)
+{
+    e->state = IPT_TOMBSTONE;
+    ipt->count--;
+    ipt->tombstones++;
+    ipt->stats.entries = ipt->count;
+}
+
+static void ipt_remove_pid(InvertedTable *ipt, uint32_t pid)
+{
+    for (uint64_t i = 0; i < ipt->capacity; i++) {
+        if (ipt->entries[i].state == IPT_USED && ipt->entries[i].pid == pid)
+            ipt_remove(ipt, &ipt->entries[i]);
+    }
+}
+
+// ---- Common interface ----
+
+const char *pagetable_type_name(PageTableType type)
+{
+    switch (type) {
+    case PT_SINGLE_LEVEL:
+        return "Single-level";
+    case PT_TWO_LEVEL:
+        return "Two-level";
+    case PT_RADIX_4:
+        return "4-level radix";
+    case PT_RADIX_5:
+        return "5-level radix";
+    case PT_INVERTED:
+        return "Inverted (hashed)";
+    default:
+        return "Unknown";
+    }
+}
+
+uint64_t pagetable_max_address_space(PageTableType type, uint32_t page_size)
+{
+    if (type == PT_INVERTED)
+        return UINT64_MAX; // Size depends only on the pages in use
+    if (type != PT_RADIX_4 && type != PT_RADIX_5)
+        return 0;
+
+    uint32_t page_bits = 0;
+    while ((1u << page_bits) < page_size)
+        page_bits++;
+    uint32_t bits = (type == PT_RADIX_5 ? 5 : 4) * PT_RADIX_BITS + page_bits;
+    return bits >= 64 ? UINT64_MAX : 1ULL << bits;
+}
 
 PageTable *pagetable_create(uint32_t pid, PageTableType type, uint64_t address_space_size,
-                             uint32_t page_size)
+                             uint32_t page_size, uint64_t huge_page_size)
 {
     if (!is_power_of_two(page_size)) {
         LOG_ERROR_MSG("Page size must be power of 2");
         return NULL;
     }
+    if (huge_page_size && (huge_page_size <= page_size || huge_page_size & (huge_page_size - 1))) {
+        LOG_ERROR_MSG("Huge page size must be a power of 2 larger than the page size");
+        return NULL;
+    }
 
     PageTable *pt = calloc(1, sizeof(PageTable));
     if (!pt) {
@@ -21,12 +394,18 @@ PageTable *pagetable_create(uint32_t pid, PageTableType type, uint64_t address_s
         return NULL;
     }
 
+    if (type == PT_INVERTED) {
+        LOG_ERROR_MSG("Inverted page tables are created with pagetable_create_inverted");
+        free(pt);
+        return NULL;
+    }
+
     pt->type = type;
     pt->pid = pid;
     pt->page_size = page_size;
     pt->address_space_size = address_space_size;
 
-    uint32_t total_pages = address_space_size / page_size;
+    uint64_t total_pages = address_space_size / page_size;
 
     if (type == PT_SINGLE_LEVEL) {
         pt->table.single.num_pages = total_pages;
@@ -36,14 +415,56 @@ PageTable *pagetable_create(uint32_t pid, PageTableType type, uint64_t address_s
             free(pt);
             return NULL;
         }
-        LOG_INFO_MSG("Created single-level page table for PID %u: %u pages", pid, total_pages);
+        LOG_INFO_MSG("Created single-level page table for PID %u: %lu pages", pid, total_pages);
+    } else if (type == PT_RADIX_4 || type == PT_RADIX_5) {
+        RadixPageTable *rt = &pt->table.radix;
+        rt->levels = type == PT_RADIX_5 ? 5 : 4;
+        if (address_space_size > pagetable_max_address_space(type, page_size)) {
+            LOG_ERROR_MSG("Address space too large for a %u-level page table", rt->levels);
+            free(pt);
+            return NULL;
+        }
+
+        // Huge leaves sit huge_level levels above the PTEs
+        if (huge_page_size) {
+            while (rt->huge_level < rt->levels - 1 &&
+                   ((uint64_t)page_size << (rt->huge_level * PT_RADIX_BITS)) < huge_page_size)
+                rt->huge_level++;
+            if (((uint64_t)page_size << (rt->huge_level * PT_RADIX_BITS)) != huge_page_size) {
+                LOG_ERROR_MSG("Radix huge pages must be the page size times a power of %u",
+                              PT_RADIX_FANOUT);
+                free(pt);
+                return NULL;
+            }
+        }
+
+        // Only the root exists up front; everything below is allocated on first map
+        rt->root = radix_alloc_node(rt, rt->levels - 1);
+        if (!rt->root) {
+            free(pt);
+            return NULL;
+        }
+        LOG_INFO_MSG("Created %u-level radix page table for PID %u", rt->levels, pid);
     } else {
         // Two-level page table
-        // L1: 10 bits (1024 entries), L2: remaining bits
-        pt->table.two_level.l1_entries = 1024;
-        pt->table.two_level.l2_entries = (total_pages + 1023) / 1024;
+        // L2: 10 bits (1024 entries), or one huge page worth; L1: remaining bits
+        uint32_t l2_bits = 10;
+        if (huge_page_size) {
+            l2_bits = 0;
+            while (((uint64_t)page_size << l2_bits) < huge_page_size)
+                l2_bits++;
+        }
+        pt->table.two_level.l2_bits = l2_bits;
+        pt->table.two_level.l2_entries = 1u << l2_bits;
+        uint64_t l1_entries = (total_pages + (1u << l2_bits) - 1) >> l2_bits;
+        if (l1_entries > UINT32_MAX) {
+            LOG_ERROR_MSG("Address space too large for a two-level page table");
+            free(pt);
+            return NULL;
+        }
+        pt->table.two_level.l1_entries = (uint32_t)l1_entries;
 
-        pt->table.two_level.l1_table = calloc(pt->table.two_level.l1_entries, sizeof(PageTableEntry *));
+        pt->table.two_level.l1_table = calloc(l1_entries, sizeof(PageDirEntry));
         if (!pt->table.two_level.l1_table) {
             LOG_ERROR_MSG("Failed to allocate two-level L1 table");
             free(pt);
@@ -57,25 +478,124 @@ PageTable *pagetable_create(uint32_t pid, PageTableType type, uint64_t address_s
     return pt;
 }
 
+PageTable *pagetable_create_inverted(uint32_t pid, InvertedTable *ipt,
+                                     uint64_t address_space_size, uint32_t page_size)
+{
+    if (!ipt || !is_power_of_two(page_size)) {
+        LOG_ERROR_MSG("Inverted page table needs a shared table and a power-of-2 page size");
+        return NULL;
+    }
+
+    PageTable *pt = calloc(1, sizeof(PageTable));
+    if (!pt) {
+        LOG_ERROR_MSG("Failed to allocate page table");
+        return NULL;
+    }
+    pt->type = PT_INVERTED;
+    pt->pid = pid;
+    pt->page_size = page_size;
+    pt->address_space_size = address_space_size;
+    pt->table.inverted = ipt;
+    LOG_INFO_MSG("Attached PID %u to the inverted page table", pid);
+    return pt;
+}
+
+// ---- Reserved flat tables ----
+
+static size_t reserved_bytes(const SingleLevelPageTable *st)
+{
+    size_t host_page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t bytes = st->num_pages * sizeof(PageTableEntry);
+    return (bytes + host_page - 1) & ~(host_page - 1);
+}
+
+// Bytes of the reservation the host has actually committed
+static uint64_t reserved_committed_bytes(const SingleLevelPageTable *st)
+{
+    size_t host_page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t pages = reserved_bytes(st) / host_page;
+    unsigned char vec[4096];
+    uint64_t resident = 0;
+
+    for (size_t first = 0; first < pages; first += sizeof(vec)) {
+        size_t n = pages - first < sizeof(vec) ? pages - first : sizeof(vec);
+        if (mincore((char *)st->ptes + first * host_page, n * host_page, vec) != 0)
+            return (uint64_t)pages * host_page; // Unknown: assume all of it
+        for (size_t i = 0; i < n; i++)
+            resident += vec[i] & 1;
+    }
+    return resident * host_page;
+}
+
+PageTable *pagetable_create_reserved(uint32_t pid, uint64_t address_space_size,
+                                     uint32_t page_size)
+{
+    if (!is_power_of_two(page_size)) {
+        LOG_ERROR_MSG("Page size must be power of 2");
+        return NULL;
+    }
+
+    PageTable *pt = calloc(1, sizeof(PageTable));
+    if (!pt) {
+        LOG_ERROR_MSG("Failed to allocate page table");
+        return NULL;
+    }
+    pt->type = PT_SINGLE_LEVEL;
+    pt->pid = pid;
+    pt->page_size = page_size;
+    pt->address_space_size = address_space_size;
+
+    // Anonymous pages read as zero, so the reservation starts out all invalid
+    SingleLevelPageTable *st = &pt->table.single;
+    st->num_pages = address_space_size / page_size;
+    st->reserved = true;
+    void *ptes = mmap(NULL, reserved_bytes(st), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptes == MAP_FAILED) {
+        LOG_ERROR_MSG("Failed to reserve %lu page table entries", st->num_pages);
+        free(pt);
+        return NULL;
+    }
+    st->ptes = ptes;
+    LOG_INFO_MSG("Reserved single-level page table for PID %u: %lu pages", pid, st->num_pages);
+    return pt;
+}
+
 void pagetable_destroy(PageTable *pt)
 {
     if (!pt)
         return;
 
-    if (pt->type == PT_SINGLE_LEVEL) {
-        free(pt->table.single.ptes);
+    if (pt->type == PT_INVERTED) {
+        // Drop this process's entries; the shared table outlives it
+        ipt_remove_pid(pt->table.inverted, pt->pid);
+    } else if (pt->type == PT_SINGLE_LEVEL) {
+        if (pt->table.single.reserved)
+            munmap(pt->table.single.ptes, reserved_bytes(&pt->table.single));
+        else
+            free(pt->table.single.ptes);
+    } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+        radix_free_node(&pt->table.radix, pt->table.radix.root, pt->table.radix.levels - 1);
     } else {
         // Free all allocated L2 tables
         for (uint32_t i = 0; i < pt->table.two_level.l1_entries; i++) {
-            if (pt->table.two_level.l1_table[i]) {
-                free(pt->table.two_level.l1_table[i]);
-            }
+            free(pt->table.two_level.l1_table[i].l2);
         }
         free(pt->table.two_level.l1_table);
     }
     free(pt);
 }
 
+// L1 entry covering vpn, or NULL if out of range
+static PageDirEntry *two_level_dir(PageTable *pt, uint64_t vpn)
+{
+    uint64_t l1_index = vpn >> pt->table.two_level.l2_bits;
+    if (l1_index >= pt->table.two_level.l1_entries) {
+        return NULL;
+    }
+    return &pt->table.two_level.l1_table[l1_index];
+}
+
 PageTableEntry *pagetable_lookup(PageTable *pt, uint64_t virtual_addr)
 {
     if (!pt)
@@ -88,21 +608,30 @@ PageTableEntry *pagetable_lookup(PageTable *pt, uint64_t virtual_addr)
             return NULL; // Out of bounds
         }
         return &pt->table.single.ptes[vpn];
+    } else if (pt->type == PT_INVERTED) {
+        InvertedEntry *e = ipt_find(pt->table.inverted, pt->pid, vpn);
+        return e ? &e->pte : NULL;
+    } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+        if (virtual_addr >= pt->address_space_size) {
+            return NULL;
+        }
+        return radix_lookup(&pt->table.radix, vpn);
     } else {
         // Two-level lookup
-        uint32_t l1_index = (vpn >> 10) & 0x3FF; // Top 10 bits
-        uint32_t l2_index = vpn & 0x3FF;          // Bottom 10 bits
-
-        if (l1_index >= pt->table.two_level.l1_entries) {
+        PageDirEntry *dir = two_level_dir(pt, vpn);
+        if (!dir) {
             return NULL;
         }
+        if (pte_flags(&dir->huge) & PTE_HUGE) {
+            return &dir->huge;
+        }
 
         // Check if L2 table exists
-        if (!pt->table.two_level.l1_table[l1_index]) {
+        if (!dir->l2) {
             return NULL; // L2 table not allocated
         }
 
-        return &pt->table.two_level.l1_table[l1_index][l2_index];
+        return &dir->l2[vpn & (pt->table.two_level.l2_entries - 1)];
     }
 }
 
@@ -117,30 +646,51 @@ bool pagetable_map(PageTable *pt, uint64_t virtual_addr, uint32_t frame_number,
         if (vpn >= pt->table.single.num_pages) {
             return false;
         }
-        pt->table.single.ptes[vpn].frame_number = frame_number;
-        pt->table.single.ptes[vpn].flags = flags | PTE_VALID;
+        pte_set(&pt->table.single.ptes[vpn], frame_number, flags | PTE_VALID);
+        return true;
+    } else if (pt->type == PT_INVERTED) {
+        InvertedEntry *e = ipt_insert(pt->table.inverted, pt->pid, vpn);
+        if (!e) {
+            return false;
+        }
+        pte_set(&e->pte, frame_number, flags | PTE_VALID);
+        return true;
+    } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+        if (virtual_addr >= pt->address_space_size) {
+            return false;
+        }
+        RadixNode *path[PT_RADIX_MAX_LEVELS];
+        RadixNode *leaf = radix_descend(&pt->table.radix, vpn, 0, true, path);
+        if (!leaf) {
+            return false;
+        }
+        PageTableEntry *pte = &leaf->pte[radix_index(vpn, 0)];
+        if (!pte_is_valid(pte)) {
+            radix_add_valid(&pt->table.radix, path, 0, 1);
+        }
+        pte_set(pte, frame_number, flags | PTE_VALID);
         return true;
     } else {
         // Two-level mapping
-        uint32_t l1_index = (vpn >> 10) & 0x3FF;
-        uint32_t l2_index = vpn & 0x3FF;
-
-        if (l1_index >= pt->table.two_level.l1_entries) {
+        PageDirEntry *dir = two_level_dir(pt, vpn);
+        if (!dir || (pte_flags(&dir->huge) & PTE_HUGE)) {
             return false;
         }
 
         // Allocate L2 table if needed
-        if (!pt->table.two_level.l1_table[l1_index]) {
-            pt->table.two_level.l1_table[l1_index] =
-                calloc(pt->table.two_level.l2_entries, sizeof(PageTableEntry));
-            if (!pt->table.two_level.l1_table[l1_index]) {
+        if (!dir->l2) {
+            dir->l2 = calloc(pt->table.two_level.l2_entries, sizeof(PageTableEntry));
+            if (!dir->l2) {
                 LOG_ERROR_MSG("Failed to allocate L2 table");
                 return false;
             }
         }
 
-        pt->table.two_level.l1_table[l1_index][l2_index].frame_number = frame_number;
-        pt->table.two_level.l1_table[l1_index][l2_index].flags = flags | PTE_VALID;
+        PageTableEntry *pte = &dir->l2[vpn & (pt->table.two_level.l2_entries - 1)];
+        if (!pte_is_valid(pte)) {
+            dir->valid++;
+        }
+        pte_set(pte, frame_number, flags | PTE_VALID);
         return true;
     }
 }
@@ -151,60 +701,93 @@ bool pagetable_unmap(PageTable *pt, uint64_t virtual_addr)
     if (!pte)
         return false;
 
-    pte->flags &= ~PTE_VALID;
+    // Inverted entries only outlive residency for pages with a swap copy
+    if (pt->type == PT_INVERTED && !(pte_flags(pte) & PTE_SWAPPED)) {
+        ipt_remove(pt->table.inverted,
+                   (InvertedEntry *)((char *)pte - offsetof(InvertedEntry, pte)));
+        return true;
+    }
+
+    if (pte_is_valid(pte)) {
+        if (pte_flags(pte) & PTE_HUGE) {
+            return false; // Split first
+        }
+        if (pt->type == PT_TWO_LEVEL) {
+            two_level_dir(pt, virtual_addr / pt->page_size)->valid--;
+        } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+            RadixNode *path[PT_RADIX_MAX_LEVELS];
+            radix_descend(&pt->table.radix, virtual_addr / pt->page_size, 0, false, path);
+            radix_add_valid(&pt->table.radix, path, 0, -1);
+        }
+    }
+    pte_clear_flags(pte, PTE_VALID);
     return true;
 }
 
-bool pte_is_valid(PageTableEntry *pte)
+bool pagetable_map_huge(PageTable *pt, uint64_t virtual_addr, uint32_t first_frame,
+                        uint32_t flags)
 {
-    return pte && (pte->flags & PTE_VALID);
-}
+    if (!pt || pt->type == PT_SINGLE_LEVEL || pt->type == PT_INVERTED)
+        return false;
+    if (pt->type != PT_TWO_LEVEL) {
+        return pt->table.radix.huge_level > 0 &&
+               radix_map_huge(&pt->table.radix, virtual_addr / pt->page_size, first_frame, flags);
+    }
 
-bool pte_is_dirty(PageTableEntry *pte)
-{
-    return pte && (pte->flags & PTE_DIRTY);
-}
+    PageDirEntry *dir = two_level_dir(pt, virtual_addr / pt->page_size);
+    if (!dir)
+        return false;
 
-bool pte_is_accessed(PageTableEntry *pte)
-{
-    return pte && (pte->flags & PTE_ACCESSED);
+    // The caller has moved whatever the L2 table mapped
+    free(dir->l2);
+    dir->l2 = NULL;
+    dir->valid = 0;
+    pte_set(&dir->huge, first_frame, flags | PTE_VALID | PTE_HUGE);
+    return true;
 }
 
-void pte_set_frame(PageTableEntry *pte, uint32_t frame_number)
+bool pagetable_split_huge(PageTable *pt, uint64_t virtual_addr)
 {
-    if (pte) {
-        pte->frame_number = frame_number;
+    if (!pt || pt->type == PT_SINGLE_LEVEL || pt->type == PT_INVERTED)
+        return false;
+    if (pt->type != PT_TWO_LEVEL) {
+        return pt->table.radix.huge_level > 0 &&
+               radix_split_huge(&pt->table.radix, virtual_addr / pt->page_size);
     }
-}
 
-void pte_set_valid(PageTableEntry *pte, bool valid)
-{
-    if (pte) {
-        if (valid)
-            pte->flags |= PTE_VALID;
-        else
-            pte->flags &= ~PTE_VALID;
-    }
-}
+    PageDirEntry *dir = two_level_dir(pt, virtual_addr / pt->page_size);
+    if (!dir || !(pte_flags(&dir->huge) & PTE_HUGE))
+        return false;
 
-void pte_set_dirty(PageTableEntry *pte, bool dirty)
-{
-    if (pte) {
-        if (dirty)
-            pte->flags |= PTE_DIRTY;
-        else
-            pte->flags &= ~PTE_DIRTY;
+    uint32_t entries = pt->table.two_level.l2_entries;
+    PageTableEntry *l2 = calloc(entries, sizeof(PageTableEntry));
+    if (!l2) {
+        LOG_ERROR_MSG("Failed to allocate L2 table for huge page split");
+        return false;
+    }
+    for (uint32_t i = 0; i < entries; i++) {
+        pte_set(&l2[i], pte_frame(&dir->huge) + i, pte_flags(&dir->huge) & ~PTE_HUGE);
     }
+    dir->l2 = l2;
+    dir->valid = entries;
+    memset(&dir->huge, 0, sizeof(dir->huge));
+    return true;
 }
 
-void pte_set_accessed(PageTableEntry *pte, bool accessed)
+uint32_t pagetable_region_valid(PageTable *pt, uint64_t virtual_addr)
 {
-    if (pte) {
-        if (accessed)
-            pte->flags |= PTE_ACCESSED;
-        else
-            pte->flags &= ~PTE_ACCESSED;
+    if (!pt || pt->type == PT_SINGLE_LEVEL || pt->type == PT_INVERTED)
+        return 0;
+    if (pt->type != PT_TWO_LEVEL) {
+        if (pt->table.radix.huge_level == 0)
+            return 0;
+        return (uint32_t)radix_region_valid(&pt->table.radix, virtual_addr / pt->page_size);
     }
+
+    PageDirEntry *dir = two_level_dir(pt, virtual_addr / pt->page_size);
+    if (!dir)
+        return 0;
+    return (pte_flags(&dir->huge) & PTE_HUGE) ? pt->table.two_level.l2_entries : dir->valid;
 }
 
 uint32_t pagetable_count_valid_pages(PageTable *pt)
@@ -215,23 +798,82 @@ uint32_t pagetable_count_valid_pages(PageTable *pt)
     uint32_t count = 0;
 
     if (pt->type == PT_SINGLE_LEVEL) {
-        for (uint32_t i = 0; i < pt->table.single.num_pages; i++) {
+        for (uint64_t i = 0; i < pt->table.single.num_pages; i++) {
             if (pte_is_valid(&pt->table.single.ptes[i])) {
                 count++;
             }
         }
+    } else if (pt->type == PT_INVERTED) {
+        InvertedTable *ipt = pt->table.inverted;
+        for (uint64_t i = 0; i < ipt->capacity; i++) {
+            const InvertedEntry *e = &ipt->entries[i];
+            if (e->state == IPT_USED && e->pid == pt->pid && pte_is_valid(&e->pte))
+                count++;
+        }
+    } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+        count = (uint32_t)pt->table.radix.root->valid;
     } else {
         for (uint32_t i = 0; i < pt->table.two_level.l1_entries; i++) {
-            if (pt->table.two_level.l1_table[i]) {
-                for (uint32_t j = 0; j < pt->table.two_level.l2_entries; j++) {
-                    if (pte_is_valid(&pt->table.two_level.l1_table[i][j])) {
-                        count++;
-                    }
-                }
-            }
+            count += pagetable_region_valid(pt, ((uint64_t)i << pt->table.two_level.l2_bits) *
+                                                    pt->page_size);
         }
     }
 
     return count;
 }
 
+uint32_t pagetable_get_levels(PageTable *pt)
+{
+    if (!pt)
+        return 0;
+    if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5)
+        return pt->table.radix.levels;
+    return pt->type == PT_TWO_LEVEL ? 2 : 1;
+}
+
+uint32_t pagetable_walk_levels(PageTable *pt, const PageTableEntry *leaf)
+{
+    if (pt && pt->type == PT_INVERTED)
+        return pt->table.inverted->last_probes;
+    uint32_t levels = pagetable_get_levels(pt);
+    if (leaf && (pte_flags(leaf) & PTE_HUGE)) {
+        levels -= pt->type == PT_TWO_LEVEL ? 1 : pt->table.radix.huge_level;
+    }
+    return levels;
+}
+
+uint32_t pagetable_level_shift(PageTable *pt, uint32_t level)
+{
+    if (!pt || level == 0)
+        return 0;
+    if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5)
+        return level * PT_RADIX_BITS;
+    return pt->type == PT_TWO_LEVEL ? pt->table.two_level.l2_bits : 0;
+}
+
+uint64_t pagetable_memory_bytes(PageTable *pt)
+{
+    if (!pt)
+        return 0;
+
+    // The shared inverted table is counted once by its owner
+    uint64_t bytes = sizeof(PageTable);
+    if (pt->type == PT_INVERTED) {
+        return bytes;
+    } else if (pt->type == PT_SINGLE_LEVEL) {
+        if (pt->table.single.reserved)
+            bytes += reserved_committed_bytes(&pt->table.single);
+        else
+            bytes += pt->table.single.num_pages * sizeof(PageTableEntry);
+    } else if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+        bytes += pt->table.radix.bytes;
+    } else {
+        TwoLevelPageTable *tl = &pt->table.two_level;
+        bytes += (uint64_t)tl->l1_entries * sizeof(PageDirEntry);
+        for (uint32_t i = 0; i < tl->l1_entries; i++) {
+            if (tl->l1_table[i].l2)
+                bytes += (uint64_t)tl->l2_entries * sizeof(PageTableEntry);
+        }
+    }
+    return bytes;
+}
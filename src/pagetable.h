@@ -1,8 +1,11 @@
 /**
  * pagetable.h - Page table management
  * 
- * Supports both single-level and two-level page tables.
+ * Supports single-level, two-level and sparse N-level radix page tables
+ * (4-level x86-64 and 5-level LA57 layouts, 9 index bits per level), and a
+ * hashed inverted table shared by all processes.
  * Provides virtual-to-physical address translation and page table entry management.
+ * Multi-level tables can map a whole region with one huge-page leaf at an upper level.
  */
 
 #ifndef PAGETABLE_H
@@ -10,6 +13,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "metrics.h"
 
 // Page table entry flags
 #define PTE_VALID (1 << 0)    // Page is in physical memory
@@ -17,30 +21,90 @@
 #define PTE_ACCESSED (1 << 2) // Page has been accessed
 #define PTE_WRITE (1 << 3)    // Page is writable
 #define PTE_USER (1 << 4)     // User-mode accessible
+#define PTE_SWAPPED (1 << 5)  // Payload holds the page's swap slot
+#define PTE_HUGE (1 << 6)     // L1 leaf mapping a whole huge page
 
-// Page table entry (for both single and two-level)
+// Flags take the low bits of an entry, like a hardware PTE
+#define PTE_FLAG_BITS 12
+#define PTE_FLAG_MASK ((1ULL << PTE_FLAG_BITS) - 1)
+
+// Page table entry, packed into 64 bits: PTE_* flags in the low PTE_FLAG_BITS,
+// and above them the frame number while the page is present or its swap slot
+// once it has been swapped out. Use the pte_* accessors, never raw.
 typedef struct {
-    uint32_t frame_number; // Physical frame number (or swap offset if not valid)
-    uint32_t flags;        // PTE_* flags
-    uint64_t swap_offset;  // Offset in swap file if paged out
+    uint64_t raw;
 } PageTableEntry;
 
 // Page table types
-typedef enum { PT_SINGLE_LEVEL, PT_TWO_LEVEL } PageTableType;
+typedef enum { PT_SINGLE_LEVEL, PT_TWO_LEVEL, PT_RADIX_4, PT_RADIX_5, PT_INVERTED } PageTableType;
+
+// Radix layout: 512-entry nodes, like x86-64 paging structures
+#define PT_RADIX_BITS 9
+#define PT_RADIX_FANOUT (1u << PT_RADIX_BITS)
+#define PT_RADIX_MAX_LEVELS 5
 
 // Single-level page table
 typedef struct {
-    uint32_t num_pages;  // Total virtual pages
+    uint64_t num_pages;  // Total virtual pages
     PageTableEntry *ptes; // Array of PTEs
+    bool reserved;        // ptes is an mmap(MAP_NORESERVE) reservation, committed on touch
 } SingleLevelPageTable;
 
+// L1 entry: either a pointer to an L2 table or a huge-page leaf
+typedef struct {
+    PageTableEntry *l2;  // L2 table (NULL if not allocated or mapped huge)
+    PageTableEntry huge; // Leaf entry when huge.flags has PTE_HUGE
+    uint32_t valid;      // Valid entries in l2
+} PageDirEntry;
+
 // Two-level page table
 typedef struct {
     uint32_t l1_entries;      // Number of L1 entries
-    uint32_t l2_entries;      // Number of L2 entries per L1 entry
-    PageTableEntry **l1_table; // L1 table (array of pointers to L2 tables)
+    uint32_t l2_entries;      // Number of L2 entries per L1 entry (power of two)
+    uint32_t l2_bits;         // log2(l2_entries)
+    PageDirEntry *l1_table;   // L1 table
 } TwoLevelPageTable;
 
+// Radix node. Level 0 nodes hold PTEs, upper levels hold child pointers; each is
+// allocated with only the array its level uses.
+typedef struct RadixNode {
+    uint64_t valid;       // Valid base pages mapped below this node
+    PageTableEntry *huge; // Huge-page leaves per slot (huge level only, lazily allocated)
+    union {
+        struct RadixNode *child[PT_RADIX_FANOUT];
+        PageTableEntry pte[PT_RADIX_FANOUT];
+    };
+} RadixNode;
+
+// N-level radix page table, allocated lazily as addresses are mapped
+typedef struct {
+    uint32_t levels;                        // 4 or 5
+    uint32_t huge_level;                    // Level holding huge-page leaves (0 = none)
+    RadixNode *root;                        // Level levels - 1
+    uint64_t nodes[PT_RADIX_MAX_LEVELS];    // Nodes allocated per level
+    uint64_t bytes;                         // Memory held by nodes and huge-leaf arrays
+} RadixPageTable;
+
+// Inverted table slot: 24 bytes
+typedef struct {
+    uint64_t vpn;
+    uint32_t pid;
+    uint32_t state; // IPT_EMPTY, IPT_USED or IPT_TOMBSTONE
+    PageTableEntry pte;
+} InvertedEntry;
+
+// Hashed inverted page table: one entry per resident or swapped page of any
+// process, open addressing with linear probing. Deletions leave tombstones so
+// entries never move, except when inserting a new key rebuilds the table.
+typedef struct {
+    InvertedEntry *entries;
+    uint64_t capacity;   // Power of two
+    uint64_t count;      // Live entries
+    uint64_t tombstones;
+    uint32_t last_probes; // Slots examined by the latest lookup
+    InvertedTableMetrics stats;
+} InvertedTable;
+
 // Generic page table structure
 typedef struct {
     PageTableType type;
@@ -50,30 +114,155 @@ typedef struct {
     union {
         SingleLevelPageTable single;
         TwoLevelPageTable two_level;
+        RadixPageTable radix;
+        InvertedTable *inverted; // Shared, owned by the caller
     } table;
 } PageTable;
 
-// Page table creation and destruction
+// Page table creation and destruction. A nonzero huge_page_size sizes the
+// two-level split so one L1 entry covers exactly one huge page; radix tables
+// need it to be the page size times a power of 512.
 PageTable *pagetable_create(uint32_t pid, PageTableType type, uint64_t address_space_size,
-                             uint32_t page_size);
+                             uint32_t page_size, uint64_t huge_page_size);
 void pagetable_destroy(PageTable *pt);
 
-// Address translation
+// Inverted tables: one InvertedTable serves every process's PageTable
+InvertedTable *inverted_table_create(uint32_t num_frames);
+void inverted_table_destroy(InvertedTable *ipt);
+uint64_t inverted_table_memory_bytes(InvertedTable *ipt);
+// Flat table whose PTE array is reserved address space: host memory is only
+// committed for the pages of entries actually written
+PageTable *pagetable_create_reserved(uint32_t pid, uint64_t address_space_size,
+                                     uint32_t page_size);
+
+PageTable *pagetable_create_inverted(uint32_t pid, InvertedTable *ipt,
+                                     uint64_t address_space_size, uint32_t page_size);
+
+// Address translation. Lookup returns the leaf entry, which is the huge-page
+// entry for addresses inside a huge mapping, or NULL when no L2 table exists.
 PageTableEntry *pagetable_lookup(PageTable *pt, uint64_t virtual_addr);
 bool pagetable_map(PageTable *pt, uint64_t virtual_addr, uint32_t frame_number, uint32_t flags);
 bool pagetable_unmap(PageTable *pt, uint64_t virtual_addr);
 
-// PTE manipulation
-bool pte_is_valid(PageTableEntry *pte);
-bool pte_is_dirty(PageTableEntry *pte);
-bool pte_is_accessed(PageTableEntry *pte);
-void pte_set_frame(PageTableEntry *pte, uint32_t frame_number);
-void pte_set_valid(PageTableEntry *pte, bool valid);
-void pte_set_dirty(PageTableEntry *pte, bool dirty);
-void pte_set_accessed(PageTableEntry *pte, bool accessed);
+// Huge pages (multi-level tables only). map_huge replaces the region's L2 table with a
+// leaf for frames first_frame.. first_frame + pages - 1; split turns it back
+// into an L2 table of base-page entries for the same frames.
+bool pagetable_map_huge(PageTable *pt, uint64_t virtual_addr, uint32_t first_frame,
+                        uint32_t flags);
+bool pagetable_split_huge(PageTable *pt, uint64_t virtual_addr);
+uint32_t pagetable_region_valid(PageTable *pt, uint64_t virtual_addr);
+
+// PTE manipulation. Walks read entries on every access, so these stay inline.
+static inline uint32_t pte_flags(const PageTableEntry *pte)
+{
+    return (uint32_t)(pte->raw & PTE_FLAG_MASK);
+}
+
+static inline uint32_t pte_frame(const PageTableEntry *pte)
+{
+    return (uint32_t)(pte->raw >> PTE_FLAG_BITS);
+}
+
+static inline uint64_t pte_swap_slot(const PageTableEntry *pte)
+{
+    return pte->raw >> PTE_FLAG_BITS;
+}
+
+static inline void pte_set(PageTableEntry *pte, uint32_t frame_number, uint32_t flags)
+{
+    pte->raw = ((uint64_t)frame_number << PTE_FLAG_BITS) | (flags & PTE_FLAG_MASK);
+}
+
+static inline void pte_set_flags(PageTableEntry *pte, uint32_t flags)
+{
+    pte->raw |= flags & PTE_FLAG_MASK;
+}
+
+static inline void pte_clear_flags(PageTableEntry *pte, uint32_t flags)
+{
+    pte->raw &= ~(uint64_t)(flags & PTE_FLAG_MASK);
+}
+
+// Swap slot replaces the frame number; the caller unmaps the page next
+static inline void pte_set_swap_slot(PageTableEntry *pte, uint64_t slot)
+{
+    pte->raw = (slot << PTE_FLAG_BITS) | (pte->raw & PTE_FLAG_MASK) | PTE_SWAPPED;
+}
+
+static inline void pte_clear_swap_slot(PageTableEntry *pte)
+{
+    pte->raw &= PTE_FLAG_MASK & ~(uint64_t)PTE_SWAPPED;
+}
+
+static inline bool pte_is_valid(const PageTableEntry *pte)
+{
+    return pte && (pte->raw & PTE_VALID);
+}
+
+static inline bool pte_is_dirty(const PageTableEntry *pte)
+{
+    return pte && (pte->raw & PTE_DIRTY);
+}
+
+static inline bool pte_is_accessed(const PageTableEntry *pte)
+{
+    return pte && (pte->raw & PTE_ACCESSED);
+}
+
+static inline void pte_set_frame(PageTableEntry *pte, uint32_t frame_number)
+{
+    if (pte)
+        pte_set(pte, frame_number, pte_flags(pte));
+}
+
+static inline void pte_set_valid(PageTableEntry *pte, bool valid)
+{
+    if (pte) {
+        if (valid)
+            pte_set_flags(pte, PTE_VALID);
+        else
+            pte_clear_flags(pte, PTE_VALID);
+    }
+}
+
+static inline void pte_set_dirty(PageTableEntry *pte, bool dirty)
+{
+    if (pte) {
+        if (dirty)
+            pte_set_flags(pte, PTE_DIRTY);
+        else
+            pte_clear_flags(pte, PTE_DIRTY);
+    }
+}
+
+static inline void pte_set_accessed(PageTableEntry *pte, bool accessed)
+{
+    if (pte) {
+        if (accessed)
+            pte_set_flags(pte, PTE_ACCESSED);
+        else
+            pte_clear_flags(pte, PTE_ACCESSED);
+    }
+}
 
 // Statistics
 uint32_t pagetable_count_valid_pages(PageTable *pt);
 
+// Memory references needed by a full walk (used for timing)
+uint32_t pagetable_get_levels(PageTable *pt);
+// References for a walk that ends at leaf (shorter for huge-page leaves). For
+// inverted tables, the slots probed by the latest lookup.
+uint32_t pagetable_walk_levels(PageTable *pt, const PageTableEntry *leaf);
+// Shift that turns a vpn into the index of its entry's span at level (leaf = 0)
+uint32_t pagetable_level_shift(PageTable *pt, uint32_t level);
+
+// Address space a layout can translate (0 = limited only by the configuration)
+uint64_t pagetable_max_address_space(PageTableType type, uint32_t page_size);
+
+// Host memory held by the table's structures
+uint64_t pagetable_memory_bytes(PageTable *pt);
+
+const char *pagetable_type_name(PageTableType type);
+
 #endif // PAGETABLE_H
 
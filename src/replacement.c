@@ -9,6 +9,9 @@
 #include <string.h>
 #include <limits.h>
 
+// LIRS frames kept for resident HIR pages (at least one), as in the LIRS paper
+#define LIRS_HIR_PERCENT 1
+
 ReplacementPolicy *replacement_create(ReplacementAlgorithm algo, uint32_t num_frames)
 {
     ReplacementPolicy *policy = calloc(1, sizeof(ReplacementPolicy));
@@ -18,6 +21,7 @@ ReplacementPolicy *replacement_create(ReplacementAlgorithm algo, uint32_t num_fr
     }
 
     policy->algorithm = algo;
+    policy->num_frames = num_frames;
 
     // Initialize algorithm-specific state
     if (algo == REPLACE_FIFO) {
@@ -30,8 +34,115 @@ ReplacementPolicy *replacement_create(ReplacementAlgorithm algo, uint32_t num_fr
         policy->fifo_size = 0;
         policy->fifo_head = 0;
         policy->fifo_tail = 0;
+        policy->fifo_capacity = num_frames;
+    } else if (algo == REPLACE_LRU) {
+        policy->lru_prev = malloc((num_frames + 1) * sizeof(uint32_t));
+        policy->lru_next = malloc((num_frames + 1) * sizeof(uint32_t));
+        if (!policy->lru_prev || !policy->lru_next) {
+            LOG_ERROR_MSG("Failed to allocate LRU list");
+            replacement_destroy(policy);
+            return NULL;
+        }
+        memset(policy->lru_next, 0xff, num_frames * sizeof(uint32_t));
+        policy->lru_head = num_frames;
+        policy->lru_prev[num_frames] = num_frames;
+        policy->lru_next[num_frames] = num_frames;
     } else if (algo == REPLACE_CLOCK) {
         policy->clock_hand = 0;
+    } else if (algo == REPLACE_OPT || algo == REPLACE_APPROX_LRU) {
+        policy->heap_key = malloc(num_frames * sizeof(uint64_t));
+        policy->heap = malloc(num_frames * sizeof(uint32_t));
+        policy->heap_pos = malloc(num_frames * sizeof(uint32_t));
+        if (!policy->heap_key || !policy->heap || !policy->heap_pos) {
+            LOG_ERROR_MSG("Failed to allocate victim heap");
+            replacement_destroy(policy);
+            return NULL;
+        }
+        memset(policy->heap_pos, 0xff, num_frames * sizeof(uint32_t));
+    } else if (algo == REPLACE_ARC) {
+        policy->lru_prev = malloc((num_frames + 2) * sizeof(uint32_t));
+        policy->lru_next = malloc((num_frames + 2) * sizeof(uint32_t));
+        policy->arc_list = malloc(num_frames ? num_frames : 1);
+        policy->arc_ghosts = malloc((2 * (size_t)num_frames + 2) * sizeof(GhostPage));
+        policy->arc_ghost_map = pagemap_create(2 * (uint64_t)num_frames);
+        if (!policy->lru_prev || !policy->lru_next || !policy->arc_list || !policy->arc_ghosts ||
+            !policy->arc_ghost_map) {
+            LOG_ERROR_MSG("Failed to allocate ARC lists");
+            replacement_destroy(policy);
+            return NULL;
+        }
+        memset(policy->lru_next, 0xff, num_frames * sizeof(uint32_t));
+        memset(policy->arc_list, 0xff, num_frames);
+        for (uint32_t l = 0; l < 2; l++) {
+            uint32_t head = num_frames + l;
+            policy->lru_prev[head] = head;
+            policy->lru_next[head] = head;
+            head = 2 * num_frames + l;
+            policy->arc_ghosts[head].prev = head;
+            policy->arc_ghosts[head].next = head;
+        }
+        for (uint32_t i = 0; i < 2 * num_frames; i++)
+            policy->arc_ghosts[i].next = i + 1 < 2 * num_frames ? i + 1 : UINT32_MAX;
+        policy->arc_ghost_free = num_frames ? 0 : UINT32_MAX;
+        policy->arc_fault_ghost = UINT32_MAX;
+    } else if (algo == REPLACE_LIRS) {
+        uint32_t hir = num_frames * LIRS_HIR_PERCENT / 100;
+        if (hir == 0)
+            hir = 1;
+        policy->lirs_lir_max = num_frames > hir ? num_frames - hir : 0;
+        policy->lru_prev = malloc((num_frames + 1) * sizeof(uint32_t));
+        policy->lru_next = malloc((num_frames + 1) * sizeof(uint32_t));
+        policy->lirs_prev = malloc((2 * (size_t)num_frames + 1) * sizeof(uint32_t));
+        policy->lirs_next = malloc((2 * (size_t)num_frames + 1) * sizeof(uint32_t));
+        policy->lirs_state = malloc(num_frames ? num_frames : 1);
+        policy->lirs_ghosts = malloc(((size_t)num_frames + 1) * sizeof(GhostPage));
+        policy->lirs_ghost_map = pagemap_create(num_frames);
+        if (!policy->lru_prev || !policy->lru_next || !policy->lirs_prev || !policy->lirs_next ||
+            !policy->lirs_state || !policy->lirs_ghosts || !policy->lirs_ghost_map) {
+            LOG_ERROR_MSG("Failed to allocate LIRS stack");
+            replacement_destroy(policy);
+            return NULL;
+        }
+        memset(policy->lru_next, 0xff, num_frames * sizeof(uint32_t));
+        policy->lru_head = num_frames;
+        policy->lru_prev[num_frames] = num_frames;
+        policy->lru_next[num_frames] = num_frames;
+        memset(policy->lirs_next, 0xff, 2 * (size_t)num_frames * sizeof(uint32_t));
+        policy->lirs_prev[2 * num_frames] = 2 * num_frames;
+        policy->lirs_next[2 * num_frames] = 2 * num_frames;
+        memset(policy->lirs_state, 0xff, num_frames);
+        policy->lirs_ghosts[num_frames].prev = num_frames;
+        policy->lirs_ghosts[num_frames].next = num_frames;
+        for (uint32_t i = 0; i < num_frames; i++)
+            policy->lirs_ghosts[i].next = i + 1 < num_frames ? i + 1 : UINT32_MAX;
+        policy->lirs_ghost_free = num_frames ? 0 : UINT32_MAX;
+    } else if (algo == REPLACE_CLOCK_PRO) {
+        policy->cp_prev = malloc((2 * (size_t)num_frames + 1) * sizeof(uint32_t));
+        policy->cp_next = malloc((2 * (size_t)num_frames + 1) * sizeof(uint32_t));
+        policy->cp_state = malloc(2 * (size_t)num_frames + 1);
+        policy->cp_ghosts = malloc(((size_t)num_frames + 1) * sizeof(GhostPage));
+        policy->cp_ghost_map = pagemap_create(num_frames);
+        policy->lru_prev = malloc((num_frames + 1) * sizeof(uint32_t));
+        policy->lru_next = malloc((num_frames + 1) * sizeof(uint32_t));
+        if (!policy->cp_prev || !policy->cp_next || !policy->cp_state || !policy->cp_ghosts ||
+            !policy->cp_ghost_map || !policy->lru_prev || !policy->lru_next) {
+            LOG_ERROR_MSG("Failed to allocate CLOCK-Pro list");
+            replacement_destroy(policy);
+            return NULL;
+        }
+        memset(policy->cp_state, 0xff, 2 * (size_t)num_frames);
+        memset(policy->lru_next, 0xff, num_frames * sizeof(uint32_t));
+        policy->lru_head = num_frames;
+        policy->lru_prev[num_frames] = num_frames;
+        policy->lru_next[num_frames] = num_frames;
+        for (uint32_t h = 0; h < CP_HANDS; h++)
+            policy->cp_hand[h] = UINT32_MAX;
+        for (uint32_t i = 0; i < num_frames; i++)
+            policy->cp_ghosts[i].next = i + 1 < num_frames ? i + 1 : UINT32_MAX;
+        policy->cp_ghost_free = num_frames ? 0 : UINT32_MAX;
+        // Start from LIRS's share of cold pages; the target adapts from there
+        uint32_t cold = num_frames * LIRS_HIR_PERCENT / 100;
+        policy->cp_cold_target = cold ? cold : 1;
     }
 
     LOG_INFO_MSG("Replacement policy created: %s", replacement_get_name(algo));
@@ -45,151 +156,1014 @@ void replacement_destroy(ReplacementPolicy *policy)
     if (policy->fifo_queue) {
         free(policy->fifo_queue);
     }
+    free(policy->lru_prev);
+    free(policy->lru_next);
+    free(policy->next_use);
+    pagemap_destroy(policy->upcoming);
+    free(policy->heap_key);
+    free(policy->heap);
+    free(policy->heap_pos);
+    free(policy->arc_list);
+    free(policy->arc_ghosts);
+    pagemap_destroy(policy->arc_ghost_map);
+    free(policy->lirs_prev);
+    free(policy->lirs_next);
+    free(policy->lirs_state);
+    free(policy->lirs_ghosts);
+    pagemap_destroy(policy->lirs_ghost_map);
+    free(policy->cp_prev);
+    free(policy->cp_next);
+    free(policy->cp_state);
+    free(policy->cp_ghosts);
+    pagemap_destroy(policy->cp_ghost_map);
     free(policy);
 }
 
-void replacement_set_trace(ReplacementPolicy *policy, Trace *trace)
+bool replacement_set_trace(ReplacementPolicy *policy, Trace *trace, uint32_t page_size)
 {
-    if (policy && policy->algorithm == REPLACE_OPT) {
-        policy->trace = trace;
+    if (!policy || policy->algorithm != REPLACE_OPT)
+        return true;
+    if (!trace || page_size == 0)
+        return false;
+
+    free(policy->next_use);
+    pagemap_destroy(policy->upcoming);
+    policy->next_use = malloc((trace->count ? trace->count : 1) * sizeof(uint64_t));
+    policy->upcoming = pagemap_create(1024);
+    if (!policy->next_use || !policy->upcoming) {
+        LOG_ERROR_MSG("Failed to allocate OPT next-use index");
+        return false;
+    }
+
+    // Backward pass: each entry's next use is the page's last-seen index. What
+    // is left in the map is every page's first use.
+    for (uint64_t i = trace->count; i-- > 0;) {
+        const TraceEntry *e = &trace->entries[i];
+        uint64_t vpn = e->virtual_addr / page_size;
+        uint64_t next;
+        if (!pagemap_get(policy->upcoming, e->pid, vpn, &next))
+            next = UINT64_MAX;
+        policy->next_use[i] = next;
+        if (!pagemap_put(policy->upcoming, e->pid, vpn, i)) {
+            LOG_ERROR_MSG("Failed to grow OPT next-use index");
+            return false;
+        }
     }
+
+    policy->trace = trace;
+    policy->page_size = page_size;
+    policy->current_index = 0;
+    LOG_INFO_MSG("OPT pre-pass: %lu accesses to %lu distinct pages", trace->count,
+                 policy->upcoming->count);
+    return true;
 }
 
 void replacement_set_position(ReplacementPolicy *policy, uint64_t index)
 {
-    if (policy && policy->algorithm == REPLACE_OPT) {
+    if (!policy || policy->algorithm != REPLACE_OPT)
+        return;
+
+    if (policy->trace && index < policy->trace->count) {
+        const TraceEntry *e = &policy->trace->entries[index];
+        replacement_advance(policy, index, e->pid, e->virtual_addr / policy->page_size,
+                            policy->next_use[index]);
+    } else {
         policy->current_index = index;
     }
 }
 
-// Helper for OPT: find next use of a frame in trace
-static uint64_t find_next_use(ReplacementPolicy *policy, uint32_t frame_num,
-                               FrameAllocator *allocator)
+void replacement_set_first_uses(ReplacementPolicy *policy, PageMap *first_use,
+                                uint32_t page_size)
 {
-    if (!policy->trace || policy->current_index >= policy->trace->count) {
-        return UINT64_MAX; // Never used again
+    if (!policy || policy->algorithm != REPLACE_OPT) {
+        pagemap_destroy(first_use);
+        return;
     }
 
-    FrameInfo *frame = frame_get_info(allocator, frame_num);
-    if (!frame) {
-        return UINT64_MAX;
+    free(policy->next_use);
+    pagemap_destroy(policy->upcoming);
+    policy->trace = NULL;
+    policy->next_use = NULL;
+    policy->upcoming = first_use;
+    policy->page_size = page_size;
+    policy->current_index = 0;
+}
+
+void replacement_advance(ReplacementPolicy *policy, uint64_t index, uint32_t pid, uint64_t vpn,
+                         uint64_t next_use)
+{
+    if (!policy || policy->algorithm != REPLACE_OPT)
+        return;
+
+    // The page accessed here is next wanted at its next use
+    policy->current_index = index;
+    if (!policy->upcoming)
+        return;
+    if (next_use == UINT64_MAX)
+        pagemap_remove(policy->upcoming, pid, vpn);
+    else
+        pagemap_put(policy->upcoming, pid, vpn, next_use);
+}
+
+// LRU list: the head's next is the most recent frame, its prev the least recent
+#define LRU_UNLINKED UINT32_MAX
+
+static inline void lru_unlink(ReplacementPolicy *policy, uint32_t frame)
+{
+    uint32_t prev = policy->lru_prev[frame];
+    uint32_t next = policy->lru_next[frame];
+    policy->lru_next[prev] = next;
+    policy->lru_prev[next] = prev;
+    policy->lru_next[frame] = LRU_UNLINKED;
+}
+
+static inline void lru_insert_after(ReplacementPolicy *policy, uint32_t at, uint32_t frame)
+{
+    uint32_t next = policy->lru_next[at];
+    policy->lru_prev[frame] = at;
+    policy->lru_next[frame] = next;
+    policy->lru_prev[next] = frame;
+    policy->lru_next[at] = frame;
+}
+
+static inline bool lru_linked(const ReplacementPolicy *policy, uint32_t frame)
+{
+    return policy->lru_next[frame] != LRU_UNLINKED;
+}
+
+// Move (or add) frame to the most recent end
+static inline void lru_touch(ReplacementPolicy *policy, uint32_t frame)
+{
+    if (lru_linked(policy, frame))
+        lru_unlink(policy, frame);
+    lru_insert_after(policy, policy->lru_head, frame);
+}
+
+// Victim heap: frame a goes above frame b on a larger key, ties to the lower frame
+static inline bool heap_above(const ReplacementPolicy *policy, uint32_t a, uint32_t b)
+{
+    uint64_t ka = policy->heap_key[a], kb = policy->heap_key[b];
+    return ka > kb || (ka == kb && a < b);
+}
+
+static void heap_place(ReplacementPolicy *policy, uint32_t i, uint32_t frame)
+{
+    policy->heap[i] = frame;
+    policy->heap_pos[frame] = i;
+}
+
+static void heap_sift_up(ReplacementPolicy *policy, uint32_t i)
+{
+    uint32_t frame = policy->heap[i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!heap_above(policy, frame, policy->heap[parent]))
+            break;
+        heap_place(policy, i, policy->heap[parent]);
+        i = parent;
     }
+    heap_place(policy, i, frame);
+}
 
-    // Search forward in trace for next access to this page
-    for (uint64_t i = policy->current_index + 1; i < policy->trace->count; i++) {
-        TraceEntry *entry = trace_get(policy->trace, i);
-        if (entry && entry->pid == frame->pid) {
-            uint64_t vpn = entry->virtual_addr / 4096; // Assuming 4KB pages
-            if (vpn == frame->vpn) {
-                return i;
-            }
+// Returns the levels the frame moved down
+static uint32_t heap_sift_down(ReplacementPolicy *policy, uint32_t i)
+{
+    const uint32_t *heap = policy->heap;
+    uint32_t frame = heap[i];
+    uint32_t n = policy->heap_count;
+    uint32_t levels = 0;
+    while (2 * i + 1 < n) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < n && heap_above(policy, heap[child + 1], heap[child]))
+            child++;
+        if (!heap_above(policy, heap[child], frame))
+            break;
+        heap_place(policy, i, heap[child]);
+        i = child;
+        levels++;
+    }
+    heap_place(policy, i, frame);
+    return levels;
+}
+
+static void heap_remove(ReplacementPolicy *policy, uint32_t frame)
+{
+    uint32_t i = policy->heap_pos[frame];
+    if (i == UINT32_MAX)
+        return;
+    policy->heap_pos[frame] = UINT32_MAX;
+    uint32_t last = policy->heap[--policy->heap_count];
+    if (last == frame)
+        return;
+    heap_place(policy, i, last);
+    heap_sift_up(policy, i);
+    heap_sift_down(policy, policy->heap_pos[last]);
+}
+
+static void heap_set(ReplacementPolicy *policy, uint32_t frame, uint64_t key)
+{
+    policy->heap_key[frame] = key;
+    uint32_t i = policy->heap_pos[frame];
+    if (i == UINT32_MAX) {
+        i = policy->heap_count++;
+        heap_place(policy, i, frame);
+    }
+    heap_sift_up(policy, i);
+    heap_sift_down(policy, policy->heap_pos[frame]);
+}
+
+// Take up to k frames off the top of the heap; the last frame refills the root
+static uint32_t heap_pop(ReplacementPolicy *policy, uint32_t *out, uint32_t k)
+{
+    uint32_t found = 0;
+    while (found < k && policy->heap_count > 0) {
+        uint32_t frame = policy->heap[0];
+        uint32_t last = policy->heap[--policy->heap_count];
+        policy->heap_pos[frame] = UINT32_MAX;
+        policy->select_steps++;
+        if (last != frame) {
+            heap_place(policy, 0, last);
+            policy->select_steps += heap_sift_down(policy, 0);
         }
+        out[found++] = frame;
     }
+    return found;
+}
 
-    return UINT64_MAX; // Not found in remaining trace
+// (Re)key a frame by the next use of the page it holds
+static void opt_update(ReplacementPolicy *policy, uint32_t frame, FrameAllocator *allocator)
+{
+    const FrameInfo *info = &allocator->frames[frame];
+    uint64_t next;
+    if (!policy->upcoming || !pagemap_get(policy->upcoming, info->pid, info->vpn, &next))
+        next = UINT64_MAX;
+    heap_set(policy, frame, next);
 }
 
-int32_t replacement_select_victim(ReplacementPolicy *policy, FrameAllocator *allocator)
+// Approx-LRU keys invert the age, so the youngest counter (then the lower
+// frame, as a linear scan would pick) is on top
+static void age_update(ReplacementPolicy *policy, uint32_t frame, FrameAllocator *allocator)
 {
-    if (!policy || !allocator) {
-        return -1;
+    heap_set(policy, frame, UINT32_MAX - allocator->ages[frame]);
+}
+
+// A sweep shifts every age at once and can merge ties, so the keys are redone
+// and the heap rebuilt bottom-up, once, before the first selection after it
+static void age_rebuild(ReplacementPolicy *policy, FrameAllocator *allocator)
+{
+    if (policy->heap_sweeps == allocator->age_sweeps)
+        return;
+    policy->heap_sweeps = allocator->age_sweeps;
+
+    for (uint32_t i = 0; i < policy->heap_count; i++) {
+        uint32_t frame = policy->heap[i];
+        policy->heap_key[frame] = UINT32_MAX - allocator->ages[frame];
     }
+    policy->select_steps += policy->heap_count;
+    for (uint32_t i = policy->heap_count / 2; i-- > 0;)
+        policy->select_steps += heap_sift_down(policy, i);
+}
 
-    switch (policy->algorithm) {
-    case REPLACE_FIFO: {
-        if (policy->fifo_size == 0) {
-            LOG_ERROR_MSG("FIFO queue is empty");
-            return -1;
-        }
-        // Victim is at head of queue
-        uint32_t victim = policy->fifo_queue[policy->fifo_head];
-        policy->fifo_head = (policy->fifo_head + 1) % allocator->total_frames;
-        policy->fifo_size--;
-        LOG_TRACE_MSG("FIFO victim: frame %u", victim);
-        return victim;
-    }
-
-    case REPLACE_LRU: {
-        // Find frame with minimum last_access_time
-        uint64_t min_time = UINT64_MAX;
-        int32_t victim = -1;
-        for (uint32_t i = 0; i < allocator->total_frames; i++) {
-            if (allocator->frames[i].state == FRAME_ALLOCATED) {
-                if (allocator->frames[i].last_access_time < min_time) {
-                    min_time = allocator->frames[i].last_access_time;
-                    victim = i;
-                }
-            }
+// ARC resident lists: T1 and T2 are LRU lists (most recent next to the head)
+// over the same prev/next arrays. A read-ahead page waits in T1 as unused, so
+// its first use is not mistaken for a second reference.
+#define ARC_T1 0
+#define ARC_T2 1
+#define ARC_T1_UNUSED 2
+#define ARC_NONE 0xff
+#define ARC_NO_GHOST UINT32_MAX
+
+static inline uint32_t arc_head(const ReplacementPolicy *policy, uint32_t list)
+{
+    return policy->num_frames + list;
+}
+
+static void arc_unlink(ReplacementPolicy *policy, uint32_t frame)
+{
+    uint8_t state = policy->arc_list[frame];
+    if (state == ARC_NONE)
+        return;
+    lru_unlink(policy, frame);
+    policy->arc_size[state == ARC_T2]--;
+    policy->arc_list[frame] = ARC_NONE;
+}
+
+// Insert at the most recent end of the state's list, or the least recent end
+static void arc_insert(ReplacementPolicy *policy, uint32_t frame, uint8_t state, bool recent)
+{
+    arc_unlink(policy, frame);
+    uint32_t head = arc_head(policy, state == ARC_T2);
+    lru_insert_after(policy, recent ? head : policy->lru_prev[head], frame);
+    policy->arc_size[state == ARC_T2]++;
+    policy->arc_list[frame] = state;
+}
+
+// ARC ghost lists B1 and B2: nodes 0..2c-1 hold pages, 2c and 2c + 1 are the heads
+static void arc_ghost_drop(ReplacementPolicy *policy, uint32_t node)
+{
+    GhostPage *g = policy->arc_ghosts;
+    pagemap_remove(policy->arc_ghost_map, g[node].pid, g[node].vpn);
+    g[g[node].prev].next = g[node].next;
+    g[g[node].next].prev = g[node].prev;
+    policy->arc_ghost_size[g[node].list]--;
+    g[node].next = policy->arc_ghost_free;
+    policy->arc_ghost_free = node;
+}
+
+static void arc_ghost_drop_oldest(ReplacementPolicy *policy, uint32_t list)
+{
+    uint32_t head = 2 * policy->num_frames + list;
+    if (policy->arc_ghosts[head].prev != head)
+        arc_ghost_drop(policy, policy->arc_ghosts[head].prev);
+}
+
+// Case IV of the ARC paper, on the list sizes before the replacement: with
+// L1 = T1 + B1 full, B1's oldest page goes, or T1's oldest leaves no ghost when
+// B1 is empty; otherwise a full directory loses B2's oldest. The faulting page
+// then enters T1 with |T1| + |B1| <= c.
+static void arc_miss(ReplacementPolicy *policy)
+{
+    uint32_t c = policy->num_frames;
+    const uint32_t *t = policy->arc_size;
+    const uint32_t *b = policy->arc_ghost_size;
+    while (b[ARC_T1] > 0 && t[ARC_T1] + b[ARC_T1] >= c)
+        arc_ghost_drop_oldest(policy, ARC_T1);
+    policy->arc_drop_t1 = t[ARC_T1] + b[ARC_T1] >= c;
+    if (!policy->arc_drop_t1 && t[ARC_T1] + t[ARC_T2] + b[ARC_T1] + b[ARC_T2] >= 2 * c)
+        arc_ghost_drop_oldest(policy, b[ARC_T2] ? ARC_T2 : ARC_T1);
+}
+
+// Remember an evicted page; arc_miss has made room in B1, and the directory
+// stays within the 2c nodes even when a batch evicts ahead of the faults
+static void arc_ghost_push(ReplacementPolicy *policy, uint32_t list, uint32_t pid, uint64_t vpn)
+{
+    uint32_t c = policy->num_frames;
+    uint32_t *b = policy->arc_ghost_size;
+    if (policy->arc_size[ARC_T1] + policy->arc_size[ARC_T2] + b[ARC_T1] + b[ARC_T2] >= 2 * c)
+        arc_ghost_drop_oldest(policy, b[ARC_T2] ? ARC_T2 : ARC_T1);
+    if (policy->arc_ghost_free == UINT32_MAX)
+        return;
+
+    GhostPage *g = policy->arc_ghosts;
+    uint32_t node = policy->arc_ghost_free;
+    uint32_t head = 2 * c + list;
+    if (!pagemap_put(policy->arc_ghost_map, pid, vpn, node)) {
+        LOG_ERROR_MSG("Failed to grow ARC ghost map");
+        return;
+    }
+    policy->arc_ghost_free = g[node].next;
+    g[node] = (GhostPage){vpn, pid, head, g[head].next, list};
+    g[g[head].next].prev = node;
+    g[head].next = node;
+    b[list]++;
+}
+
+// A page that becomes resident any other way stops being a ghost
+static void arc_forget(ReplacementPolicy *policy, uint32_t pid, uint64_t vpn)
+{
+    uint64_t node;
+    if (pagemap_get(policy->arc_ghost_map, pid, vpn, &node))
+        arc_ghost_drop(policy, (uint32_t)node);
+}
+
+// REPLACE from the ARC paper: take T1's oldest page while T1 is over its target
+// p (or at it, when the fault hit B2), otherwise T2's; the page becomes a ghost
+// of the list it left. Read-ahead pages never used leave no ghost.
+static uint32_t arc_select(ReplacementPolicy *policy, FrameAllocator *allocator, uint32_t *out,
+                           uint32_t k)
+{
+    uint32_t found = 0;
+    while (found < k && policy->arc_size[ARC_T1] + policy->arc_size[ARC_T2] > 0) {
+        uint32_t t1 = policy->arc_size[ARC_T1];
+        uint32_t p = policy->arc_target;
+        bool from_t1 = t1 > 0 && (t1 > p || (t1 == p && policy->arc_fault_ghost == ARC_T2) ||
+                                  policy->arc_size[ARC_T2] == 0);
+        uint32_t list = from_t1 ? ARC_T1 : ARC_T2;
+        uint32_t frame = policy->lru_prev[arc_head(policy, list)];
+        bool used = policy->arc_list[frame] != ARC_T1_UNUSED;
+        if (from_t1 && policy->arc_drop_t1) {
+            used = false;
+            policy->arc_drop_t1 = false;
+        }
+
+        arc_unlink(policy, frame);
+        policy->select_steps++;
+        if (used) {
+            const FrameInfo *info = &allocator->frames[frame];
+            arc_ghost_push(policy, list, info->pid, info->vpn);
         }
-        LOG_TRACE_MSG("LRU victim: frame %d (time %lu)", victim, min_time);
-        return victim;
+        out[found++] = frame;
     }
+    return found;
+}
 
-    case REPLACE_APPROX_LRU: {
-        // Find frame with minimum age counter (NFU/Aging)
-        uint32_t min_age = UINT32_MAX;
-        int32_t victim = -1;
-        for (uint32_t i = 0; i < allocator->total_frames; i++) {
-            if (allocator->frames[i].state == FRAME_ALLOCATED) {
-                if (allocator->frames[i].age_counter < min_age) {
-                    min_age = allocator->frames[i].age_counter;
-                    victim = i;
-                }
+// LIRS: S runs over lirs_prev/lirs_next, most recent next to the head; the
+// resident HIR queue is the LRU list, its tail evicted first
+#define LIRS_LIR 0
+#define LIRS_HIR 1
+#define LIRS_NONE 0xff
+
+static inline uint32_t lirs_head(const ReplacementPolicy *policy)
+{
+    return 2 * policy->num_frames;
+}
+
+static inline bool lirs_in_stack(const ReplacementPolicy *policy, uint32_t node)
+{
+    return policy->lirs_next[node] != LRU_UNLINKED;
+}
+
+static inline void lirs_stack_unlink(ReplacementPolicy *policy, uint32_t node)
+{
+    uint32_t prev = policy->lirs_prev[node];
+    uint32_t next = policy->lirs_next[node];
+    policy->lirs_next[prev] = next;
+    policy->lirs_prev[next] = prev;
+    policy->lirs_next[node] = LRU_UNLINKED;
+}
+
+static inline void lirs_stack_insert_after(ReplacementPolicy *policy, uint32_t at, uint32_t node)
+{
+    uint32_t next = policy->lirs_next[at];
+    policy->lirs_prev[node] = at;
+    policy->lirs_next[node] = next;
+    policy->lirs_prev[next] = node;
+    policy->lirs_next[at] = node;
+}
+
+static inline void lirs_stack_push(ReplacementPolicy *policy, uint32_t node)
+{
+    if (lirs_in_stack(policy, node))
+        lirs_stack_unlink(policy, node);
+    lirs_stack_insert_after(policy, lirs_head(policy), node);
+}
+
+// Forget a non-resident page, in S or not
+static void lirs_ghost_drop(ReplacementPolicy *policy, uint32_t slot)
+{
+    GhostPage *g = policy->lirs_ghosts;
+    pagemap_remove(policy->lirs_ghost_map, g[slot].pid, g[slot].vpn);
+    g[g[slot].prev].next = g[slot].next;
+    g[g[slot].next].prev = g[slot].prev;
+    g[slot].next = policy->lirs_ghost_free;
+    policy->lirs_ghost_free = slot;
+    if (lirs_in_stack(policy, policy->num_frames + slot))
+        lirs_stack_unlink(policy, policy->num_frames + slot);
+}
+
+static void lirs_forget(ReplacementPolicy *policy, uint32_t pid, uint64_t vpn)
+{
+    uint64_t slot;
+    if (pagemap_get(policy->lirs_ghost_map, pid, vpn, &slot))
+        lirs_ghost_drop(policy, (uint32_t)slot);
+}
+
+// Stack pruning: HIR pages below the oldest LIR page leave S, non-resident ones
+// for good, so the bottom of S is LIR again
+static void lirs_prune(ReplacementPolicy *policy)
+{
+    uint32_t head = lirs_head(policy);
+    for (uint32_t node = policy->lirs_prev[head]; node != head; node = policy->lirs_prev[head]) {
+        if (node >= policy->num_frames)
+            lirs_ghost_drop(policy, node - policy->num_frames);
+        else if (policy->lirs_state[node] != LIRS_LIR)
+            lirs_stack_unlink(policy, node);
+        else
+            break;
+    }
+}
+
+// The oldest LIR page becomes resident HIR, newest in the queue
+static void lirs_demote_bottom(ReplacementPolicy *policy)
+{
+    uint32_t frame = policy->lirs_prev[lirs_head(policy)];
+    if (frame == lirs_head(policy))
+        return;
+    lirs_stack_unlink(policy, frame);
+    policy->lirs_state[frame] = LIRS_HIR;
+    policy->lirs_lir_count--;
+    lru_insert_after(policy, policy->lru_head, frame);
+    lirs_prune(policy);
+}
+
+// A page whose reuse distance beat the oldest LIR page's recency joins the LIR set
+// on top of S, and once the set is full the oldest LIR page leaves it
+static void lirs_promote(ReplacementPolicy *policy, uint32_t frame)
+{
+    if (lru_linked(policy, frame))
+        lru_unlink(policy, frame);
+    policy->lirs_state[frame] = LIRS_LIR;
+    policy->lirs_lir_count++;
+    lirs_stack_push(policy, frame);
+    if (policy->lirs_lir_count > policy->lirs_lir_max)
+        lirs_demote_bottom(policy);
+}
+
+static void lirs_access(ReplacementPolicy *policy, uint32_t frame)
+{
+    if (policy->lirs_state[frame] == LIRS_LIR) {
+        bool bottom = policy->lirs_prev[lirs_head(policy)] == frame;
+        lirs_stack_push(policy, frame);
+        if (bottom)
+            lirs_prune(policy);
+    } else if (lirs_in_stack(policy, frame)) {
+        lirs_promote(policy, frame);
+    } else {
+        // Reused, but less recently than the oldest LIR page was
+        lirs_stack_push(policy, frame);
+        lru_unlink(policy, frame);
+        lru_insert_after(policy, policy->lru_head, frame);
+    }
+}
+
+static void lirs_remove(ReplacementPolicy *policy, uint32_t frame)
+{
+    uint8_t state = policy->lirs_state[frame];
+    if (state == LIRS_NONE)
+        return;
+    if (state == LIRS_LIR)
+        policy->lirs_lir_count--;
+    else if (lru_linked(policy, frame))
+        lru_unlink(policy, frame);
+    policy->lirs_state[frame] = LIRS_NONE;
+
+    if (lirs_in_stack(policy, frame)) {
+        bool bottom = policy->lirs_prev[lirs_head(policy)] == frame;
+        lirs_stack_unlink(policy, frame);
+        if (bottom)
+            lirs_prune(policy);
+    }
+}
+
+// An evicted page still in S stays there, non-resident, in its frame's place.
+// The oldest such page is forgotten when every slot is taken.
+static void lirs_remember(ReplacementPolicy *policy, uint32_t frame, const FrameInfo *info)
+{
+    GhostPage *g = policy->lirs_ghosts;
+    uint32_t head = policy->num_frames;
+    if (policy->lirs_ghost_free == UINT32_MAX)
+        lirs_ghost_drop(policy, g[head].prev);
+
+    uint32_t slot = policy->lirs_ghost_free;
+    if (!pagemap_put(policy->lirs_ghost_map, info->pid, info->vpn, slot)) {
+        LOG_ERROR_MSG("Failed to grow LIRS ghost map");
+        lirs_stack_unlink(policy, frame);
+        return;
+    }
+    policy->lirs_ghost_free = g[slot].next;
+    g[slot] = (GhostPage){info->vpn, info->pid, head, g[head].next, 0};
+    g[g[head].next].prev = slot;
+    g[head].next = slot;
+
+    lirs_stack_insert_after(policy, policy->lirs_prev[frame], policy->num_frames + slot);
+    lirs_stack_unlink(policy, frame);
+}
+
+// Victims come off the resident HIR queue; with it empty the oldest LIR page is
+// demoted into it first
+static uint32_t lirs_select(ReplacementPolicy *policy, FrameAllocator *allocator, uint32_t *out,
+                            uint32_t k)
+{
+    uint32_t head = policy->lru_head;
+    uint32_t found = 0;
+    while (found < k) {
+        if (policy->lru_prev[head] == head) {
+            if (policy->lirs_lir_count == 0)
+                break;
+            lirs_demote_bottom(policy);
+            policy->select_steps++;
+        }
+        uint32_t frame = policy->lru_prev[head];
+        lru_unlink(policy, frame);
+        policy->select_steps++;
+        policy->lirs_state[frame] = LIRS_NONE;
+        if (lirs_in_stack(policy, frame))
+            lirs_remember(policy, frame, &allocator->frames[frame]);
+        out[found++] = frame;
+    }
+    return found;
+}
+
+// CLOCK-Pro list: circular, no head node. New pages go in just behind the hot
+// hand, so every hand reaches them last. Resident cold pages also queue in the
+// LRU list in the order the cold hand meets them, oldest at the tail: they enter
+// at the newest end of the list and the hot hand demotes pages at its oldest, so
+// ring order among them is arrival order. The cold hand steps along that queue
+// instead of walking past every hot page between two cold ones.
+#define CP_HOT 0
+#define CP_COLD 1
+#define CP_COLD_TEST 2
+#define CP_NONRESIDENT 3
+#define CP_NONE 0xff
+#define CP_NO_NODE UINT32_MAX
+
+static void cp_link_before(ReplacementPolicy *policy, uint32_t at, uint32_t node)
+{
+    if (at == CP_NO_NODE) {
+        policy->cp_prev[node] = node;
+        policy->cp_next[node] = node;
+        policy->cp_hand[CP_HAND_HOT] = node;
+        policy->cp_hand[CP_HAND_TEST] = node;
+        return;
+    }
+    uint32_t prev = policy->cp_prev[at];
+    policy->cp_prev[node] = prev;
+    policy->cp_next[node] = at;
+    policy->cp_next[prev] = node;
+    policy->cp_prev[at] = node;
+}
+
+// Take a node off the list; hands on it move on to the next entry
+static void cp_unlink(ReplacementPolicy *policy, uint32_t node)
+{
+    uint32_t next = policy->cp_next[node];
+    for (uint32_t h = CP_HAND_HOT; h < CP_HANDS; h++) {
+        if (policy->cp_hand[h] == node)
+            policy->cp_hand[h] = next == node ? CP_NO_NODE : next;
+    }
+    uint32_t prev = policy->cp_prev[node];
+    policy->cp_next[prev] = next;
+    policy->cp_prev[next] = prev;
+}
+
+// Put node where old is on the list, hands included
+static void cp_replace(ReplacementPolicy *policy, uint32_t old, uint32_t node)
+{
+    if (policy->cp_next[old] == old) {
+        policy->cp_prev[node] = node;
+        policy->cp_next[node] = node;
+    } else {
+        cp_link_before(policy, old, node);
+        uint32_t prev = policy->cp_prev[old], next = policy->cp_next[old];
+        policy->cp_next[prev] = next;
+        policy->cp_prev[next] = prev;
+    }
+    for (uint32_t h = CP_HAND_HOT; h < CP_HANDS; h++) {
+        if (policy->cp_hand[h] == old)
+            policy->cp_hand[h] = node;
+    }
+    policy->cp_state[node] = policy->cp_state[old];
+    policy->cp_state[old] = CP_NONE;
+}
+
+static void cp_insert_newest(ReplacementPolicy *policy, uint32_t node, uint8_t state)
+{
+    cp_link_before(policy, policy->cp_hand[CP_HAND_HOT], node);
+    policy->cp_state[node] = state;
+}
+
+// Resident cold pages: count and queue for the cold hand
+static void cp_cold_add(ReplacementPolicy *policy, uint32_t frame)
+{
+    lru_insert_after(policy, policy->lru_head, frame);
+    policy->cp_cold_count++;
+}
+
+static void cp_cold_del(ReplacementPolicy *policy, uint32_t frame)
+{
+    lru_unlink(policy, frame);
+    policy->cp_cold_count--;
+}
+
+// Take a frame off the list, whatever its state
+static void cp_remove(ReplacementPolicy *policy, uint32_t frame)
+{
+    uint8_t state = policy->cp_state[frame];
+    if (state == CP_NONE)
+        return;
+    if (state == CP_HOT)
+        policy->cp_hot_count--;
+    else
+        cp_cold_del(policy, frame);
+    cp_unlink(policy, frame);
+    policy->cp_state[frame] = CP_NONE;
+}
+
+static void cp_ghost_drop(ReplacementPolicy *policy, uint32_t slot)
+{
+    GhostPage *g = policy->cp_ghosts;
+    uint32_t node = policy->num_frames + slot;
+    pagemap_remove(policy->cp_ghost_map, g[slot].pid, g[slot].vpn);
+    cp_unlink(policy, node);
+    policy->cp_state[node] = CP_NONE;
+    g[slot].next = policy->cp_ghost_free;
+    policy->cp_ghost_free = slot;
+    policy->cp_ghost_count--;
+}
+
+static void cp_forget(ReplacementPolicy *policy, uint32_t pid, uint64_t vpn)
+{
+    uint64_t slot;
+    if (pagemap_get(policy->cp_ghost_map, pid, vpn, &slot))
+        cp_ghost_drop(policy, (uint32_t)slot);
+}
+
+// A test period ran out without the page being used: fewer cold pages wanted
+static void cp_end_test(ReplacementPolicy *policy, uint32_t node)
+{
+    if (policy->cp_cold_target > 1)
+        policy->cp_cold_target--;
+    if (node >= policy->num_frames)
+        cp_ghost_drop(policy, node - policy->num_frames);
+    else
+        policy->cp_state[node] = CP_COLD;
+}
+
+// Hot hand: clears the reference bits of hot pages until it reaches one without,
+// which turns cold; the test periods it passes end
+static void cp_run_hot(ReplacementPolicy *policy, FrameAllocator *allocator)
+{
+    while (policy->cp_hot_count > 0) {
+        uint32_t node = policy->cp_hand[CP_HAND_HOT];
+        policy->cp_hand[CP_HAND_HOT] = policy->cp_next[node];
+        policy->cp_moves[CP_HAND_HOT]++;
+
+        uint8_t state = policy->cp_state[node];
+        if (state == CP_HOT) {
+            if (frame_is_referenced(allocator, node)) {
+                frame_set_reference(allocator, node, false);
+            } else {
+                policy->cp_state[node] = CP_COLD;
+                policy->cp_hot_count--;
+                cp_cold_add(policy, node);
+                return;
             }
+        } else if (state == CP_COLD_TEST || state == CP_NONRESIDENT) {
+            cp_end_test(policy, node);
         }
-        LOG_TRACE_MSG("Approx-LRU victim: frame %d (age %u)", victim, min_age);
-        return victim;
-    }
-
-    case REPLACE_CLOCK: {
-        // Second-chance algorithm
-        uint32_t start = policy->clock_hand;
-        while (1) {
-            if (allocator->frames[policy->clock_hand].state == FRAME_ALLOCATED) {
-                if (allocator->frames[policy->clock_hand].reference_bit == 0) {
-                    // Found victim
-                    uint32_t victim = policy->clock_hand;
-                    policy->clock_hand = (policy->clock_hand + 1) % allocator->total_frames;
-                    LOG_TRACE_MSG("Clock victim: frame %u", victim);
-                    return victim;
-                } else {
-                    // Give second chance
-                    allocator->frames[policy->clock_hand].reference_bit = 0;
-                }
+    }
+}
+
+// Test hand: ends test periods up to and including the next non-resident page
+static void cp_run_test(ReplacementPolicy *policy)
+{
+    while (policy->cp_ghost_count > 0) {
+        uint32_t node = policy->cp_hand[CP_HAND_TEST];
+        policy->cp_hand[CP_HAND_TEST] = policy->cp_next[node];
+        policy->cp_moves[CP_HAND_TEST]++;
+
+        uint8_t state = policy->cp_state[node];
+        if (state == CP_COLD_TEST) {
+            cp_end_test(policy, node);
+        } else if (state == CP_NONRESIDENT) {
+            cp_end_test(policy, node);
+            return;
+        }
+    }
+}
+
+static void cp_balance(ReplacementPolicy *policy, FrameAllocator *allocator)
+{
+    while (policy->cp_hot_count > 0 &&
+           policy->cp_hot_count + policy->cp_cold_target > policy->num_frames) {
+        cp_run_hot(policy, allocator);
+    }
+}
+
+// Cold hand: a referenced cold page in its test period turns hot, one outside
+// it starts one; both move to the newest end. The first unreferenced cold page
+// is the victim, and stays on as non-resident if its test period is running.
+static int32_t cp_run_cold(ReplacementPolicy *policy, FrameAllocator *allocator)
+{
+    uint32_t head = policy->lru_head;
+    for (;;) {
+        if (policy->cp_cold_count == 0) {
+            if (policy->cp_hot_count == 0)
+                return -1;
+            cp_run_hot(policy, allocator);
+        }
+        uint32_t node = policy->lru_prev[head];
+        uint8_t state = policy->cp_state[node];
+        policy->cp_moves[CP_HAND_COLD]++;
+
+        if (frame_is_referenced(allocator, node)) {
+            frame_set_reference(allocator, node, false);
+            cp_unlink(policy, node);
+            cp_cold_del(policy, node);
+            if (state == CP_COLD_TEST) {
+                policy->cp_hot_count++;
+                cp_insert_newest(policy, node, CP_HOT);
+                cp_balance(policy, allocator);
+            } else {
+                cp_insert_newest(policy, node, CP_COLD_TEST);
+                cp_cold_add(policy, node);
             }
-            policy->clock_hand = (policy->clock_hand + 1) % allocator->total_frames;
-
-            // Prevent infinite loop
-            if (policy->clock_hand == start) {
-                // All frames have reference bit set, take current one
-                uint32_t victim = policy->clock_hand;
-                policy->clock_hand = (policy->clock_hand + 1) % allocator->total_frames;
-                return victim;
+            continue;
+        }
+
+        cp_cold_del(policy, node);
+        if (state == CP_COLD_TEST) {
+            if (policy->cp_ghost_free == UINT32_MAX)
+                cp_run_test(policy);
+            uint32_t slot = policy->cp_ghost_free;
+            const FrameInfo *info = &allocator->frames[node];
+            if (slot != UINT32_MAX &&
+                pagemap_put(policy->cp_ghost_map, info->pid, info->vpn, slot)) {
+                policy->cp_ghost_free = policy->cp_ghosts[slot].next;
+                policy->cp_ghosts[slot].pid = info->pid;
+                policy->cp_ghosts[slot].vpn = info->vpn;
+                policy->cp_ghost_count++;
+                cp_replace(policy, node, policy->num_frames + slot);
+                policy->cp_state[policy->num_frames + slot] = CP_NONRESIDENT;
+                return (int32_t)node;
             }
         }
+        cp_unlink(policy, node);
+        policy->cp_state[node] = CP_NONE;
+        return (int32_t)node;
     }
+}
 
-    case REPLACE_OPT: {
-        // Optimal - replace page that will be used furthest in future
-        uint64_t max_next_use = 0;
-        int32_t victim = -1;
-        for (uint32_t i = 0; i < allocator->total_frames; i++) {
-            if (allocator->frames[i].state == FRAME_ALLOCATED) {
-                uint64_t next_use = find_next_use(policy, i, allocator);
-                if (next_use > max_next_use) {
-                    max_next_use = next_use;
-                    victim = i;
-                }
-            }
+static uint32_t cp_select(ReplacementPolicy *policy, FrameAllocator *allocator, uint32_t *out,
+                          uint32_t k)
+{
+    uint64_t moves = policy->cp_moves[CP_HAND_COLD] + policy->cp_moves[CP_HAND_HOT] +
+                     policy->cp_moves[CP_HAND_TEST];
+    uint32_t found = 0;
+    while (found < k) {
+        int32_t frame = cp_run_cold(policy, allocator);
+        if (frame < 0)
+            break;
+        out[found++] = (uint32_t)frame;
+    }
+    policy->select_steps += policy->cp_moves[CP_HAND_COLD] + policy->cp_moves[CP_HAND_HOT] +
+                            policy->cp_moves[CP_HAND_TEST] - moves;
+    return found;
+}
+
+// Second-chance sweep that keeps going until k frames are collected. Victims from the
+// first lap are skipped on the second, by which point every reference bit is clear.
+// The hand moves a bitmap word at a time: referenced frames it passes lose their
+// bit in one mask, and the next victim is the lowest allocated, unreferenced bit.
+static uint32_t clock_select(ReplacementPolicy *policy, FrameAllocator *allocator, uint32_t *out,
+                             uint32_t k)
+{
+    uint32_t total = allocator->total_frames;
+    uint64_t *alloc = allocator->bitmap;
+    uint64_t *ref = allocator->ref_bitmap;
+    uint32_t hand = policy->clock_hand;
+    uint64_t budget = 2ULL * total; // Frames the hand may pass
+    uint32_t found = 0;
+
+    while (found < k && budget > 0) {
+        uint32_t w = hand / 64;
+        uint32_t bit = hand % 64;
+        uint32_t span = 64 - bit;
+        if (span > total - hand)
+            span = total - hand;
+        if (span > budget)
+            span = (uint32_t)budget;
+        uint64_t live = alloc[w] & ((span == 64 ? ~0ULL : (1ULL << span) - 1) << bit);
+
+        uint64_t cand = live & ~ref[w];
+        for (; cand; cand &= cand - 1) {
+            uint32_t v = w * 64 + (uint32_t)__builtin_ctzll(cand);
+            bool taken = false;
+            for (uint32_t j = 0; j < found && !taken; j++)
+                taken = out[j] == v;
+            if (!taken)
+                break;
+        }
+
+        if (cand) {
+            // Second chance for everything passed on the way to the victim
+            uint32_t v = w * 64 + (uint32_t)__builtin_ctzll(cand);
+            ref[w] &= ~(live & ((1ULL << (v % 64)) - 1));
+            out[found++] = v;
+            budget -= v - hand + 1;
+            hand = v + 1 == total ? 0 : v + 1;
+        } else {
+            ref[w] &= ~live;
+            budget -= span;
+            hand = hand + span == total ? 0 : hand + span;
         }
-        LOG_TRACE_MSG("OPT victim: frame %d (next use at %lu)", victim, max_next_use);
-        return victim;
     }
 
+    policy->clock_hand = hand;
+    policy->select_steps += 2ULL * total - budget;
+    return found;
+}
+
+void replacement_on_fault(ReplacementPolicy *policy, uint32_t pid, uint64_t vpn)
+{
+    if (!policy || (policy->algorithm != REPLACE_ARC && policy->algorithm != REPLACE_LIRS &&
+                    policy->algorithm != REPLACE_CLOCK_PRO))
+        return;
+
+    policy->fault_pid = pid;
+    policy->fault_vpn = vpn;
+    policy->fault_pending = true;
+    if (policy->algorithm == REPLACE_CLOCK_PRO) {
+        // Faulting on a page in its test period: cold pages deserved more room
+        uint64_t slot;
+        policy->cp_fault_test = pagemap_get(policy->cp_ghost_map, pid, vpn, &slot);
+        if (policy->cp_fault_test) {
+            if (policy->cp_cold_target < policy->num_frames)
+                policy->cp_cold_target++;
+            cp_ghost_drop(policy, (uint32_t)slot);
+        }
+        return;
+    }
+    if (policy->algorithm != REPLACE_ARC)
+        return;
+
+    policy->arc_fault_ghost = ARC_NO_GHOST;
+
+    uint64_t node;
+    if (!pagemap_get(policy->arc_ghost_map, pid, vpn, &node)) {
+        arc_miss(policy);
+        return;
+    }
+
+    // Ghost hit: the list that lost this page deserved more room
+    uint32_t b1 = policy->arc_ghost_size[ARC_T1];
+    uint32_t b2 = policy->arc_ghost_size[ARC_T2];
+    uint32_t p = policy->arc_target;
+    uint32_t list = policy->arc_ghosts[node].list;
+    if (list == ARC_T1) {
+        uint32_t delta = b2 > b1 ? b2 / b1 : 1;
+        policy->arc_target = delta >= policy->num_frames - p ? policy->num_frames : p + delta;
+    } else {
+        uint32_t delta = b1 > b2 ? b1 / b2 : 1;
+        policy->arc_target = delta >= p ? 0 : p - delta;
+    }
+    policy->arc_fault_ghost = list;
+    arc_ghost_drop(policy, (uint32_t)node);
+}
+
+uint32_t replacement_select_victims(ReplacementPolicy *policy, FrameAllocator *allocator,
+                                    uint32_t *out, uint32_t k)
+{
+    if (!policy || !allocator || !out || k == 0) {
+        return 0;
+    }
+
+    uint32_t found = 0;
+    switch (policy->algorithm) {
+    case REPLACE_FIFO:
+        // Victims are at the head of the queue
+        while (found < k && policy->fifo_size > 0) {
+            out[found++] = policy->fifo_queue[policy->fifo_head];
+            policy->fifo_head = (policy->fifo_head + 1) % policy->fifo_capacity;
+            policy->fifo_size--;
+        }
+        policy->select_steps += found;
+        break;
+
+    case REPLACE_LRU:
+        // Least recent frames are at the tail of the list
+        while (found < k && policy->lru_prev[policy->lru_head] != policy->lru_head) {
+            out[found] = policy->lru_prev[policy->lru_head];
+            lru_unlink(policy, out[found++]);
+        }
+        policy->select_steps += found;
+        break;
+
+    case REPLACE_APPROX_LRU:
+        // Smallest age counter first (NFU/Aging)
+        age_rebuild(policy, allocator);
+        found = heap_pop(policy, out, k);
+        break;
+
+    case REPLACE_CLOCK:
+        found = clock_select(policy, allocator, out, k);
+        break;
+
+    case REPLACE_OPT:
+        // Optimal - replace pages that will be used furthest in future
+        found = heap_pop(policy, out, k);
+        break;
+
+    case REPLACE_ARC:
+        found = arc_select(policy, allocator, out, k);
+        break;
+
+    case REPLACE_LIRS:
+        found = lirs_select(policy, allocator, out, k);
+        break;
+
+    case REPLACE_CLOCK_PRO:
+        found = cp_select(policy, allocator, out, k);
+        break;
+
     default:
         LOG_ERROR_MSG("Unknown replacement algorithm");
+        return 0;
+    }
+
+    LOG_TRACE_MSG("%s selected %u of %u victims (first: frame %d)",
+                  replacement_get_name(policy->algorithm), found, k,
+                  found ? (int32_t)out[0] : -1);
+    return found;
+}
+
+int32_t replacement_select_victim(ReplacementPolicy *policy, FrameAllocator *allocator)
+{
+    uint32_t victim;
+    if (replacement_select_victims(policy, allocator, &victim, 1) == 0) {
         return -1;
     }
+    return (int32_t)victim;
 }
 
 void replacement_on_access(ReplacementPolicy *policy, uint32_t frame_num,
@@ -198,17 +1172,29 @@ void replacement_on_access(ReplacementPolicy *policy, uint32_t frame_num,
     if (!policy || !allocator)
         return;
 
-    // Update frame access time for LRU
+    // Update frame access time and recency order for LRU
     if (policy->algorithm == REPLACE_LRU) {
         frame_update_access_time(allocator, frame_num);
+        lru_touch(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_OPT) {
+        opt_update(policy, frame_num, allocator);
     }
-    // Set reference bit for Clock and Approx-LRU
-    else if (policy->algorithm == REPLACE_CLOCK || policy->algorithm == REPLACE_APPROX_LRU) {
+    // Set reference bit for Clock, CLOCK-Pro and Approx-LRU
+    else if (policy->algorithm == REPLACE_CLOCK || policy->algorithm == REPLACE_CLOCK_PRO ||
+             policy->algorithm == REPLACE_APPROX_LRU) {
         frame_set_reference(allocator, frame_num, true);
     }
+    // A page used again moves to T2, except on the first use of a read-ahead page
+    else if (policy->algorithm == REPLACE_ARC && policy->arc_list[frame_num] != ARC_NONE) {
+        arc_insert(policy, frame_num,
+                   policy->arc_list[frame_num] == ARC_T1_UNUSED ? ARC_T1 : ARC_T2, true);
+    } else if (policy->algorithm == REPLACE_LIRS && policy->lirs_state[frame_num] != LIRS_NONE) {
+        lirs_access(policy, frame_num);
+    }
 }
 
-void replacement_on_allocate(ReplacementPolicy *policy, uint32_t frame_num)
+void replacement_on_allocate(ReplacementPolicy *policy, uint32_t frame_num,
+                             FrameAllocator *allocator)
 {
     if (!policy)
         return;
@@ -217,9 +1203,79 @@ void replacement_on_allocate(ReplacementPolicy *policy, uint32_t frame_num)
     if (policy->algorithm == REPLACE_FIFO) {
         if (policy->fifo_queue) {
             policy->fifo_queue[policy->fifo_tail] = frame_num;
-            policy->fifo_tail = (policy->fifo_tail + 1) % 1024; // Assuming max 1024 frames
+            policy->fifo_tail = (policy->fifo_tail + 1) % policy->fifo_capacity;
             policy->fifo_size++;
         }
+    } else if (policy->algorithm == REPLACE_LRU) {
+        lru_touch(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_OPT && allocator) {
+        opt_update(policy, frame_num, allocator);
+    } else if (policy->algorithm == REPLACE_APPROX_LRU && allocator) {
+        age_update(policy, frame_num, allocator);
+    } else if (policy->algorithm == REPLACE_ARC && allocator) {
+        // The faulting page goes to T2 if it was a ghost, any other page to T1
+        const FrameInfo *info = &allocator->frames[frame_num];
+        uint8_t state = ARC_T1;
+        if (policy->fault_pending && info->pid == policy->fault_pid &&
+            info->vpn == policy->fault_vpn) {
+            if (policy->arc_fault_ghost != ARC_NO_GHOST)
+                state = ARC_T2;
+            policy->fault_pending = false;
+            policy->arc_fault_ghost = ARC_NO_GHOST;
+            policy->arc_drop_t1 = false;
+            arc_insert(policy, frame_num, state, true);
+            uint32_t l1 = policy->arc_size[ARC_T1] + policy->arc_ghost_size[ARC_T1];
+            if (l1 > policy->arc_l1_max)
+                policy->arc_l1_max = l1;
+        } else {
+            arc_forget(policy, info->pid, info->vpn);
+            arc_insert(policy, frame_num, state, true);
+        }
+    } else if (policy->algorithm == REPLACE_LIRS && allocator) {
+        // The faulting page joins the LIR set if it was still in S as a
+        // non-resident page, or while the set is filling up
+        const FrameInfo *info = &allocator->frames[frame_num];
+        bool faulted = policy->fault_pending && info->pid == policy->fault_pid &&
+                       info->vpn == policy->fault_vpn;
+        uint64_t slot;
+        bool recent = pagemap_get(policy->lirs_ghost_map, info->pid, info->vpn, &slot);
+        if (faulted)
+            policy->fault_pending = false;
+        if (recent)
+            lirs_ghost_drop(policy, (uint32_t)slot);
+
+        lirs_remove(policy, frame_num);
+        policy->lirs_state[frame_num] = LIRS_HIR;
+        if ((faulted && recent) || policy->lirs_lir_count < policy->lirs_lir_max) {
+            lirs_promote(policy, frame_num);
+        } else {
+            lirs_stack_push(policy, frame_num);
+            lru_insert_after(policy, policy->lru_head, frame_num);
+        }
+    } else if (policy->algorithm == REPLACE_CLOCK_PRO && allocator) {
+        // A page faulted back in during its test period is hot at once, as is any
+        // page while the hot share is filling up; others start cold in a test
+        // period. The fault itself is not a reference.
+        const FrameInfo *info = &allocator->frames[frame_num];
+        bool hot = policy->cp_hot_count + policy->cp_cold_target < policy->num_frames;
+        if (policy->fault_pending && info->pid == policy->fault_pid &&
+            info->vpn == policy->fault_vpn) {
+            hot = hot || policy->cp_fault_test;
+            policy->fault_pending = false;
+            policy->cp_fault_test = false;
+        } else {
+            cp_forget(policy, info->pid, info->vpn);
+        }
+        cp_remove(policy, frame_num);
+        frame_set_reference(allocator, frame_num, false);
+        if (hot) {
+            policy->cp_hot_count++;
+            cp_insert_newest(policy, frame_num, CP_HOT);
+            cp_balance(policy, allocator);
+        } else {
+            cp_insert_newest(policy, frame_num, CP_COLD_TEST);
+            cp_cold_add(policy, frame_num);
+        }
     }
 }
 
@@ -231,20 +1287,155 @@ void replacement_on_free(ReplacementPolicy *policy, uint32_t frame_num)
     // Remove from FIFO queue if present
     if (policy->algorithm == REPLACE_FIFO && policy->fifo_queue) {
         // Linear search and remove (simple implementation)
+        uint32_t capacity = policy->fifo_capacity;
         for (uint32_t i = 0; i < policy->fifo_size; i++) {
-            uint32_t idx = (policy->fifo_head + i) % 1024;
+            uint32_t idx = (policy->fifo_head + i) % capacity;
             if (policy->fifo_queue[idx] == frame_num) {
                 // Shift remaining entries
                 for (uint32_t j = i; j < policy->fifo_size - 1; j++) {
-                    uint32_t cur_idx = (policy->fifo_head + j) % 1024;
-                    uint32_t next_idx = (policy->fifo_head + j + 1) % 1024;
+                    uint32_t cur_idx = (policy->fifo_head + j) % capacity;
+                    uint32_t next_idx = (policy->fifo_head + j + 1) % capacity;
                     policy->fifo_queue[cur_idx] = policy->fifo_queue[next_idx];
                 }
-                policy->fifo_tail = (policy->fifo_tail - 1 + 1024) % 1024;
+                policy->fifo_tail = (policy->fifo_tail - 1 + capacity) % capacity;
                 policy->fifo_size--;
                 break;
             }
         }
+    } else if (policy->algorithm == REPLACE_LRU && lru_linked(policy, frame_num)) {
+        lru_unlink(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_OPT || policy->algorithm == REPLACE_APPROX_LRU) {
+        heap_remove(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_ARC) {
+        arc_unlink(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_LIRS) {
+        lirs_remove(policy, frame_num);
+    } else if (policy->algorithm == REPLACE_CLOCK_PRO) {
+        cp_remove(policy, frame_num);
+    }
+}
+
+void replacement_on_move(ReplacementPolicy *policy, uint32_t from, uint32_t to,
+                         FrameAllocator *allocator)
+{
+    if (!policy)
+        return;
+
+    if (policy->algorithm == REPLACE_LRU && lru_linked(policy, from)) {
+        if (lru_linked(policy, to))
+            lru_unlink(policy, to);
+        lru_insert_after(policy, policy->lru_prev[from], to);
+        lru_unlink(policy, from);
+        return;
+    }
+    if (policy->algorithm == REPLACE_ARC && policy->arc_list[from] != ARC_NONE) {
+        uint8_t state = policy->arc_list[from];
+        arc_unlink(policy, to);
+        lru_insert_after(policy, policy->lru_prev[from], to);
+        policy->arc_list[to] = state;
+        policy->arc_size[state == ARC_T2]++;
+        arc_unlink(policy, from);
+        return;
+    }
+    if (policy->algorithm == REPLACE_LIRS && policy->lirs_state[from] != LIRS_NONE) {
+        lirs_remove(policy, to);
+        policy->lirs_state[to] = policy->lirs_state[from];
+        if (lirs_in_stack(policy, from)) {
+            lirs_stack_insert_after(policy, policy->lirs_prev[from], to);
+            lirs_stack_unlink(policy, from);
+        }
+        if (lru_linked(policy, from)) {
+            lru_insert_after(policy, policy->lru_prev[from], to);
+            lru_unlink(policy, from);
+        }
+        policy->lirs_state[from] = LIRS_NONE;
+        return;
+    }
+    if (policy->algorithm == REPLACE_CLOCK_PRO && policy->cp_state[from] != CP_NONE) {
+        cp_remove(policy, to);
+        if (policy->cp_state[from] != CP_HOT) {
+            lru_insert_after(policy, policy->lru_prev[from], to);
+            lru_unlink(policy, from);
+        }
+        cp_replace(policy, from, to);
+        return;
+    }
+
+    // Elsewhere the page simply arrives in its new frame
+    replacement_on_free(policy, from);
+    replacement_on_allocate(policy, to, allocator);
+}
+
+void replacement_on_readahead(ReplacementPolicy *policy, uint32_t frame_num,
+                              FrameAllocator *allocator)
+{
+    if (!policy || !allocator)
+        return;
+
+    switch (policy->algorithm) {
+    case REPLACE_FIFO:
+        // Queue at the head: first in line for eviction
+        if (policy->fifo_queue) {
+            policy->fifo_head = (policy->fifo_head - 1 + policy->fifo_capacity) %
+                                policy->fifo_capacity;
+            policy->fifo_queue[policy->fifo_head] = frame_num;
+            policy->fifo_size++;
+        }
+        break;
+    case REPLACE_LRU:
+        // Older than any page that has actually been used
+        allocator->frames[frame_num].last_access_time = 0;
+        if (lru_linked(policy, frame_num))
+            lru_unlink(policy, frame_num);
+        lru_insert_after(policy, policy->lru_prev[policy->lru_head], frame_num);
+        break;
+    case REPLACE_APPROX_LRU:
+    case REPLACE_CLOCK:
+        allocator->ages[frame_num] = 0;
+        frame_set_reference(allocator, frame_num, false);
+        if (policy->algorithm == REPLACE_APPROX_LRU)
+            age_update(policy, frame_num, allocator);
+        break;
+    case REPLACE_OPT:
+        // Ranked by future use alone
+        opt_update(policy, frame_num, allocator);
+        break;
+    case REPLACE_ARC:
+        // Oldest in T1, and no ghost of it if it goes unused
+        arc_forget(policy, allocator->frames[frame_num].pid, allocator->frames[frame_num].vpn);
+        arc_insert(policy, frame_num, ARC_T1_UNUSED, false);
+        break;
+    case REPLACE_LIRS:
+        // Resident HIR outside S, next in line for eviction
+        lirs_forget(policy, allocator->frames[frame_num].pid, allocator->frames[frame_num].vpn);
+        lirs_remove(policy, frame_num);
+        policy->lirs_state[frame_num] = LIRS_HIR;
+        lru_insert_after(policy, policy->lru_prev[policy->lru_head], frame_num);
+        break;
+    case REPLACE_CLOCK_PRO:
+        // Cold outside a test period, next for the cold hand
+        cp_forget(policy, allocator->frames[frame_num].pid, allocator->frames[frame_num].vpn);
+        cp_remove(policy, frame_num);
+        frame_set_reference(allocator, frame_num, false);
+        cp_insert_newest(policy, frame_num, CP_COLD);
+        lru_insert_after(policy, policy->lru_prev[policy->lru_head], frame_num);
+        policy->cp_cold_count++;
+        break;
+    default:
+        break;
+    }
+}
+
+void replacement_on_readahead_hit(ReplacementPolicy *policy, uint32_t frame_num)
+{
+    if (!policy)
+        return;
+
+    // FIFO does not reorder on access, so the page arrives now; the other
+    // policies promote it through replacement_on_access
+    if (policy->algorithm == REPLACE_FIFO) {
+        replacement_on_free(policy, frame_num);
+        replacement_on_allocate(policy, frame_num, NULL);
     }
 }
 
@@ -261,6 +1452,12 @@ const char *replacement_get_name(ReplacementAlgorithm algo)
         return "Clock";
     case REPLACE_OPT:
         return "OPT";
+    case REPLACE_ARC:
+        return "ARC";
+    case REPLACE_LIRS:
+        return "LIRS";
+    case REPLACE_CLOCK_PRO:
+        return "CLOCK-Pro";
     default:
         return "Unknown";
     }
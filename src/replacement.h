@@ -1,7 +1,9 @@
 /**
  * replacement.h - Page replacement algorithms
  * 
- * Implements FIFO, LRU (exact and approximate), Clock (Second-Chance), and OPT.
+ * Implements FIFO, LRU (exact and approximate), Clock (Second-Chance), ARC
+ * (Adaptive Replacement Cache), LIRS (Low Inter-reference Recency Set),
+ * CLOCK-Pro, and OPT.
  * Provides a unified interface for victim selection.
  */
 
@@ -11,6 +13,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "frame.h"
+#include "pagemap.h"
 
 // Replacement algorithms
 typedef enum {
@@ -18,47 +21,165 @@ typedef enum {
     REPLACE_LRU,   // Least Recently Used (exact)
     REPLACE_APPROX_LRU, // Approximate LRU with aging
     REPLACE_CLOCK, // Clock (Second-Chance)
-    REPLACE_OPT    // Optimal (requires future knowledge from trace)
+    REPLACE_OPT,   // Optimal (requires future knowledge from trace)
+    REPLACE_ARC,   // Adaptive Replacement Cache (recency vs frequency)
+    REPLACE_LIRS,  // Low Inter-reference Recency Set (scan and loop resistant)
+    REPLACE_CLOCK_PRO // CLOCK-Pro (LIRS approximated with reference bits)
 } ReplacementAlgorithm;
 
 // Forward declaration for trace access (OPT needs future references)
 typedef struct Trace Trace;
 
+// A page remembered after eviction (ARC's B1/B2, LIRS's non-resident HIR pages)
+typedef struct {
+    uint64_t vpn;
+    uint32_t pid;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t list;     // ARC: B1 or B2
+} GhostPage;
+
+// CLOCK-Pro hands
+typedef enum {
+    CP_HAND_COLD, // Evicts cold pages
+    CP_HAND_HOT,  // Demotes hot pages
+    CP_HAND_TEST, // Ends test periods of non-resident pages
+    CP_HANDS
+} ClockProHand;
+
 // Replacement policy state
 typedef struct {
     ReplacementAlgorithm algorithm;
+    uint32_t num_frames;
+    uint64_t select_steps;     // Selection work: list entries, heap levels or hand moves
+
+    // Page being faulted in, between replacement_on_fault and its allocation
+    uint32_t fault_pid;
+    uint64_t fault_vpn;
+    bool fault_pending;
     
     // FIFO state
     uint32_t *fifo_queue;
     uint32_t fifo_head;
     uint32_t fifo_tail;
     uint32_t fifo_size;
+    uint32_t fifo_capacity;
     
+    // LRU state: intrusive recency list over frame numbers, most recent first.
+    // Node num_frames is the list head; a frame off the list has next == UINT32_MAX.
+    uint32_t *lru_prev;
+    uint32_t *lru_next;
+    uint32_t lru_head;
+
     // Clock state
     uint32_t clock_hand;
     
-    // OPT state
+    // OPT state: the next use of every trace entry is computed up front, and
+    // resident frames sit in the victim heap keyed by the next use of their page
     Trace *trace;              // Pointer to trace for future reference
     uint64_t current_index;    // Current position in trace
-    
+    uint32_t page_size;        // Splits trace addresses into pages
+    uint64_t *next_use;        // Per trace entry: next access to its page, UINT64_MAX = none
+    PageMap *upcoming;         // (pid, vpn) -> next access after the current position
+
+    // Victim heap (OPT, Approx-LRU): resident frames, largest key on top. OPT
+    // keys by next use; Approx-LRU by inverted age, rekeyed after each aging sweep.
+    uint64_t *heap_key;        // Per frame
+    uint32_t *heap;            // Frames, best victim first
+    uint32_t *heap_pos;        // Heap index per frame, UINT32_MAX when not in the heap
+    uint32_t heap_count;
+    uint64_t heap_sweeps;      // Aging sweeps the Approx-LRU keys reflect
+
+    // ARC state: T1 (pages used once lately) and T2 (used again) are recency lists
+    // over frames in lru_prev/lru_next, headed by nodes num_frames and num_frames + 1.
+    // B1 and B2 remember pages evicted from each, found by (pid, vpn) in arc_ghost_map.
+    uint32_t arc_target;       // p: adaptive target size of T1
+    uint8_t *arc_list;         // Per frame: T1, T2, T1 unused (read ahead) or none
+    uint32_t arc_size[2];      // |T1|, |T2|
+    GhostPage *arc_ghosts;     // 2c nodes, then the B1 and B2 heads
+    uint32_t arc_ghost_size[2];
+    uint32_t arc_ghost_free;   // Unused nodes, chained through next
+    PageMap *arc_ghost_map;    // (pid, vpn) -> ghost node
+    uint32_t arc_fault_ghost;  // Ghost list the faulting page was in (B1 or B2), or none
+    bool arc_drop_t1;          // Miss with T1 full: its oldest page leaves no ghost
+    uint32_t arc_l1_max;       // Largest |T1| + |B1| once a faulting page is in (at most c)
+
+    // LIRS state: the stack S holds every LIR page and the HIR pages, resident or
+    // not, used since the oldest LIR page; its bottom is always LIR. Stack nodes are
+    // frames, then non-resident pages (num_frames + ghost slot), then the head.
+    // Resident HIR pages also wait in lru_prev/lru_next, the oldest evicted first.
+    uint32_t *lirs_prev;
+    uint32_t *lirs_next;
+    uint8_t *lirs_state;       // Per frame: LIR, resident HIR or none
+    uint32_t lirs_lir_count;
+    uint32_t lirs_lir_max;     // Frames less the resident HIR reserve
+    GhostPage *lirs_ghosts;    // Non-resident HIR pages, oldest evicted last; head at num_frames
+    uint32_t lirs_ghost_free;  // Unused slots, chained through next
+    PageMap *lirs_ghost_map;   // (pid, vpn) -> ghost slot
+
+    // CLOCK-Pro state: one circular list in recency order, the hot and test hands
+    // moving from old to new, of hot pages, resident cold pages and non-resident
+    // cold pages in their test period. Nodes are frames, then num_frames + ghost
+    // slot. Resident cold pages are also queued in ring order on lru_prev/lru_next
+    // (head at num_frames), so the cold hand steps over cold pages only. Accesses
+    // only set the frame's reference bit, as for Clock.
+    uint32_t *cp_prev;
+    uint32_t *cp_next;
+    uint8_t *cp_state;         // Per node: hot, cold, cold in test, non-resident or none
+    uint32_t cp_hand[CP_HANDS];
+    uint32_t cp_hot_count;
+    uint32_t cp_cold_count;    // Resident cold pages
+    uint32_t cp_cold_target;   // m_c: adapted as test periods end in a hit or run out
+    GhostPage *cp_ghosts;      // Non-resident slots (pid and vpn only)
+    uint32_t cp_ghost_count;
+    uint32_t cp_ghost_free;    // Unused slots, chained through next
+    PageMap *cp_ghost_map;     // (pid, vpn) -> ghost slot
+    bool cp_fault_test;        // The faulting page was in its test period
+    uint64_t cp_moves[CP_HANDS]; // Entries each hand has passed
 } ReplacementPolicy;
 
 // Policy creation and destruction
 ReplacementPolicy *replacement_create(ReplacementAlgorithm algo, uint32_t num_frames);
 void replacement_destroy(ReplacementPolicy *policy);
 
-// Set trace for OPT algorithm
-void replacement_set_trace(ReplacementPolicy *policy, Trace *trace);
+// Set trace for OPT algorithm and run its next-use pre-pass
+bool replacement_set_trace(ReplacementPolicy *policy, Trace *trace, uint32_t page_size);
 void replacement_set_position(ReplacementPolicy *policy, uint64_t index);
 
+// OPT without the trace in memory: first_use maps every page to its first
+// access (the policy takes it over), and each access then reports its own
+// next use as the replay reaches it
+void replacement_set_first_uses(ReplacementPolicy *policy, PageMap *first_use,
+                                uint32_t page_size);
+void replacement_advance(ReplacementPolicy *policy, uint64_t index, uint32_t pid, uint64_t vpn,
+                         uint64_t next_use);
+
+// A fault for (pid, vpn) is about to reclaim and allocate (ARC adapts on ghost hits)
+void replacement_on_fault(ReplacementPolicy *policy, uint32_t pid, uint64_t vpn);
+
 // Victim selection - returns frame number to evict
 int32_t replacement_select_victim(ReplacementPolicy *policy, FrameAllocator *allocator);
 
+// Batch victim selection: up to k distinct frames in one pass, best victim first.
+// Returns the number of frames written to out.
+uint32_t replacement_select_victims(ReplacementPolicy *policy, FrameAllocator *allocator,
+                                    uint32_t *out, uint32_t k);
+
 // Update policy state on memory access
 void replacement_on_access(ReplacementPolicy *policy, uint32_t frame_num, FrameAllocator *allocator);
-void replacement_on_allocate(ReplacementPolicy *policy, uint32_t frame_num);
+void replacement_on_allocate(ReplacementPolicy *policy, uint32_t frame_num,
+                             FrameAllocator *allocator);
 void replacement_on_free(ReplacementPolicy *policy, uint32_t frame_num);
 
+// A page moved to another frame (THP collapse) keeps its replacement position
+void replacement_on_move(ReplacementPolicy *policy, uint32_t from, uint32_t to,
+                         FrameAllocator *allocator);
+
+// Speculatively loaded pages enter at the lowest priority and are promoted on first use
+void replacement_on_readahead(ReplacementPolicy *policy, uint32_t frame_num,
+                              FrameAllocator *allocator);
+void replacement_on_readahead_hit(ReplacementPolicy *policy, uint32_t frame_num);
+
 // Algorithm name for reporting
 const char *replacement_get_name(ReplacementAlgorithm algo);
 
@@ -0,0 +1,147 @@
+/**
+ * simclock.c - Simulated-time engine implementation
+ */
+
+#include "simclock.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMCLOCK_INITIAL_EVENTS 64
+
+SimClock *simclock_create(void)
+{
+    SimClock *clock = calloc(1, sizeof(SimClock));
+    if (!clock) {
+        LOG_ERROR_MSG("Failed to allocate simulated clock");
+        return NULL;
+    }
+
+    clock->capacity = SIMCLOCK_INITIAL_EVENTS;
+    clock->events = malloc(clock->capacity * sizeof(SimEvent));
+    if (!clock->events) {
+        LOG_ERROR_MSG("Failed to allocate event queue");
+        free(clock);
+        return NULL;
+    }
+
+    return clock;
+}
+
+void simclock_destroy(SimClock *clock)
+{
+    if (!clock)
+        return;
+    free(clock->events);
+    free(clock);
+}
+
+static inline bool event_before(const SimEvent *a, const SimEvent *b)
+{
+    return a->time_ns < b->time_ns || (a->time_ns == b->time_ns && a->seq < b->seq);
+}
+
+static void heap_sift_up(SimClock *clock, uint32_t i)
+{
+    SimEvent ev = clock->events[i];
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!event_before(&ev, &clock->events[parent]))
+            break;
+        clock->events[i] = clock->events[parent];
+        i = parent;
+    }
+    clock->events[i] = ev;
+}
+
+static void heap_sift_down(SimClock *clock, uint32_t i)
+{
+    SimEvent ev = clock->events[i];
+    uint32_t n = clock->num_events;
+    while (1) {
+        uint32_t child = 2 * i + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && event_before(&clock->events[child + 1], &clock->events[child]))
+            child++;
+        if (!event_before(&clock->events[child], &ev))
+            break;
+        clock->events[i] = clock->events[child];
+        i = child;
+    }
+    clock->events[i] = ev;
+}
+
+bool simclock_schedule(SimClock *clock, uint64_t time_ns, SimEventFn fn, void *ctx,
+                       uint64_t arg)
+{
+    if (!clock || !fn)
+        return false;
+
+    if (clock->num_events == clock->capacity) {
+        uint32_t new_capacity = clock->capacity * 2;
+        SimEvent *new_events = realloc(clock->events, new_capacity * sizeof(SimEvent));
+        if (!new_events) {
+            LOG_ERROR_MSG("Failed to grow event queue");
+            return false;
+        }
+        clock->events = new_events;
+        clock->capacity = new_capacity;
+    }
+
+    SimEvent *ev = &clock->events[clock->num_events];
+    ev->time_ns = time_ns;
+    ev->seq = clock->next_seq++;
+    ev->fn = fn;
+    ev->ctx = ctx;
+    ev->arg = arg;
+    heap_sift_up(clock, clock->num_events++);
+    return true;
+}
+
+uint64_t simclock_next_event_time(const SimClock *clock)
+{
+    if (!clock || clock->num_events == 0)
+        return UINT64_MAX;
+    return clock->events[0].time_ns;
+}
+
+// Pop and fire events due at or before limit_ns
+static void fire_due_events(SimClock *clock, uint64_t limit_ns)
+{
+    while (clock->num_events > 0 && clock->events[0].time_ns <= limit_ns) {
+        SimEvent ev = clock->events[0];
+        clock->events[0] = clock->events[--clock->num_events];
+        if (clock->num_events > 0)
+            heap_sift_down(clock, 0);
+
+        // Events never move time backwards
+        if (ev.time_ns > clock->now_ns)
+            clock->now_ns = ev.time_ns;
+        clock->events_fired++;
+        ev.fn(ev.ctx, ev.arg, clock->now_ns);
+    }
+}
+
+void simclock_advance_to(SimClock *clock, uint64_t time_ns)
+{
+    if (!clock)
+        return;
+    fire_due_events(clock, time_ns);
+    if (time_ns > clock->now_ns)
+        clock->now_ns = time_ns;
+}
+
+void simclock_advance(SimClock *clock, uint64_t delta_ns)
+{
+    if (!clock)
+        return;
+    simclock_advance_to(clock, clock->now_ns + delta_ns);
+}
+
+void simclock_drain(SimClock *clock)
+{
+    if (!clock)
+        return;
+    fire_due_events(clock, UINT64_MAX);
+}
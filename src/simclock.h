@@ -0,0 +1,63 @@
+/**
+ * simclock.h - Deterministic simulated-time engine
+ *
+ * Logical clock (nanoseconds) advanced by modeled costs, plus a min-heap
+ * event queue for work that completes in the future (e.g. swap I/O).
+ * No host clock is consulted, so results are reproducible run to run.
+ */
+
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Event callback: invoked when the clock reaches the event time
+typedef void (*SimEventFn)(void *ctx, uint64_t arg, uint64_t time_ns);
+
+// Scheduled event
+typedef struct {
+    uint64_t time_ns;  // Firing time
+    uint64_t seq;      // Insertion order (tie-break for determinism)
+    SimEventFn fn;
+    void *ctx;
+    uint64_t arg;
+} SimEvent;
+
+// Simulated clock with event queue
+typedef struct {
+    uint64_t now_ns;       // Current logical time
+    SimEvent *events;      // Binary min-heap ordered by (time_ns, seq)
+    uint32_t num_events;
+    uint32_t capacity;
+    uint64_t next_seq;
+    uint64_t events_fired; // Statistics
+} SimClock;
+
+// Clock lifecycle
+SimClock *simclock_create(void);
+void simclock_destroy(SimClock *clock);
+
+// Current time
+static inline uint64_t simclock_now(const SimClock *clock)
+{
+    return clock ? clock->now_ns : 0;
+}
+
+// Advance time by delta, firing any events that fall due
+void simclock_advance(SimClock *clock, uint64_t delta_ns);
+
+// Advance time to an absolute point (no-op if already past it)
+void simclock_advance_to(SimClock *clock, uint64_t time_ns);
+
+// Schedule an event; events in the past fire on the next advance
+bool simclock_schedule(SimClock *clock, uint64_t time_ns, SimEventFn fn, void *ctx,
+                       uint64_t arg);
+
+// Fire all pending events, advancing the clock to the last one
+void simclock_drain(SimClock *clock);
+
+// Time of the earliest pending event (UINT64_MAX if none)
+uint64_t simclock_next_event_time(const SimClock *clock);
+
+#endif // SIMCLOCK_H
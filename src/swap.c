@@ -2,49 +2,66 @@
  * swap.c - Swap/backing store implementation
  */
 
+#define _GNU_SOURCE // O_DIRECT, preadv/pwritev
+
 #include "swap.h"
 #include "util.h"
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 
-// Simulated swap I/O latency (microseconds)
-#define SWAP_IO_LATENCY_US 5000
-
-SwapManager *swap_create(uint32_t num_slots)
+SwapManager *swap_create(uint32_t num_slots, SwapDevice *device, uint32_t batch_pages)
 {
-    SwapManager *swap = malloc(sizeof(SwapManager));
+    SwapManager *swap = calloc(1, sizeof(SwapManager));
     if (!swap) {
         LOG_ERROR_MSG("Failed to allocate swap manager");
+        swapdev_destroy(device);
         return NULL;
     }
 
+    if (batch_pages == 0)
+        batch_pages = 1;
+    if (batch_pages > SWAP_MAX_BATCH_PAGES)
+        batch_pages = SWAP_MAX_BATCH_PAGES;
+
+    swap->device = device;
+    swap->fd = -1;
     swap->total_slots = num_slots;
     swap->used_slots = 0;
     swap->swap_in_count = 0;
     swap->swap_out_count = 0;
+    swap->num_clusters = (num_slots + SWAP_CLUSTER_PAGES - 1) / SWAP_CLUSTER_PAGES;
+    swap->batch_capacity = batch_pages;
 
     swap->slots = calloc(num_slots, sizeof(SwapSlot));
-    if (!swap->slots) {
+    swap->cluster_used = calloc(swap->num_clusters, sizeof(uint16_t));
+    swap->cluster_pid = calloc(swap->num_clusters, sizeof(uint32_t));
+    swap->cluster_base = calloc(swap->num_clusters, sizeof(uint64_t));
+    swap->free_clusters = malloc(swap->num_clusters * sizeof(uint32_t));
+    swap->free_cluster_pos = malloc(swap->num_clusters * sizeof(uint32_t));
+    swap->cluster_map = pagemap_create(swap->num_clusters);
+    swap->batch_slots = malloc(batch_pages * sizeof(uint32_t));
+    if (!swap->slots || !swap->cluster_used || !swap->cluster_pid || !swap->cluster_base ||
+        !swap->free_clusters || !swap->free_cluster_pos || !swap->cluster_map ||
+        !swap->batch_slots) {
         LOG_ERROR_MSG("Failed to allocate swap slots");
-        free(swap);
+        swap_destroy(swap);
         return NULL;
     }
 
-    swap->free_list = malloc(num_slots * sizeof(uint32_t));
-    if (!swap->free_list) {
-        LOG_ERROR_MSG("Failed to allocate swap free list");
-        free(swap->slots);
-        free(swap);
-        return NULL;
+    // Lowest clusters on top so the swap area fills from the start of the device
+    for (uint32_t i = 0; i < swap->num_clusters; i++) {
+        swap->free_clusters[i] = swap->num_clusters - 1 - i;
+        swap->free_cluster_pos[swap->num_clusters - 1 - i] = i;
     }
+    swap->free_clusters_top = swap->num_clusters;
 
-    // Initialize free list
-    for (uint32_t i = 0; i < num_slots; i++) {
-        swap->free_list[i] = i;
-    }
-    swap->free_list_top = num_slots;
-
-    LOG_INFO_MSG("Swap manager created: %u slots (%u MB)", num_slots, num_slots * 4 / 1024);
+    LOG_INFO_MSG("Swap manager created: %u slots (%u MB), %u clusters, batch %u pages", num_slots,
+                 num_slots * 4 / 1024, swap->num_clusters, batch_pages);
     return swap;
 }
 
@@ -52,25 +69,263 @@ void swap_destroy(SwapManager *swap)
 {
     if (!swap)
         return;
-    free(swap->free_list);
+    if (swap->fd >= 0) {
+        swap_flush(swap, 0);
+        close(swap->fd);
+    }
+    free(swap->batch_buf);
+    free(swap->batch_slots);
+    swapdev_destroy(swap->device);
+    pagemap_destroy(swap->cluster_map);
+    free(swap->free_cluster_pos);
+    free(swap->free_clusters);
+    free(swap->cluster_base);
+    free(swap->cluster_pid);
+    free(swap->cluster_used);
     free(swap->slots);
     free(swap);
 }
 
-int32_t swap_alloc(SwapManager *swap, uint32_t pid, uint64_t vpn)
+bool swap_attach_file(SwapManager *swap, const char *path, uint32_t page_size, bool direct_io)
 {
-    if (!swap || swap->free_list_top == 0) {
-        LOG_ERROR_MSG("Swap space exhausted");
+    if (!swap || !path || page_size == 0) {
+        return false;
+    }
+
+    int flags = O_RDWR | O_CREAT;
+    int fd = open(path, direct_io ? flags | O_DIRECT : flags, 0600);
+    if (fd < 0 && direct_io && errno == EINVAL) {
+        LOG_WARN_MSG("O_DIRECT not supported for %s, using buffered I/O", path);
+        direct_io = false;
+        fd = open(path, flags, 0600);
+    }
+    if (fd < 0) {
+        LOG_ERROR_MSG("Failed to open swap file %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    // Regular files are grown (sparsely) to cover every slot; devices must be big enough
+    uint64_t needed = (uint64_t)swap->total_slots * page_size;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        LOG_ERROR_MSG("Failed to stat swap file %s: %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+    if (S_ISBLK(st.st_mode)) {
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size < 0 || (uint64_t)size < needed) {
+            LOG_ERROR_MSG("Swap device %s is smaller than %lu bytes", path, needed);
+            close(fd);
+            return false;
+        }
+    } else if ((uint64_t)st.st_size < needed && ftruncate(fd, (off_t)needed) != 0) {
+        LOG_ERROR_MSG("Failed to size swap file %s: %s", path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    // Staging pages must satisfy O_DIRECT alignment
+    size_t align = page_size < 4096 ? 4096 : page_size;
+    swap->batch_buf =
+        aligned_alloc(align, align_up((uint64_t)swap->batch_capacity * page_size, align));
+    if (!swap->batch_buf) {
+        LOG_ERROR_MSG("Failed to allocate swap write batch");
+        close(fd);
+        return false;
+    }
+
+    swap->fd = fd;
+    swap->page_size = page_size;
+    swap->io.enabled = true;
+    swap->io.direct_io = direct_io;
+
+    LOG_INFO_MSG("Swap backed by %s (%lu MB%s)", path, needed / (1024 * 1024),
+                 direct_io ? ", O_DIRECT" : "");
+    return true;
+}
+
+// Position of slot in the pending write batch, or -1
+static int32_t batch_find(SwapManager *swap, uint32_t slot)
+{
+    if (!swap->slots[slot].staged)
         return -1;
+    for (uint32_t i = 0; i < swap->batch_count; i++) {
+        if (swap->batch_slots[i] == slot)
+            return (int32_t)i;
+    }
+    return -1;
+}
+
+static uint8_t *batch_page(SwapManager *swap, uint32_t index)
+{
+    return swap->batch_buf + (uint64_t)index * swap->page_size;
+}
+
+// Drop a staged page (its contents are no longer needed)
+static void batch_remove(SwapManager *swap, uint32_t index)
+{
+    swap->slots[swap->batch_slots[index]].staged = false;
+    uint32_t last = --swap->batch_count;
+    if (index != last) {
+        if (swap->batch_buf)
+            memcpy(batch_page(swap, index), batch_page(swap, last), swap->page_size);
+        swap->batch_slots[index] = swap->batch_slots[last];
+    }
+}
+
+static bool write_run(SwapManager *swap, struct iovec *iov, uint32_t count, uint32_t first_slot)
+{
+    off_t offset = (off_t)first_slot * swap->page_size;
+    ssize_t expected = (ssize_t)count * swap->page_size;
+
+    uint64_t start = get_monotonic_ns();
+    ssize_t written = pwritev(swap->fd, iov, (int)count, offset);
+    uint64_t elapsed = get_monotonic_ns() - start;
+
+    swap->io.write_calls++;
+    swap->io.write_time_ns += elapsed;
+    histogram_record(&swap->io.write_latency, elapsed);
+
+    if (written != expected) {
+        LOG_ERROR_MSG("Swap write of %u pages at slot %u failed: %s", count, first_slot,
+                      written < 0 ? strerror(errno) : "short write");
+        return false;
+    }
+    swap->io.bytes_written += (uint64_t)written;
+    return true;
+}
+
+uint64_t swap_flush(SwapManager *swap, uint64_t now_ns)
+{
+    if (!swap || swap->batch_count == 0) {
+        return 0;
+    }
+
+    // Order staged pages by slot (insertion sort; batches are small)
+    uint32_t order[SWAP_MAX_BATCH_PAGES];
+    for (uint32_t i = 0; i < swap->batch_count; i++) {
+        uint32_t j = i;
+        while (j > 0 && swap->batch_slots[order[j - 1]] > swap->batch_slots[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    // One device request (and one vectored write) per run of contiguous slots
+    struct iovec iov[SWAP_MAX_BATCH_PAGES];
+    uint64_t done_ns = now_ns;
+    uint32_t run_start = 0;
+    for (uint32_t i = 0; i < swap->batch_count; i++) {
+        uint32_t slot = swap->batch_slots[order[i]];
+        swap->slots[slot].staged = false;
+        if (swap->fd >= 0) {
+            iov[i].iov_base = batch_page(swap, order[i]);
+            iov[i].iov_len = swap->page_size;
+        }
+
+        bool run_ends =
+            i + 1 == swap->batch_count || swap->batch_slots[order[i + 1]] != slot + 1;
+        if (run_ends) {
+            uint32_t first_slot = swap->batch_slots[order[run_start]];
+            uint32_t count = i - run_start + 1;
+            uint64_t completion = swapdev_submit(swap->device, now_ns, first_slot, count, true);
+            if (completion > done_ns)
+                done_ns = completion;
+            if (swap->fd >= 0)
+                write_run(swap, &iov[run_start], count, first_slot);
+            run_start = i + 1;
+        }
     }
 
-    uint32_t slot = swap->free_list[--swap->free_list_top];
+    LOG_TRACE_MSG("Swap flushed %u staged pages", swap->batch_count);
+    swap->batch_count = 0;
+    return done_ns - now_ns;
+}
+
+static bool read_run(SwapManager *swap, struct iovec *iov, uint32_t count, uint32_t first_slot)
+{
+    off_t offset = (off_t)first_slot * swap->page_size;
+    ssize_t expected = (ssize_t)count * swap->page_size;
+
+    uint64_t start = get_monotonic_ns();
+    ssize_t got = preadv(swap->fd, iov, (int)count, offset);
+    uint64_t elapsed = get_monotonic_ns() - start;
+
+    swap->io.read_calls++;
+    swap->io.read_time_ns += elapsed;
+    histogram_record(&swap->io.read_latency, elapsed);
+
+    if (got != expected) {
+        LOG_ERROR_MSG("Swap read of %u pages at slot %u failed: %s", count, first_slot,
+                      got < 0 ? strerror(errno) : "short read");
+        return false;
+    }
+    swap->io.bytes_read += (uint64_t)got;
+    return true;
+}
+
+static void take_slot(SwapManager *swap, uint32_t slot, uint32_t pid, uint64_t vpn)
+{
     swap->slots[slot].used = true;
     swap->slots[slot].pid = pid;
     swap->slots[slot].vpn = vpn;
+    swap->cluster_used[slot / SWAP_CLUSTER_PAGES]++;
     swap->used_slots++;
+}
+
+// Take a cluster off the free stack, from wherever it sits, by moving the top into its place
+static void cluster_claim(SwapManager *swap, uint32_t cluster)
+{
+    uint32_t pos = swap->free_cluster_pos[cluster];
+    uint32_t top = swap->free_clusters[--swap->free_clusters_top];
+    swap->free_clusters[pos] = top;
+    swap->free_cluster_pos[top] = pos;
+    swap->free_cluster_pos[cluster] = UINT32_MAX;
+}
+
+int32_t swap_alloc(SwapManager *swap, uint32_t pid, uint64_t vpn)
+{
+    if (!swap || swap->used_slots == swap->total_slots) {
+        LOG_ERROR_MSG("Swap space exhausted");
+        return -1;
+    }
+
+    // The page's home cluster: reuse the process's cluster for this VPN range or claim one
+    uint64_t base = vpn / SWAP_CLUSTER_PAGES;
+    uint64_t cluster;
+    bool have_cluster = pagemap_get(swap->cluster_map, pid, base, &cluster);
+    if (!have_cluster && swap->free_clusters_top > 0) {
+        cluster = swap->free_clusters[swap->free_clusters_top - 1];
+        cluster_claim(swap, (uint32_t)cluster);
+        swap->cluster_pid[cluster] = pid;
+        swap->cluster_base[cluster] = base;
+        pagemap_put(swap->cluster_map, pid, base, cluster);
+        have_cluster = true;
+    }
+    if (have_cluster) {
+        uint64_t slot = cluster * SWAP_CLUSTER_PAGES + vpn % SWAP_CLUSTER_PAGES;
+        if (slot < swap->total_slots && !swap->slots[slot].used) {
+            take_slot(swap, (uint32_t)slot, pid, vpn);
+            LOG_TRACE_MSG("Swap allocated slot %lu for PID=%u VPN=0x%lx", slot, pid, vpn);
+            return (int32_t)slot;
+        }
+    }
+
+    // Every cluster is claimed or the home slot is taken: take any free slot. One in an
+    // empty cluster claims that cluster, with no owner, until the cluster empties again
+    uint32_t slot = swap->scan_cursor;
+    while (swap->slots[slot].used) {
+        slot = slot + 1 == swap->total_slots ? 0 : slot + 1;
+    }
+    swap->scan_cursor = slot;
+    swap->cluster_fallbacks++;
+    if (swap->free_cluster_pos[slot / SWAP_CLUSTER_PAGES] != UINT32_MAX)
+        cluster_claim(swap, slot / SWAP_CLUSTER_PAGES);
+    take_slot(swap, slot, pid, vpn);
 
-    LOG_TRACE_MSG("Swap allocated slot %u for PID=%u VPN=0x%lx", slot, pid, vpn);
+    LOG_TRACE_MSG("Swap allocated slot %u (fallback) for PID=%u VPN=0x%lx", slot, pid, vpn);
     return (int32_t)slot;
 }
 
@@ -80,40 +335,128 @@ bool swap_free(SwapManager *swap, uint32_t slot)
         return false;
     }
 
+    // A freed slot's staged contents never need to reach the device
+    int32_t index = batch_find(swap, slot);
+    if (index >= 0)
+        batch_remove(swap, (uint32_t)index);
+
     swap->slots[slot].used = false;
-    swap->free_list[swap->free_list_top++] = slot;
     swap->used_slots--;
 
+    // Return the cluster once its last slot is gone
+    uint32_t cluster = slot / SWAP_CLUSTER_PAGES;
+    if (--swap->cluster_used[cluster] == 0 && swap->free_cluster_pos[cluster] == UINT32_MAX) {
+        uint64_t mapped;
+        if (pagemap_get(swap->cluster_map, swap->cluster_pid[cluster],
+                        swap->cluster_base[cluster], &mapped) &&
+            mapped == cluster) {
+            pagemap_remove(swap->cluster_map, swap->cluster_pid[cluster],
+                           swap->cluster_base[cluster]);
+        }
+        swap->free_cluster_pos[cluster] = swap->free_clusters_top;
+        swap->free_clusters[swap->free_clusters_top++] = cluster;
+    }
+
     LOG_TRACE_MSG("Swap freed slot %u", slot);
     return true;
 }
 
-uint64_t swap_out(SwapManager *swap, uint32_t slot, void *data)
+uint64_t swap_out(SwapManager *swap, uint32_t slot, void *data, uint64_t now_ns)
 {
     if (!swap || slot >= swap->total_slots) {
         return 0;
     }
 
-    // Simulate writing page to disk (data parameter unused in simulation)
-    (void)data;
+    // Stage the page; real-data mode keeps a copy since the frame is reused at once
+    int32_t index = batch_find(swap, slot);
+    if (index < 0) {
+        index = (int32_t)swap->batch_count++;
+        swap->batch_slots[index] = slot;
+        swap->slots[slot].staged = true;
+    }
+    if (swap->fd >= 0 && data) {
+        memcpy(batch_page(swap, (uint32_t)index), data, swap->page_size);
+    }
     swap->swap_out_count++;
 
     LOG_TRACE_MSG("Swap out to slot %u (total swap-outs: %lu)", slot, swap->swap_out_count);
-    return SWAP_IO_LATENCY_US;
+
+    // Only the eviction that fills the batch waits for the write-back
+    if (swap->batch_count == swap->batch_capacity) {
+        return swap_flush(swap, now_ns);
+    }
+    return 0;
 }
 
-uint64_t swap_in(SwapManager *swap, uint32_t slot, void *data)
+uint64_t swap_in(SwapManager *swap, uint32_t slot, void *data, uint64_t now_ns)
 {
     if (!swap || slot >= swap->total_slots) {
         return 0;
     }
 
-    // Simulate reading page from disk (data parameter unused in simulation)
-    (void)data;
-    swap->swap_in_count++;
+    // Still staged: the write has not reached the device, so no read is needed
+    int32_t index = batch_find(swap, slot);
+    if (index >= 0) {
+        if (swap->fd >= 0 && data)
+            memcpy(data, batch_page(swap, (uint32_t)index), swap->page_size);
+        swap->device->stats.batch_hits++;
+        swap->swap_in_count++;
+        LOG_TRACE_MSG("Swap in from slot %u served by the write batch", slot);
+        return 0;
+    }
+
+    LOG_TRACE_MSG("Swap in from slot %u (total swap-ins: %lu)", slot, swap->swap_in_count + 1);
+    return swap_in_cluster(swap, &slot, &data, 1, 0, now_ns);
+}
 
-    LOG_TRACE_MSG("Swap in from slot %u (total swap-ins: %lu)", slot, swap->swap_in_count);
-    return SWAP_IO_LATENCY_US;
+uint64_t swap_in_cluster(SwapManager *swap, const uint32_t *slots, void *const *data,
+                         uint32_t count, uint32_t target, uint64_t now_ns)
+{
+    if (!swap || count == 0 || target >= count) {
+        return 0;
+    }
+
+    struct iovec iov[SWAP_MAX_BATCH_PAGES];
+    uint64_t target_done = now_ns;
+    uint32_t run_start = 0;
+    for (uint32_t i = 0; i < count && i < SWAP_MAX_BATCH_PAGES; i++) {
+        // Real-data mode reads the pages; simulation only models the timing
+        if (swap->fd >= 0) {
+            iov[i].iov_base = data[i];
+            iov[i].iov_len = swap->page_size;
+        }
+
+        bool run_ends = i + 1 == count || slots[i + 1] != slots[i] + 1;
+        if (run_ends) {
+            uint32_t run_count = i - run_start + 1;
+            uint64_t completion =
+                swapdev_submit(swap->device, now_ns, slots[run_start], run_count, false);
+            if (target >= run_start && target <= i)
+                target_done = completion;
+            if (swap->fd >= 0)
+                read_run(swap, &iov[run_start], run_count, slots[run_start]);
+            run_start = i + 1;
+        }
+    }
+    swap->swap_in_count += count;
+
+    return target_done - now_ns;
+}
+
+bool swap_slot_on_device(SwapManager *swap, uint32_t slot, uint32_t *pid, uint64_t *vpn)
+{
+    if (!swap || slot >= swap->total_slots || !swap->slots[slot].used ||
+        swap->slots[slot].staged) {
+        return false;
+    }
+    *pid = swap->slots[slot].pid;
+    *vpn = swap->slots[slot].vpn;
+    return true;
+}
+
+bool swap_is_staged(SwapManager *swap, uint32_t slot)
+{
+    return swap && slot < swap->total_slots && swap->slots[slot].staged;
 }
 
 uint32_t swap_get_used_count(SwapManager *swap)
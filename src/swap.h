@@ -2,7 +2,9 @@
  * swap.h - Backing store (swap space) simulation
  * 
  * Simulates disk-based storage for paged-out memory.
- * Tracks swap slots and simulates I/O latency.
+ * Tracks swap slots; I/O timing comes from the attached swap device model.
+ * Slots are handed out in per-process clusters so neighboring pages stay
+ * adjacent on the device, and dirty pages are written back in batches.
  */
 
 #ifndef SWAP_H
@@ -10,10 +12,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "swapdev.h"
+#include "pagemap.h"
+
+// Slots per allocation cluster: a process's VPNs within one aligned
+// cluster-sized range share a cluster, at slot = cluster * N + vpn % N
+#define SWAP_CLUSTER_PAGES 32
+
+// Upper bound on pages per write batch (one vectored write stays under IOV_MAX)
+#define SWAP_MAX_BATCH_PAGES 1024
 
 // Swap slot metadata
 typedef struct {
     bool used;
+    bool staged;              // Waiting in the write batch
     uint32_t pid;
     uint64_t vpn;
 } SwapSlot;
@@ -23,23 +35,64 @@ typedef struct {
     uint32_t total_slots;     // Total swap slots available
     uint32_t used_slots;      // Currently used slots
     SwapSlot *slots;          // Slot metadata
-    uint32_t *free_list;      // Free slot stack
-    uint32_t free_list_top;
+
+    // Cluster allocation
+    uint32_t num_clusters;
+    uint16_t *cluster_used;   // Used slots per cluster
+    uint32_t *cluster_pid;    // Owner key of each assigned cluster
+    uint64_t *cluster_base;   // Owner's VPN / SWAP_CLUSTER_PAGES
+    uint32_t *free_clusters;  // Stack of empty clusters
+    uint32_t *free_cluster_pos; // Each cluster's stack position, UINT32_MAX when not on it
+    uint32_t free_clusters_top;
+    PageMap *cluster_map;     // (pid, vpn / SWAP_CLUSTER_PAGES) -> cluster
+    uint32_t scan_cursor;     // Fallback search position once clusters run out
+    uint64_t cluster_fallbacks;
+
     uint64_t swap_in_count;   // Statistics
     uint64_t swap_out_count;
+    SwapDevice *device;       // Timing model (owned)
+
+    // Write-back batch: dirty victims wait here and go out as sorted runs
+    uint32_t *batch_slots;    // Slot of each staged page
+    uint32_t batch_count;
+    uint32_t batch_capacity;
+
+    // Real-data backing (file or block device); fd < 0 when simulating only
+    int fd;
+    uint32_t page_size;
+    uint8_t *batch_buf;       // Page-aligned copies of the staged pages
+    RealIOMetrics io;         // Measured host I/O
 } SwapManager;
 
-// Swap operations
-SwapManager *swap_create(uint32_t num_slots);
+// Swap operations (takes ownership of device)
+SwapManager *swap_create(uint32_t num_slots, SwapDevice *device, uint32_t batch_pages);
 void swap_destroy(SwapManager *swap);
 
+// Real-data mode: back slots with a file or block device at slot * page_size
+bool swap_attach_file(SwapManager *swap, const char *path, uint32_t page_size, bool direct_io);
+
+// Write out every staged page, one device request per contiguous run.
+// Returns the simulated time until the last run completes.
+uint64_t swap_flush(SwapManager *swap, uint64_t now_ns);
+
 // Allocate and free swap slots
 int32_t swap_alloc(SwapManager *swap, uint32_t pid, uint64_t vpn);
 bool swap_free(SwapManager *swap, uint32_t slot);
 
-// Swap I/O simulation (returns simulated latency in microseconds)
-uint64_t swap_out(SwapManager *swap, uint32_t slot, void *data);
-uint64_t swap_in(SwapManager *swap, uint32_t slot, void *data);
+// Swap I/O simulation: submitted at now_ns, returns simulated latency in nanoseconds.
+// swap_out only waits when its page fills the batch and triggers a flush.
+uint64_t swap_out(SwapManager *swap, uint32_t slot, void *data, uint64_t now_ns);
+uint64_t swap_in(SwapManager *swap, uint32_t slot, void *data, uint64_t now_ns);
+
+// Read several slots (ascending, none staged) with one request per contiguous run.
+// Returns the latency of the run holding slots[target]; the other runs complete
+// asynchronously.
+uint64_t swap_in_cluster(SwapManager *swap, const uint32_t *slots, void *const *data,
+                         uint32_t count, uint32_t target, uint64_t now_ns);
+
+// Owner of a slot whose contents live only on the device (used and not staged)
+bool swap_slot_on_device(SwapManager *swap, uint32_t slot, uint32_t *pid, uint64_t *vpn);
+bool swap_is_staged(SwapManager *swap, uint32_t slot);
 
 // Statistics
 uint32_t swap_get_used_count(SwapManager *swap);
@@ -0,0 +1,244 @@
+/**
+ * swapdev.c - Swap device timing model implementation
+ */
+
+#include "swapdev.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+
+// Built-in profiles (typical datasheet figures)
+static const SwapDeviceProfile profiles[] = {
+    [SWAPDEV_FIXED] = {"FIXED", 0, 0, 0, 0, 0, 0, 0, 0},
+    [SWAPDEV_HDD] = {"HDD", 32, 1, 100000, 100000, 500000, 15000000, 4170000,
+                     150ULL * 1000 * 1000},
+    [SWAPDEV_SATA_SSD] = {"SATA_SSD", 32, 8, 90000, 60000, 0, 0, 0, 530ULL * 1000 * 1000},
+    [SWAPDEV_NVME] = {"NVME", 256, 32, 20000, 15000, 0, 0, 0, 3000ULL * 1000 * 1000},
+    [SWAPDEV_ZRAM] = {"ZRAM", 64, 4, 2000, 5000, 0, 0, 0, 2000ULL * 1000 * 1000},
+};
+
+#define NUM_PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+SwapDevice *swapdev_create(SwapDeviceType type, uint32_t queue_depth, uint32_t page_size,
+                           uint32_t total_slots, uint64_t fixed_latency_ns)
+{
+    if ((uint32_t)type >= NUM_PROFILES) {
+        LOG_ERROR_MSG("Unknown swap device type %d", type);
+        return NULL;
+    }
+
+    SwapDevice *dev = calloc(1, sizeof(SwapDevice));
+    if (!dev) {
+        LOG_ERROR_MSG("Failed to allocate swap device");
+        return NULL;
+    }
+
+    dev->type = type;
+    dev->profile = profiles[type];
+    dev->page_size = page_size;
+    dev->total_slots = total_slots ? total_slots : 1;
+
+    if (type == SWAPDEV_FIXED) {
+        dev->profile.read_latency_ns = fixed_latency_ns;
+        dev->profile.write_latency_ns = fixed_latency_ns;
+    }
+    if (queue_depth > 0) {
+        dev->profile.queue_depth = queue_depth;
+    }
+    // Unlimited parallelism means every outstanding request has its own channel
+    if (dev->profile.channels == 0) {
+        dev->profile.channels = 1;
+    }
+
+    dev->channel_free_at = calloc(dev->profile.channels, sizeof(uint64_t));
+    dev->inflight_capacity = dev->profile.queue_depth ? dev->profile.queue_depth : 64;
+    dev->inflight = malloc(dev->inflight_capacity * sizeof(uint64_t));
+    if (!dev->channel_free_at || !dev->inflight) {
+        LOG_ERROR_MSG("Failed to allocate swap device queues");
+        swapdev_destroy(dev);
+        return NULL;
+    }
+
+    dev->stats.device_name = dev->profile.name;
+    dev->stats.queue_depth = dev->profile.queue_depth;
+
+    LOG_INFO_MSG("Swap device created: %s (QD %u, %u channels)", dev->profile.name,
+                 dev->profile.queue_depth, dev->profile.channels);
+    return dev;
+}
+
+void swapdev_destroy(SwapDevice *dev)
+{
+    if (!dev)
+        return;
+    free(dev->channel_free_at);
+    free(dev->inflight);
+    free(dev);
+}
+
+// In-flight completion heap (min at index 0)
+static void inflight_pop(SwapDevice *dev)
+{
+    uint64_t last = dev->inflight[--dev->num_inflight];
+    uint32_t i = 0;
+    uint32_t n = dev->num_inflight;
+    while (2 * i + 1 < n) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < n && dev->inflight[child + 1] < dev->inflight[child])
+            child++;
+        if (dev->inflight[child] >= last)
+            break;
+        dev->inflight[i] = dev->inflight[child];
+        i = child;
+    }
+    if (n > 0)
+        dev->inflight[i] = last;
+}
+
+static bool inflight_push(SwapDevice *dev, uint64_t completion)
+{
+    if (dev->num_inflight == dev->inflight_capacity) {
+        uint32_t new_capacity = dev->inflight_capacity * 2;
+        uint64_t *grown = realloc(dev->inflight, new_capacity * sizeof(uint64_t));
+        if (!grown) {
+            LOG_ERROR_MSG("Failed to grow swap device queue");
+            return false;
+        }
+        dev->inflight = grown;
+        dev->inflight_capacity = new_capacity;
+    }
+
+    uint32_t i = dev->num_inflight++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (dev->inflight[parent] <= completion)
+            break;
+        dev->inflight[i] = dev->inflight[parent];
+        i = parent;
+    }
+    dev->inflight[i] = completion;
+    return true;
+}
+
+// HDD positioning time: seek grows with the square root of the distance
+static uint64_t hdd_position_ns(SwapDevice *dev, uint32_t slot)
+{
+    if (slot == dev->head_slot)
+        return 0; // Sequential: head already in place
+
+    uint32_t distance = slot > dev->head_slot ? slot - dev->head_slot : dev->head_slot - slot;
+    double fraction = sqrt((double)distance / dev->total_slots);
+    uint64_t seek = dev->profile.min_seek_ns +
+                    (uint64_t)((dev->profile.max_seek_ns - dev->profile.min_seek_ns) * fraction);
+    return seek + dev->profile.rotation_ns;
+}
+
+uint64_t swapdev_submit(SwapDevice *dev, uint64_t now_ns, uint32_t slot, uint32_t num_pages,
+                        bool is_write)
+{
+    if (!dev || num_pages == 0)
+        return now_ns;
+
+    // Retire requests that completed before this submission
+    while (dev->num_inflight > 0 && dev->inflight[0] <= now_ns) {
+        inflight_pop(dev);
+    }
+
+    // A full queue delays admission until the earliest outstanding request completes
+    uint64_t admit = now_ns;
+    if (dev->profile.queue_depth > 0 && dev->num_inflight >= dev->profile.queue_depth) {
+        admit = dev->inflight[0];
+        inflight_pop(dev);
+        dev->stats.queue_full_waits++;
+    }
+
+    // Service on the channel that frees up first
+    uint32_t channel = 0;
+    if (dev->type != SWAPDEV_FIXED) {
+        for (uint32_t c = 1; c < dev->profile.channels; c++) {
+            if (dev->channel_free_at[c] < dev->channel_free_at[channel])
+                channel = c;
+        }
+    }
+    uint64_t start = admit;
+    if (dev->type != SWAPDEV_FIXED && dev->channel_free_at[channel] > start) {
+        start = dev->channel_free_at[channel];
+    }
+
+    uint64_t service = is_write ? dev->profile.write_latency_ns : dev->profile.read_latency_ns;
+    if (dev->type == SWAPDEV_HDD) {
+        service += hdd_position_ns(dev, slot);
+    }
+
+    // Every page after the first rides along without positioning, as does a request that
+    // continues where the previous one ended
+    uint64_t sequential = dev->stats.requests > 0 && slot == dev->head_slot;
+    dev->stats.seeks_avoided += num_pages - 1 + sequential;
+    dev->head_slot = slot + num_pages;
+
+    // Data transfer shares the device bandwidth with every other request
+    uint64_t bytes = (uint64_t)num_pages * dev->page_size;
+    uint64_t completion = start + service;
+    if (dev->profile.bandwidth_bps > 0) {
+        uint64_t transfer_ns = bytes * 1000000000ULL / dev->profile.bandwidth_bps;
+        uint64_t transfer_start =
+            completion > dev->bandwidth_free_at ? completion : dev->bandwidth_free_at;
+        completion = transfer_start + transfer_ns;
+        dev->bandwidth_free_at = completion;
+    }
+    if (dev->type != SWAPDEV_FIXED) {
+        dev->channel_free_at[channel] = completion;
+    }
+
+    inflight_push(dev, completion);
+
+    // Statistics
+    uint64_t latency = completion - now_ns;
+    dev->stats.requests++;
+    if (is_write)
+        dev->stats.writes++;
+    else
+        dev->stats.reads++;
+    dev->stats.pages += num_pages;
+    dev->stats.bytes += bytes;
+    dev->stats.total_latency_ns += latency;
+    if (dev->num_inflight > dev->stats.max_queue_length)
+        dev->stats.max_queue_length = dev->num_inflight;
+    histogram_record(&dev->stats.latency, latency);
+
+    // Busy time is the union of [submit, completion] intervals
+    if (now_ns >= dev->busy_until) {
+        dev->stats.busy_time_ns += latency;
+        dev->busy_until = completion;
+    } else if (completion > dev->busy_until) {
+        dev->stats.busy_time_ns += completion - dev->busy_until;
+        dev->busy_until = completion;
+    }
+
+    LOG_TRACE_MSG("Swap device %s: slot %u x%u %s, latency %lu ns", dev->profile.name, slot,
+                  num_pages, is_write ? "W" : "R", latency);
+    return completion;
+}
+
+bool swapdev_parse_type(const char *name, SwapDeviceType *type)
+{
+    if (!name || !type)
+        return false;
+
+    for (uint32_t i = 0; i < NUM_PROFILES; i++) {
+        if (strcasecmp(name, profiles[i].name) == 0) {
+            *type = (SwapDeviceType)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *swapdev_get_name(SwapDeviceType type)
+{
+    if ((uint32_t)type >= NUM_PROFILES)
+        return "Unknown";
+    return profiles[type].name;
+}
@@ -0,0 +1,72 @@
+/**
+ * swapdev.h - Swap device timing model
+ *
+ * Models the backing device behind the swap area: per-request service
+ * latency, HDD seek distance, internal parallelism, a bounded request
+ * queue and transfer bandwidth shared by all outstanding requests.
+ * Requests are submitted at a simulated time and the model returns the
+ * simulated completion time.
+ */
+
+#ifndef SWAPDEV_H
+#define SWAPDEV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "metrics.h"
+
+// Device profiles
+typedef enum {
+    SWAPDEV_FIXED,    // Constant latency, unlimited parallelism (legacy model)
+    SWAPDEV_HDD,      // 7200 RPM disk: seek + rotation, one head
+    SWAPDEV_SATA_SSD, // SATA SSD behind NCQ
+    SWAPDEV_NVME,     // NVMe SSD with deep queues
+    SWAPDEV_ZRAM      // Compressed RAM: CPU-bound (de)compression
+} SwapDeviceType;
+
+// Timing parameters of a device profile
+typedef struct {
+    const char *name;
+    uint32_t queue_depth;        // Max outstanding requests (0 = unlimited)
+    uint32_t channels;           // Requests serviced in parallel
+    uint64_t read_latency_ns;    // Base service latency per request
+    uint64_t write_latency_ns;
+    uint64_t min_seek_ns;        // HDD only: track-to-track seek
+    uint64_t max_seek_ns;        // HDD only: full-stroke seek
+    uint64_t rotation_ns;        // HDD only: average rotational delay
+    uint64_t bandwidth_bps;      // Shared transfer bandwidth (0 = unlimited)
+} SwapDeviceProfile;
+
+// Device instance
+typedef struct {
+    SwapDeviceType type;
+    SwapDeviceProfile profile;
+    uint32_t page_size;
+    uint32_t total_slots;        // Seek distance normalization
+
+    uint64_t *channel_free_at;   // Per-channel busy-until time
+    uint64_t *inflight;          // Min-heap of outstanding completion times
+    uint32_t num_inflight;
+    uint32_t inflight_capacity;
+
+    uint64_t bandwidth_free_at;  // Transfer pipe busy-until time
+    uint64_t busy_until;         // Latest completion (for utilization)
+    uint32_t head_slot;          // Next sequential slot (HDD head position)
+
+    SwapDeviceMetrics stats;
+} SwapDevice;
+
+// Device lifecycle
+SwapDevice *swapdev_create(SwapDeviceType type, uint32_t queue_depth, uint32_t page_size,
+                           uint32_t total_slots, uint64_t fixed_latency_ns);
+void swapdev_destroy(SwapDevice *dev);
+
+// Submit a request covering num_pages contiguous slots; returns completion time
+uint64_t swapdev_submit(SwapDevice *dev, uint64_t now_ns, uint32_t slot, uint32_t num_pages,
+                        bool is_write);
+
+// Profile lookup
+bool swapdev_parse_type(const char *name, SwapDeviceType *type);
+const char *swapdev_get_name(SwapDeviceType type);
+
+#endif // SWAPDEV_H
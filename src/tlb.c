@@ -6,34 +6,158 @@
 #include "util.h"
 #include <stdlib.h>
 #include <string.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// ---- Tag matching: index of the first key equal to key, or n ----
+
+typedef uint32_t (*TLBMatchFn)(const uint64_t *keys, uint32_t n, uint64_t key);
+
+static uint32_t tlb_match_scalar(const uint64_t *keys, uint32_t n, uint64_t key)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (keys[i] == key)
+            return i;
+    }
+    return n;
+}
+
+#if defined(__x86_64__)
+// SSE2 has no 64-bit compare: gather the low and high halves of four keys
+// into one register each and require both to match, 8 keys per iteration
+static inline int tlb_match4_sse2(const uint64_t *keys, __m128i klo, __m128i khi)
+{
+    __m128 a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)keys));
+    __m128 b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *)keys + 1));
+    __m128i lo = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i hi = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    __m128i eq = _mm_and_si128(_mm_cmpeq_epi32(lo, klo), _mm_cmpeq_epi32(hi, khi));
+    return _mm_movemask_ps(_mm_castsi128_ps(eq));
+}
+
+static uint32_t tlb_match_sse2(const uint64_t *keys, uint32_t n, uint64_t key)
+{
+    __m128i klo = _mm_set1_epi32((int)(uint32_t)key);
+    __m128i khi = _mm_set1_epi32((int)(uint32_t)(key >> 32));
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        int mask = tlb_match4_sse2(keys + i, klo, khi) |
+                   tlb_match4_sse2(keys + i + 4, klo, khi) << 4;
+        if (mask)
+            return i + (uint32_t)__builtin_ctz((unsigned)mask);
+    }
+    return i + tlb_match_scalar(keys + i, n - i, key);
+}
+
+__attribute__((target("avx2"))) static uint32_t tlb_match_avx2(const uint64_t *keys, uint32_t n,
+                                                              uint64_t key)
+{
+    __m256i k = _mm256_set1_epi64x((long long)key);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i lo = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(keys + i)), k);
+        __m256i hi = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(keys + i + 4)), k);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo)) |
+                   _mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4;
+        if (mask)
+            return i + (uint32_t)__builtin_ctz((unsigned)mask);
+    }
+    if (i + 4 <= n) {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(keys + i)), k);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        if (mask)
+            return i + (uint32_t)__builtin_ctz((unsigned)mask);
+        i += 4;
+    }
+    return i + tlb_match_scalar(keys + i, n - i, key);
+}
+#endif
+
+static TLBMatchFn tlb_match;
+static const char *tlb_match_name = "scalar";
+
+void tlb_set_kernel(SimdLevel level)
+{
+    switch (simd_resolve(level)) {
+#if defined(__x86_64__)
+    case SIMD_AVX2:
+        tlb_match = tlb_match_avx2;
+        tlb_match_name = "AVX2";
+        break;
+    case SIMD_SSE2:
+        tlb_match = tlb_match_sse2;
+        tlb_match_name = "SSE2";
+        break;
+#endif
+    default:
+        tlb_match = tlb_match_scalar;
+        tlb_match_name = "scalar";
+        break;
+    }
+}
+
+static void tlb_select_kernel(void)
+{
+    if (!tlb_match)
+        tlb_set_kernel(SIMD_AUTO);
+}
+
+const char *tlb_kernel_name(void)
+{
+    tlb_select_kernel();
+    return tlb_match_name;
+}
 
 TLB *tlb_create(uint32_t size, TLBPolicy policy)
+{
+    return tlb_create_assoc(size, size, policy);
+}
+
+TLB *tlb_create_assoc(uint32_t size, uint32_t ways, TLBPolicy policy)
 {
     if (size == 0) {
         LOG_ERROR_MSG("TLB size must be > 0");
         return NULL;
     }
+    if (ways == 0 || ways > size || size % ways != 0) {
+        LOG_ERROR_MSG("TLB size %u is not a multiple of its associativity %u", size, ways);
+        return NULL;
+    }
+    if (policy == TLB_PLRU && (ways > 64 || !is_power_of_two(ways))) {
+        LOG_ERROR_MSG("Pseudo-LRU needs a power-of-two associativity up to 64");
+        return NULL;
+    }
+
+    tlb_select_kernel();
 
-    TLB *tlb = malloc(sizeof(TLB));
+    TLB *tlb = calloc(1, sizeof(TLB));
     if (!tlb) {
         LOG_ERROR_MSG("Failed to allocate TLB");
         return NULL;
     }
 
     tlb->size = size;
+    tlb->ways = ways;
+    tlb->sets = size / ways;
     tlb->policy = policy;
-    tlb->fifo_next = 0;
-    tlb->access_counter = 0;
 
+    // Keys on cache-line boundaries, so a set's tags come in as few lines as possible
+    size_t key_bytes = ((size_t)size * sizeof(uint64_t) + 63) & ~(size_t)63;
+    tlb->keys = aligned_alloc(64, key_bytes);
+    if (tlb->keys)
+        memset(tlb->keys, 0, key_bytes);
     tlb->entries = calloc(size, sizeof(TLBEntry));
-    if (!tlb->entries) {
+    tlb->fifo_next = calloc(tlb->sets, sizeof(uint32_t));
+    tlb->plru = calloc(tlb->sets, sizeof(uint64_t));
+    if (!tlb->keys || !tlb->entries || !tlb->fifo_next || !tlb->plru) {
         LOG_ERROR_MSG("Failed to allocate TLB entries");
-        free(tlb);
+        tlb_destroy(tlb);
         return NULL;
     }
 
-    LOG_INFO_MSG("TLB created: %u entries, policy=%s", size,
-                 policy == TLB_FIFO ? "FIFO" : "LRU");
+    LOG_INFO_MSG("TLB created: %u entries, %u-way, policy=%s, %s tag match", size, ways,
+                 tlb_policy_name(policy), tlb_match_name);
     return tlb;
 }
 
@@ -41,119 +165,269 @@ void tlb_destroy(TLB *tlb)
 {
     if (!tlb)
         return;
+    tlb_destroy(tlb->next);
+    free(tlb->keys);
     free(tlb->entries);
+    free(tlb->fifo_next);
+    free(tlb->plru);
     free(tlb);
 }
 
-bool tlb_lookup(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *pfn)
+void tlb_set_next(TLB *tlb, TLB *next)
 {
-    if (!tlb || !pfn)
-        return false;
+    if (tlb)
+        tlb->next = next;
+}
 
-    // Search for matching entry
-    for (uint32_t i = 0; i < tlb->size; i++) {
-        if (tlb->entries[i].valid && tlb->entries[i].pid == pid && tlb->entries[i].vpn == vpn) {
-            *pfn = tlb->entries[i].pfn;
+const char *tlb_policy_name(TLBPolicy policy)
+{
+    switch (policy) {
+    case TLB_FIFO:
+        return "FIFO";
+    case TLB_LRU:
+        return "LRU";
+    case TLB_PLRU:
+        return "PLRU";
+    default:
+        return "Unknown";
+    }
+}
 
-            // Update LRU timestamp
-            if (tlb->policy == TLB_LRU) {
-                tlb->entries[i].last_use_time = tlb->access_counter++;
-            }
+// Hashed set index, so strided pages and other processes spread over the sets
+static inline uint32_t tlb_set(const TLB *tlb, uint32_t pid, uint64_t tag)
+{
+    if (tlb->sets == 1)
+        return 0;
+    uint64_t h = (tag ^ ((uint64_t)pid << 32)) * 0x9e3779b97f4a7c15ULL;
+    return (uint32_t)((h >> 32) % tlb->sets);
+}
 
-            LOG_TRACE_MSG("TLB hit: PID=%u VPN=0x%lx -> PFN=%u", pid, vpn, *pfn);
-            return true;
-        }
+// Tree pseudo-LRU: each node bit points toward the less recently used half
+static void tlb_plru_touch(TLB *tlb, uint32_t set, uint32_t way)
+{
+    uint64_t bits = tlb->plru[set];
+    uint32_t node = 1;
+    for (uint32_t span = tlb->ways >> 1; span > 0; span >>= 1) {
+        uint32_t right = (way & span) != 0;
+        if (right)
+            bits &= ~(1ULL << node);
+        else
+            bits |= 1ULL << node;
+        node = node * 2 + right;
     }
+    tlb->plru[set] = bits;
+}
 
-    LOG_TRACE_MSG("TLB miss: PID=%u VPN=0x%lx", pid, vpn);
-    return false;
+static uint32_t tlb_plru_victim(const TLB *tlb, uint32_t set)
+{
+    uint32_t node = 1;
+    uint32_t way = 0;
+    for (uint32_t span = tlb->ways >> 1; span > 0; span >>= 1) {
+        uint32_t right = (tlb->plru[set] >> node) & 1;
+        way |= right ? span : 0;
+        node = node * 2 + right;
+    }
+    return way;
 }
 
-void tlb_insert(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t pfn)
+static void tlb_touch(TLB *tlb, uint32_t set, uint32_t way)
 {
-    if (!tlb)
-        return;
+    if (tlb->policy == TLB_LRU)
+        tlb->entries[(size_t)set * tlb->ways + way].last_use_time = tlb->access_counter++;
+    else if (tlb->policy == TLB_PLRU && tlb->ways > 1)
+        tlb_plru_touch(tlb, set, way);
+}
 
-    uint32_t victim_index;
+// Way in set holding (pid, tag, page_bits), or tlb->ways
+static uint32_t tlb_find_way(const TLB *tlb, uint32_t set, uint32_t pid, uint64_t tag,
+                             uint32_t page_bits)
+{
+    const uint64_t *keys = &tlb->keys[(size_t)set * tlb->ways];
+    const TLBEntry *ways = &tlb->entries[(size_t)set * tlb->ways];
+    uint64_t key = tlb_key(pid, tag, page_bits);
+    for (uint32_t w = tlb_match(keys, tlb->ways, key); w < tlb->ways;
+         w += 1 + tlb_match(keys + w + 1, tlb->ways - w - 1, key)) {
+        if (ways[w].pid == pid && ways[w].vpn == tag && ways[w].page_bits == page_bits)
+            return w;
+    }
+    return tlb->ways;
+}
 
-    // Check if entry already exists (update instead of insert)
-    for (uint32_t i = 0; i < tlb->size; i++) {
-        if (tlb->entries[i].valid && tlb->entries[i].pid == pid && tlb->entries[i].vpn == vpn) {
-            tlb->entries[i].pfn = pfn;
-            if (tlb->policy == TLB_LRU) {
-                tlb->entries[i].last_use_time = tlb->access_counter++;
-            }
-            return;
+// Entry covering vpn in this level only
+static TLBEntry *tlb_find(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *set_out,
+                          uint32_t *way_out)
+{
+    for (uint64_t sizes = tlb->page_sizes; sizes; sizes &= sizes - 1) {
+        uint32_t page_bits = (uint32_t)__builtin_ctzll(sizes);
+        uint32_t set = tlb_set(tlb, pid, vpn >> page_bits);
+        uint32_t way = tlb_find_way(tlb, set, pid, vpn >> page_bits, page_bits);
+        if (way < tlb->ways) {
+            if (set_out)
+                *set_out = set;
+            if (way_out)
+                *way_out = way;
+            return &tlb->entries[(size_t)set * tlb->ways + way];
         }
     }
+    return NULL;
+}
+
+// Insert into this level only
+static void tlb_fill(TLB *tlb, uint32_t pid, uint64_t tag, uint32_t pfn, uint32_t page_bits)
+{
+    uint32_t set = tlb_set(tlb, pid, tag);
+    uint64_t *keys = &tlb->keys[(size_t)set * tlb->ways];
+    TLBEntry *ways = &tlb->entries[(size_t)set * tlb->ways];
+
+    // Check if entry already exists (update instead of insert)
+    uint32_t victim = tlb_find_way(tlb, set, pid, tag, page_bits);
+    if (victim < tlb->ways) {
+        ways[victim].pfn = pfn;
+        tlb_touch(tlb, set, victim);
+        tlb->last_slot = set * tlb->ways + victim;
+        return;
+    }
 
-    // Find victim based on policy
+    // Find victim based on policy: FIFO rotates through the ways, the others
+    // take an invalid way first
     if (tlb->policy == TLB_FIFO) {
-        victim_index = tlb->fifo_next;
-        tlb->fifo_next = (tlb->fifo_next + 1) % tlb->size;
-    } else { // TLB_LRU
-        // Find entry with minimum last_use_time
-        uint64_t min_time = UINT64_MAX;
-        victim_index = 0;
-        for (uint32_t i = 0; i < tlb->size; i++) {
-            if (!tlb->entries[i].valid) {
-                victim_index = i;
-                break;
-            }
-            if (tlb->entries[i].last_use_time < min_time) {
-                min_time = tlb->entries[i].last_use_time;
-                victim_index = i;
+        victim = tlb->fifo_next[set];
+        tlb->fifo_next[set] = (victim + 1) % tlb->ways;
+    } else if ((victim = tlb_match(keys, tlb->ways, 0)) == tlb->ways) {
+        if (tlb->policy == TLB_PLRU) {
+            victim = tlb_plru_victim(tlb, set);
+        } else { // TLB_LRU
+            // Find entry with minimum last_use_time
+            victim = 0;
+            for (uint32_t w = 1; w < tlb->ways; w++) {
+                if (ways[w].last_use_time < ways[victim].last_use_time)
+                    victim = w;
             }
         }
     }
 
     // Insert new entry
-    tlb->entries[victim_index].valid = true;
-    tlb->entries[victim_index].pid = pid;
-    tlb->entries[victim_index].vpn = vpn;
-    tlb->entries[victim_index].pfn = pfn;
-    tlb->entries[victim_index].last_use_time = tlb->access_counter++;
+    keys[victim] = tlb_key(pid, tag, page_bits);
+    if (pid >= TLB_KEY_PIDS || tag >> 48)
+        tlb->wide_keys = true;
+    ways[victim].pid = pid;
+    ways[victim].vpn = tag;
+    ways[victim].pfn = pfn;
+    ways[victim].page_bits = page_bits;
+    ways[victim].last_use_time = tlb->access_counter++;
+    if (tlb->policy == TLB_PLRU && tlb->ways > 1)
+        tlb_plru_touch(tlb, set, victim);
+    tlb->page_sizes |= 1ULL << page_bits;
+    tlb->last_slot = set * tlb->ways + victim;
 
-    LOG_TRACE_MSG("TLB insert: PID=%u VPN=0x%lx -> PFN=%u (index %u)", pid, vpn, pfn,
-                  victim_index);
+    LOG_TRACE_MSG("TLB insert: PID=%u VPN=0x%lx -> PFN=%u (set %u, way %u)", pid, tag, pfn,
+                  set, victim);
 }
 
-void tlb_invalidate(TLB *tlb, uint32_t pid, uint64_t vpn)
+uint32_t tlb_lookup_level(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *pfn)
 {
-    if (!tlb)
-        return;
+    if (!tlb || !pfn)
+        return 0;
+
+    tlb->lookups++;
+    uint32_t set, way;
+    TLBEntry *e = tlb_find(tlb, pid, vpn, &set, &way);
+    if (e) {
+        tlb->hits++;
+        *pfn = e->pfn + (uint32_t)(vpn & ((1ULL << e->page_bits) - 1));
+        tlb_touch(tlb, set, way);
+        tlb->last_slot = set * tlb->ways + way;
+        LOG_TRACE_MSG("TLB hit: PID=%u VPN=0x%lx -> PFN=%u", pid, vpn, *pfn);
+        return 1;
+    }
 
-    for (uint32_t i = 0; i < tlb->size; i++) {
-        if (tlb->entries[i].valid && tlb->entries[i].pid == pid && tlb->entries[i].vpn == vpn) {
-            tlb->entries[i].valid = false;
+    // A hit further down refills this level
+    uint32_t level = tlb_lookup_level(tlb->next, pid, vpn, pfn);
+    if (level) {
+        e = tlb_find(tlb->next, pid, vpn, NULL, NULL);
+        tlb_fill(tlb, pid, e->vpn, e->pfn, e->page_bits);
+        return level + 1;
+    }
+
+    LOG_TRACE_MSG("TLB miss: PID=%u VPN=0x%lx", pid, vpn);
+    return 0;
+}
+
+bool tlb_lookup(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *pfn)
+{
+    return tlb_lookup_level(tlb, pid, vpn, pfn) > 0;
+}
+
+bool tlb_hit_slot(TLB *tlb, uint32_t slot, uint32_t pid, uint64_t vpn)
+{
+    if (!tlb || slot >= tlb->size || !tlb->keys[slot])
+        return false;
+    const TLBEntry *e = &tlb->entries[slot];
+    if (e->pid != pid || e->vpn != vpn >> e->page_bits)
+        return false;
+
+    tlb->lookups++;
+    tlb->hits++;
+    tlb_touch(tlb, slot / tlb->ways, slot % tlb->ways);
+    return true;
+}
+
+void tlb_insert(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t pfn)
+{
+    tlb_insert_huge(tlb, pid, vpn, pfn, 0);
+}
+
+void tlb_insert_huge(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t pfn, uint32_t page_bits)
+{
+    uint64_t mask = (1ULL << page_bits) - 1;
+    for (; tlb; tlb = tlb->next)
+        tlb_fill(tlb, pid, vpn >> page_bits, pfn - (uint32_t)(vpn & mask), page_bits);
+}
+
+void tlb_invalidate(TLB *tlb, uint32_t pid, uint64_t vpn)
+{
+    for (; tlb; tlb = tlb->next) {
+        uint32_t set, way;
+        if (tlb_find(tlb, pid, vpn, &set, &way)) {
+            tlb->keys[(size_t)set * tlb->ways + way] = 0;
             LOG_TRACE_MSG("TLB invalidate: PID=%u VPN=0x%lx", pid, vpn);
-            return;
         }
     }
 }
 
 void tlb_invalidate_all(TLB *tlb, uint32_t pid)
 {
-    if (!tlb)
-        return;
-
-    uint32_t count = 0;
-    for (uint32_t i = 0; i < tlb->size; i++) {
-        if (tlb->entries[i].valid && tlb->entries[i].pid == pid) {
-            tlb->entries[i].valid = false;
-            count++;
+    for (; tlb; tlb = tlb->next) {
+        uint32_t count = 0;
+        if (!tlb->wide_keys) {
+            // Every key is exact, so its pid field alone decides
+            uint64_t want = TLB_KEY_VALID | (uint64_t)pid << 48;
+            for (uint32_t i = 0; pid < TLB_KEY_PIDS && i < tlb->size; i++) {
+                if ((tlb->keys[i] & (TLB_KEY_VALID | TLB_KEY_PID_MASK)) == want) {
+                    tlb->keys[i] = 0;
+                    count++;
+                }
+            }
+        } else {
+            for (uint32_t i = 0; i < tlb->size; i++) {
+                if (tlb->keys[i] && tlb->entries[i].pid == pid) {
+                    tlb->keys[i] = 0;
+                    count++;
+                }
+            }
         }
+        LOG_DEBUG_MSG("TLB invalidated %u entries for PID %u", count, pid);
     }
-    LOG_DEBUG_MSG("TLB invalidated %u entries for PID %u", count, pid);
 }
 
 void tlb_flush(TLB *tlb)
 {
-    if (!tlb)
-        return;
-
-    memset(tlb->entries, 0, tlb->size * sizeof(TLBEntry));
-    tlb->fifo_next = 0;
+    for (; tlb; tlb = tlb->next) {
+        memset(tlb->keys, 0, tlb->size * sizeof(uint64_t));
+        memset(tlb->entries, 0, tlb->size * sizeof(TLBEntry));
+        memset(tlb->fifo_next, 0, tlb->sets * sizeof(uint32_t));
+        memset(tlb->plru, 0, tlb->sets * sizeof(uint64_t));
+        tlb->page_sizes = 0;
+    }
     LOG_DEBUG_MSG("TLB flushed");
 }
-
@@ -2,7 +2,15 @@
  * tlb.h - Translation Lookaside Buffer simulation
  * 
  * Fast cache for virtual-to-physical address translations.
- * Supports FIFO and LRU replacement policies.
+ * Set-associative with a hashed set index (one set of all entries makes it
+ * fully associative), replacing within a set by FIFO, LRU or tree pseudo-LRU.
+ * A TLB can have a second level (an STLB) that is probed on a miss and
+ * refills the first level on a hit. An entry can cover a huge page, in which
+ * case it translates every base page inside it.
+ *
+ * Tags live apart from the entries, one packed 64-bit key per way (valid bit,
+ * pid, page size and vpn folded together), so a set is searched by comparing
+ * keys with SSE2 or AVX2, picked at run time, or scalar code elsewhere.
  */
 
 #ifndef TLB_H
@@ -10,39 +18,72 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "util.h"
 
-// TLB entry
+// TLB entry (valid while its key is nonzero)
 typedef struct {
-    bool valid;
-    uint32_t pid;           // Process ID for tagged TLB
-    uint64_t vpn;           // Virtual page number
-    uint32_t pfn;           // Physical frame number
+    uint64_t vpn;           // Virtual page number (>> page_bits)
     uint64_t last_use_time; // For LRU replacement
-    uint32_t fifo_index;    // For FIFO replacement
+    uint32_t pid;           // Process ID for tagged TLB
+    uint32_t pfn;           // Physical frame number of the first base page
+    uint32_t page_bits;     // log2(base pages covered); 0 for a base page
 } TLBEntry;
 
+// Packed tag: exact for pids below 2^10 and vpns below 2^48; anything wider
+// can collide, so a key match is confirmed against the entry
+#define TLB_KEY_VALID (1ULL << 63)
+#define TLB_KEY_PIDS (1U << 10)
+#define TLB_KEY_PID_MASK ((uint64_t)(TLB_KEY_PIDS - 1) << 48)
+static inline uint64_t tlb_key(uint32_t pid, uint64_t tag, uint32_t page_bits)
+{
+    return TLB_KEY_VALID |
+           ((tag ^ ((uint64_t)pid << 48) ^ ((uint64_t)page_bits << 58)) & ~TLB_KEY_VALID);
+}
+
 // TLB replacement policies
-typedef enum { TLB_FIFO, TLB_LRU } TLBPolicy;
+typedef enum { TLB_FIFO, TLB_LRU, TLB_PLRU } TLBPolicy;
 
-// TLB structure
-typedef struct {
+// TLB structure (one level of the hierarchy)
+typedef struct TLB {
     uint32_t size;       // Number of TLB entries
-    TLBEntry *entries;   // Array of TLB entries
-    TLBPolicy policy;    // Replacement policy
-    uint32_t fifo_next;  // Next entry for FIFO
+    uint32_t sets;       // size / ways
+    uint32_t ways;       // Associativity
+    TLBEntry *entries;   // sets * ways entries, one set after another
+    uint64_t *keys;      // Tag per entry, same layout; 0 = invalid
+    TLBPolicy policy;    // Replacement policy within a set
+    uint32_t *fifo_next; // Next way to replace per set (FIFO)
+    uint64_t *plru;      // Tree bits per set (PLRU)
     uint64_t access_counter; // For LRU timestamp
+    uint64_t page_sizes; // Bit n set once an entry with page_bits n was inserted
+    bool wide_keys;      // Set once an entry's key was not exact
+    uint64_t lookups;    // Lookups that reached this level
+    uint64_t hits;
+    uint32_t last_slot;  // Entry of the latest hit or insert in this level
+    struct TLB *next;    // Second-level TLB, or NULL
 } TLB;
 
 // TLB operations
-TLB *tlb_create(uint32_t size, TLBPolicy policy);
-void tlb_destroy(TLB *tlb);
+TLB *tlb_create(uint32_t size, TLBPolicy policy);           // Fully associative
+TLB *tlb_create_assoc(uint32_t size, uint32_t ways, TLBPolicy policy);
+void tlb_destroy(TLB *tlb);                                  // Destroys next levels too
+void tlb_set_next(TLB *tlb, TLB *next);                     // tlb takes ownership
+const char *tlb_policy_name(TLBPolicy policy);
+const char *tlb_kernel_name(void);                          // Tag-match code in use
+void tlb_set_kernel(SimdLevel level);                        // Force the tag-match code
 
-// Lookup and update
+// Lookup and update. tlb_lookup_level returns the level that hit (1 = this
+// TLB), or 0 on a miss in every level. Inserts fill every level.
+uint32_t tlb_lookup_level(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *pfn);
 bool tlb_lookup(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t *pfn);
+
+// Lookup that only checks one slot (a last_slot saved earlier): if it still
+// translates vpn it counts and touches exactly like a first-level hit,
+// otherwise it returns false and leaves the TLB untouched
+bool tlb_hit_slot(TLB *tlb, uint32_t slot, uint32_t pid, uint64_t vpn);
 void tlb_insert(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t pfn);
-void tlb_invalidate(TLB *tlb, uint32_t pid, uint64_t vpn);
+void tlb_insert_huge(TLB *tlb, uint32_t pid, uint64_t vpn, uint32_t pfn, uint32_t page_bits);
+void tlb_invalidate(TLB *tlb, uint32_t pid, uint64_t vpn); // Any entry covering vpn
 void tlb_invalidate_all(TLB *tlb, uint32_t pid); // For context switch
 void tlb_flush(TLB *tlb);                          // Clear entire TLB
 
 #endif // TLB_H
-
@@ -2,6 +2,8 @@
  * trace.c - Memory trace parsing and generation
  */
 
+#define _POSIX_C_SOURCE 200809L // strdup
+
 #include "trace.h"
 #include "util.h"
 #include <stdlib.h>
@@ -55,15 +57,10 @@ Trace *trace_load(const char *filename)
     trace->filename = strdup(filename);
 
     char line[256];
+    TraceEntry entry;
     while (fgets(line, sizeof(line), fp)) {
-        uint32_t pid;
-        char op;
-        uint64_t addr;
-
-        if (sscanf(line, "%u %c 0x%lx", &pid, &op, &addr) == 3 ||
-            sscanf(line, "%u %c %lu", &pid, &op, &addr) == 3) {
-            MemoryOperation mem_op = (op == 'W' || op == 'w') ? OP_WRITE : OP_READ;
-            trace_add(trace, pid, mem_op, addr);
+        if (trace_parse_line(line, &entry)) {
+            trace_add(trace, entry.pid, entry.op, entry.virtual_addr);
         }
     }
 
@@ -72,6 +69,22 @@ Trace *trace_load(const char *filename)
     return trace;
 }
 
+bool trace_parse_line(const char *line, TraceEntry *entry)
+{
+    uint32_t pid;
+    char op;
+    uint64_t addr;
+
+    if (sscanf(line, "%u %c 0x%lx", &pid, &op, &addr) != 3 &&
+        sscanf(line, "%u %c %lu", &pid, &op, &addr) != 3) {
+        return false;
+    }
+    entry->pid = pid;
+    entry->op = (op == 'W' || op == 'w') ? OP_WRITE : OP_READ;
+    entry->virtual_addr = addr;
+    return true;
+}
+
 bool trace_save(Trace *trace, const char *filename)
 {
     if (!trace)
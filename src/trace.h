@@ -45,6 +45,9 @@ void trace_destroy(Trace *trace);
 // Load trace from file (format: "pid op virtual_addr" per line)
 Trace *trace_load(const char *filename);
 
+// Parse one trace line; false for lines that are not an access
+bool trace_parse_line(const char *line, TraceEntry *entry);
+
 // Save trace to file
 bool trace_save(Trace *trace, const char *filename);
 
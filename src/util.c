@@ -2,12 +2,15 @@
  * util.c - Utility function implementations
  */
 
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
 #include "util.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <time.h>
 #include <sys/time.h>
 #include <string.h>
+#include <strings.h>
 
 static LogLevel current_log_level = LOG_INFO;
 
@@ -48,6 +51,13 @@ uint64_t get_timestamp_us(void)
     return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
 }
 
+uint64_t get_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 void print_binary(uint64_t value, int bits)
 {
     for (int i = bits - 1; i >= 0; i--) {
@@ -74,3 +84,38 @@ bool is_power_of_two(uint32_t v)
     return v && !(v & (v - 1));
 }
 
+SimdLevel simd_resolve(SimdLevel level)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    if (level == SIMD_AUTO)
+        return avx2 ? SIMD_AVX2 : SIMD_SSE2;
+    if (level == SIMD_AVX2 && !avx2) {
+        LOG_WARN_MSG("CPU has no AVX2, using SSE2 kernels");
+        return SIMD_SSE2;
+    }
+    return level;
+#else
+    if (level == SIMD_SSE2 || level == SIMD_AVX2)
+        LOG_WARN_MSG("No vector kernels on this architecture, using scalar code");
+    return SIMD_SCALAR;
+#endif
+}
+
+bool simd_parse(const char *name, SimdLevel *level)
+{
+    static const struct {
+        const char *name;
+        SimdLevel level;
+    } names[] = {{"auto", SIMD_AUTO}, {"scalar", SIMD_SCALAR}, {"sse2", SIMD_SSE2},
+                 {"avx2", SIMD_AVX2}};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcasecmp(name, names[i].name) == 0) {
+            *level = names[i].level;
+            return true;
+        }
+    }
+    return false;
+}
+
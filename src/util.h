@@ -32,8 +32,16 @@ void log_message(LogLevel level, const char *file, int line, const char *fmt, ..
 #define LOG_DEBUG_MSG(...) log_message(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
 #define LOG_TRACE_MSG(...) log_message(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
 
+// Vector code paths. SIMD_AUTO takes the widest one the CPU supports; a
+// forced level the CPU lacks falls back to the next one down.
+typedef enum { SIMD_AUTO, SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2 } SimdLevel;
+
+SimdLevel simd_resolve(SimdLevel level);
+bool simd_parse(const char *name, SimdLevel *level);
+
 // Utility functions
 uint64_t get_timestamp_us(void);  // Microsecond timestamp
+uint64_t get_monotonic_ns(void);  // Host monotonic clock (for measuring real I/O)
 void print_binary(uint64_t value, int bits);
 uint32_t next_power_of_two(uint32_t v);
 bool is_power_of_two(uint32_t v);
@@ -9,6 +9,11 @@
 #include "util.h"
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+
+// kswapd pacing: pages per pass (SWAP_CLUSTER_MAX) and daemon CPU time per page
+#define KSWAPD_BATCH 32
+#define KSWAPD_PAGE_NS 1000
 
 void vmm_config_init_default(VMMConfig *config)
 {
@@ -25,7 +30,12 @@ void vmm_config_init_default(VMMConfig *config)
 
     // TLB configuration
     config->tlb_size = 64;
+    config->tlb_ways = 4;
+    config->stlb_size = 0;
+    config->stlb_ways = 12;
     config->tlb_policy = TLB_LRU;
+    config->walk_cache_entries = 32;
+    config->simd = SIMD_AUTO;
 
     // Page table configuration
     config->pt_type = PT_SINGLE_LEVEL;
@@ -35,6 +45,15 @@ void vmm_config_init_default(VMMConfig *config)
 
     // Swap configuration
     config->swap_size_mb = 256;
+    config->swap_device = SWAPDEV_FIXED;
+    config->swap_queue_depth = 0; // Profile default
+    config->swap_readahead = 8;   // Linux default page-cluster of 3
+    config->kswapd = false;
+    config->reclaim_batch = 1;
+    config->aging_interval = 1000;
+    config->swap_file = NULL;
+    config->direct_io = false;
+    config->io_batch_pages = 16;
 
     // Simulation parameters
     config->max_processes = 16;
@@ -43,6 +62,7 @@ void vmm_config_init_default(VMMConfig *config)
 
     // Access times (typical values)
     config->access_times.tlb_hit_time_ns = 1;
+    config->access_times.stlb_hit_time_ns = 3;
     config->access_times.memory_access_time_ns = 100;
     config->access_times.page_fault_time_us = 1000;
     config->access_times.swap_io_time_us = 5000;
@@ -63,16 +83,69 @@ void vmm_config_print(VMMConfig *config, FILE *out)
     fprintf(out, "  Page size:        %u bytes\n", config->page_size);
     fprintf(out, "  Virtual space:    %llu bytes (%.1f GB)\n", (unsigned long long)config->virtual_addr_space,
             config->virtual_addr_space / (1024.0 * 1024 * 1024));
-    fprintf(out, "  TLB:              %u entries (%s)\n", config->tlb_size,
-            config->tlb_policy == TLB_FIFO ? "FIFO" : "LRU");
-    fprintf(out, "  Page table:       %s\n",
-            config->pt_type == PT_SINGLE_LEVEL ? "Single-level" : "Two-level");
-    fprintf(out, "  Replacement:      %s\n",
+    fprintf(out, "  TLB:              %u entries, %u-way (%s)\n", config->tlb_size,
+            config->tlb_ways ? config->tlb_ways : config->tlb_size,
+            tlb_policy_name(config->tlb_policy));
+    if (config->stlb_size) {
+        fprintf(out, "  STLB:             %u entries, %u-way\n", config->stlb_size,
+                config->stlb_ways ? config->stlb_ways : config->stlb_size);
+    }
+    if (config->walk_cache_entries)
+        fprintf(out, "  Walk cache:       %u entries per level\n", config->walk_cache_entries);
+    else
+        fprintf(out, "  Walk cache:       off\n");
+    fprintf(out, "  Page table:       %s%s\n", pagetable_type_name(config->pt_type),
+            config->pt_reserve && config->pt_type == PT_SINGLE_LEVEL ? " (reserved)" : "");
+    if (config->huge_page_size) {
+        fprintf(out, "  Huge pages:       %lu KB (%s)\n", config->huge_page_size / 1024,
+                config->thp ? "THP: collapse when populated, split under pressure"
+                            : "mapped whole on first touch");
+    }
+    fprintf(out, "  Replacement:      %s",
             replacement_get_name(config->replacement_algo));
+    if (config->replacement_algo == REPLACE_APPROX_LRU)
+        fprintf(out, " (aging every %u accesses)", config->aging_interval);
+    fprintf(out, "\n");
     fprintf(out, "  Swap:             %u MB\n", config->swap_size_mb);
+    fprintf(out, "  Swap device:      %s", swapdev_get_name(config->swap_device));
+    if (config->swap_queue_depth > 0)
+        fprintf(out, " (QD %u)", config->swap_queue_depth);
+    fprintf(out, "\n");
+    fprintf(out, "  Write-back batch: %u pages\n", config->io_batch_pages);
+    fprintf(out, "  Reclaim:          %s, batch %u\n",
+            config->kswapd ? "kswapd (background, watermarks)" : "direct only",
+            config->reclaim_batch);
+    if (config->swap_readahead > 1)
+        fprintf(out, "  Swap readahead:   up to %u pages\n", config->swap_readahead);
+    else
+        fprintf(out, "  Swap readahead:   off\n");
+    if (config->swap_file) {
+        fprintf(out, "  Swap file:        %s (%s)\n", config->swap_file,
+                config->direct_io ? "O_DIRECT" : "buffered");
+    }
     fprintf(out, "  Max processes:    %u\n", config->max_processes);
 }
 
+// L1 dTLB, with the STLB behind it when configured
+static TLB *vmm_create_tlb(const VMMConfig *config)
+{
+    TLB *tlb = tlb_create_assoc(config->tlb_size, config->tlb_ways ? config->tlb_ways
+                                                                    : config->tlb_size,
+                                config->tlb_policy);
+    if (!tlb || config->stlb_size == 0)
+        return tlb;
+
+    TLB *stlb = tlb_create_assoc(config->stlb_size, config->stlb_ways ? config->stlb_ways
+                                                                       : config->stlb_size,
+                                 config->tlb_policy);
+    if (!stlb) {
+        tlb_destroy(tlb);
+        return NULL;
+    }
+    tlb_set_next(tlb, stlb);
+    return tlb;
+}
+
 VMM *vmm_create(VMMConfig *config)
 {
     if (!config) {
@@ -88,6 +161,67 @@ VMM *vmm_create(VMMConfig *config)
 
     memcpy(&vmm->config, config, sizeof(VMMConfig));
 
+    // Readahead windows are aligned, so the limit must be a power of two
+    uint32_t ra_max = 1;
+    while (ra_max * 2 <= config->swap_readahead && ra_max * 2 <= VMM_MAX_READAHEAD) {
+        ra_max *= 2;
+    }
+    vmm->config.swap_readahead = ra_max;
+    if (vmm->config.reclaim_batch == 0)
+        vmm->config.reclaim_batch = 1;
+    if (vmm->config.reclaim_batch > VMM_MAX_RECLAIM_BATCH)
+        vmm->config.reclaim_batch = VMM_MAX_RECLAIM_BATCH;
+
+    // Huge pages: one upper-level leaf per huge page, so they need a multi-level table
+    if (vmm->config.thp && vmm->config.huge_page_size == 0)
+        vmm->config.huge_page_size = 2ULL * 1024 * 1024;
+    if (vmm->config.huge_page_size) {
+        uint64_t pages = vmm->config.huge_page_size / config->page_size;
+        if (pages < 2 || pages * config->page_size != vmm->config.huge_page_size ||
+            !is_power_of_two((uint32_t)pages)) {
+            LOG_ERROR_MSG("Huge page size must be a power-of-two multiple of the page size");
+            free(vmm);
+            return NULL;
+        }
+        if (vmm->config.pt_type == PT_SINGLE_LEVEL || vmm->config.pt_type == PT_INVERTED) {
+            LOG_WARN_MSG("Huge pages need a multi-level page table, using TWO_LEVEL");
+            vmm->config.pt_type = PT_TWO_LEVEL;
+        }
+        vmm->huge_pages = (uint32_t)pages;
+        while ((1u << vmm->huge_bits) < vmm->huge_pages)
+            vmm->huge_bits++;
+        if (vmm->config.pt_type != PT_TWO_LEVEL && vmm->huge_bits % PT_RADIX_BITS != 0) {
+            LOG_ERROR_MSG("Radix huge pages must be the page size times a power of %u",
+                          PT_RADIX_FANOUT);
+            free(vmm);
+            return NULL;
+        }
+        if (vmm->huge_pages > config->num_frames) {
+            LOG_WARN_MSG("Huge pages are larger than RAM, every huge fault will fall back");
+        }
+    }
+
+    // Free-frame watermarks as Linux sizes them: min_free_kbytes = sqrt(16 * RAM in KB)
+    // clamped to 128 KB..64 MB, low = min * 5/4, high = min * 3/2
+    if (config->kswapd) {
+        uint64_t ram_kb = (uint64_t)config->num_frames * config->page_size / 1024;
+        uint64_t min_kb = (uint64_t)sqrt((double)ram_kb * 16);
+        if (min_kb < 128)
+            min_kb = 128;
+        if (min_kb > 65536)
+            min_kb = 65536;
+        uint64_t min_frames = min_kb * 1024 / config->page_size;
+        if (min_frames > config->num_frames / 8)
+            min_frames = config->num_frames / 8;
+        vmm->wmark_min = min_frames > 0 ? (uint32_t)min_frames : 1;
+        vmm->wmark_low = vmm->wmark_min + vmm->wmark_min / 4;
+        vmm->wmark_high = vmm->wmark_min + vmm->wmark_min / 2;
+        if (vmm->wmark_high <= vmm->wmark_min)
+            vmm->wmark_high = vmm->wmark_min + 1;
+        LOG_INFO_MSG("kswapd watermarks: min %u, low %u, high %u frames", vmm->wmark_min,
+                     vmm->wmark_low, vmm->wmark_high);
+    }
+
     // Create frame allocator
     vmm->frame_allocator = frame_allocator_create(config->num_frames);
     if (!vmm->frame_allocator) {
@@ -96,23 +230,67 @@ VMM *vmm_create(VMMConfig *config)
         return NULL;
     }
 
+    // One inverted table shared by every process, sized by physical memory
+    if (vmm->config.pt_type == PT_INVERTED) {
+        vmm->inverted = inverted_table_create(config->num_frames);
+        if (!vmm->inverted) {
+            vmm_destroy(vmm);
+            return NULL;
+        }
+    }
+
     // Create TLB
-    vmm->tlb = tlb_create(config->tlb_size, config->tlb_policy);
+    tlb_set_kernel(config->simd);
+    vmm->tlb = vmm_create_tlb(config);
     if (!vmm->tlb) {
         LOG_ERROR_MSG("Failed to create TLB");
         vmm_destroy(vmm);
         return NULL;
     }
 
-    // Create swap manager
+    vmm->walk_cache = walkcache_create(config->walk_cache_entries);
+    if (!vmm->walk_cache) {
+        vmm_destroy(vmm);
+        return NULL;
+    }
+
+    // Base-page-only TLB of the same size, to measure what huge pages gain
+    if (vmm->huge_pages) {
+        vmm->base_tlb = vmm_create_tlb(config);
+        if (!vmm->base_tlb) {
+            vmm_destroy(vmm);
+            return NULL;
+        }
+    }
+
+    // Create swap manager and its device model
     uint32_t swap_slots = (config->swap_size_mb * 1024 * 1024) / config->page_size;
-    vmm->swap = swap_create(swap_slots);
+    SwapDevice *swap_device =
+        swapdev_create(config->swap_device, config->swap_queue_depth, config->page_size,
+                       swap_slots, config->access_times.swap_io_time_us * 1000);
+    if (!swap_device) {
+        LOG_ERROR_MSG("Failed to create swap device");
+        vmm_destroy(vmm);
+        return NULL;
+    }
+    vmm->swap = swap_create(swap_slots, swap_device, config->io_batch_pages);
     if (!vmm->swap) {
         LOG_ERROR_MSG("Failed to create swap manager");
         vmm_destroy(vmm);
         return NULL;
     }
 
+    // Real-data mode: frames get buffers and evictions do real I/O
+    if (config->swap_file) {
+        if (!frame_allocator_enable_data(vmm->frame_allocator, config->page_size) ||
+            !swap_attach_file(vmm->swap, config->swap_file, config->page_size,
+                              config->direct_io)) {
+            LOG_ERROR_MSG("Failed to set up real-data swap on %s", config->swap_file);
+            vmm_destroy(vmm);
+            return NULL;
+        }
+    }
+
     // Create replacement policy
     vmm->replacement_policy = replacement_create(config->replacement_algo, config->num_frames);
     if (!vmm->replacement_policy) {
@@ -129,6 +307,18 @@ VMM *vmm_create(VMMConfig *config)
         return NULL;
     }
 
+    vmm->metrics->huge_page_size = vmm->config.huge_page_size;
+    frame_set_aging_kernel(config->simd);
+    vmm->metrics->aging_kernel = frame_aging_kernel_name();
+
+    // Create simulated clock
+    vmm->clock = simclock_create();
+    if (!vmm->clock) {
+        LOG_ERROR_MSG("Failed to create simulated clock");
+        vmm_destroy(vmm);
+        return NULL;
+    }
+
     // Allocate process array
     vmm->processes = calloc(config->max_processes, sizeof(Process));
     if (!vmm->processes) {
@@ -154,9 +344,13 @@ void vmm_destroy(VMM *vmm)
     }
 
     free(vmm->processes);
+    inverted_table_destroy(vmm->inverted);
+    simclock_destroy(vmm->clock);
     metrics_destroy(vmm->metrics);
     replacement_destroy(vmm->replacement_policy);
     swap_destroy(vmm->swap);
+    walkcache_destroy(vmm->walk_cache);
+    tlb_destroy(vmm->base_tlb);
     tlb_destroy(vmm->tlb);
     frame_allocator_destroy(vmm->frame_allocator);
     free(vmm);
@@ -180,8 +374,17 @@ bool vmm_add_process(VMM *vmm, uint32_t pid)
     }
 
     // Create page table for process
-    PageTable *pt = pagetable_create(pid, vmm->config.pt_type, vmm->config.virtual_addr_space,
-                                      vmm->config.page_size);
+    PageTable *pt;
+    if (vmm->inverted) {
+        pt = pagetable_create_inverted(pid, vmm->inverted, vmm->config.virtual_addr_space,
+                                       vmm->config.page_size);
+    } else if (vmm->config.pt_reserve && vmm->config.pt_type == PT_SINGLE_LEVEL) {
+        pt = pagetable_create_reserved(pid, vmm->config.virtual_addr_space,
+                                       vmm->config.page_size);
+    } else {
+        pt = pagetable_create(pid, vmm->config.pt_type, vmm->config.virtual_addr_space,
+                              vmm->config.page_size, vmm->config.huge_page_size);
+    }
     if (!pt) {
         LOG_ERROR_MSG("Failed to create page table for PID %u", pid);
         return false;
@@ -210,74 +413,573 @@ Process *vmm_get_process(VMM *vmm, uint32_t pid)
     return NULL;
 }
 
+// Real-data mode: every written page carries its owner so swap round-trips can be verified
+#define PAGE_STAMP_MAGIC 0x504d4d56 // "VMMP"
+
+typedef struct {
+    uint32_t pid;
+    uint32_t magic;
+    uint64_t vpn;
+} PageStamp;
+
+static void vmm_stamp_page(VMM *vmm, uint32_t pfn, uint32_t pid, uint64_t vpn)
+{
+    uint8_t *data = frame_get_data(vmm->frame_allocator, pfn);
+    if (data) {
+        PageStamp stamp = {pid, PAGE_STAMP_MAGIC, vpn};
+        memcpy(data, &stamp, sizeof(stamp));
+    }
+}
+
+static void vmm_verify_page(VMM *vmm, uint32_t pfn, uint32_t pid, uint64_t vpn)
+{
+    uint8_t *data = frame_get_data(vmm->frame_allocator, pfn);
+    if (!data)
+        return;
+
+    PageStamp stamp;
+    memcpy(&stamp, data, sizeof(stamp));
+    if (stamp.magic != PAGE_STAMP_MAGIC || stamp.pid != pid || stamp.vpn != vpn) {
+        LOG_WARN_MSG("Swap-in of PID=%u VPN=0x%lx returned wrong contents", pid, vpn);
+        vmm->swap->io.verify_errors++;
+    }
+}
+
+// Simulated cost of a single access
+typedef struct {
+    uint64_t cpu_ns;   // Lookup, page walk and fault handling time
+    uint64_t io_ns;    // Time the process is blocked on swap I/O
+    uint64_t stall_ns; // Fault handling plus I/O wait
+} AccessCost;
+
+// Swap I/O completion: unblock the waiting process
+static void vmm_io_complete(void *ctx, uint64_t arg, uint64_t time_ns)
+{
+    VMM *vmm = ctx;
+    Process *proc = &vmm->processes[arg];
+
+    if (proc->blocked && proc->ready_time_ns <= time_ns) {
+        proc->blocked = false;
+    }
+    vmm->io_in_flight--;
+}
+
+// Advance the clock by the access cost and block the process on any I/O
+static void vmm_charge_access(VMM *vmm, Process *proc, const AccessCost *cost)
+{
+    simclock_advance(vmm->clock, cost->cpu_ns);
+
+    if (cost->io_ns > 0) {
+        proc->ready_time_ns = simclock_now(vmm->clock) + cost->io_ns;
+        proc->blocked = true;
+        vmm->io_in_flight++;
+        simclock_schedule(vmm->clock, proc->ready_time_ns, vmm_io_complete, vmm,
+                          (uint64_t)(proc - vmm->processes));
+    }
+
+    metrics_record_access_time(vmm->metrics, proc->pid, cost->cpu_ns + cost->io_ns,
+                               cost->stall_ns);
+}
+
+// Frame backing vpn, given the leaf entry that maps it
+static uint32_t vmm_pte_frame(VMM *vmm, PageTableEntry *pte, uint64_t vpn)
+{
+    if (pte_flags(pte) & PTE_HUGE)
+        return pte_frame(pte) + (uint32_t)(vpn & (vmm->huge_pages - 1));
+    return pte_frame(pte);
+}
+
+static void vmm_tlb_fill(VMM *vmm, uint32_t pid, uint64_t vpn, PageTableEntry *pte)
+{
+    if (pte_flags(pte) & PTE_HUGE)
+        tlb_insert_huge(vmm->tlb, pid, vpn, vmm_pte_frame(vmm, pte, vpn), vmm->huge_bits);
+    else
+        tlb_insert(vmm->tlb, pid, vpn, pte_frame(pte));
+}
+
+// Remember the translation the L1 dTLB just hit or filled for the fast path
+static void vmm_remember(VMM *vmm, Process *proc, uint64_t vpn, uint32_t pfn, PageTableEntry *pte)
+{
+    LastTranslation *last = &proc->last;
+    last->valid = true;
+    last->vpn = vpn;
+    last->pfn = pfn;
+    last->tlb_slot = vmm->tlb->last_slot;
+    last->pte = pte;
+    last->pte_epoch = vmm->pt_epoch;
+}
+
+// Leaf entry of the last translation, looked up again once entries may have moved
+static PageTableEntry *vmm_last_pte(VMM *vmm, Process *proc, uint64_t virtual_addr)
+{
+    LastTranslation *last = &proc->last;
+    if (!last->pte || last->pte_epoch != vmm->pt_epoch) {
+        last->pte = pagetable_lookup(proc->page_table, virtual_addr);
+        last->pte_epoch = vmm->pt_epoch;
+    }
+    return last->pte;
+}
+
+// Drop the TLB entry covering vpn, and the last translation if it shares that page
+static void vmm_tlb_invalidate(VMM *vmm, Process *proc, uint64_t vpn)
+{
+    tlb_invalidate(vmm->tlb, proc->pid, vpn);
+    if (proc->last.valid && proc->last.vpn >> vmm->huge_bits == vpn >> vmm->huge_bits)
+        proc->last.valid = false;
+}
+
+// Memory references the TLB-miss walk to leaf makes, after the walk cache
+static uint32_t vmm_walk_refs(VMM *vmm, Process *proc, uint64_t vpn, const PageTableEntry *leaf)
+{
+    PageTable *pt = proc->page_table;
+    uint32_t levels = pagetable_get_levels(pt);
+    uint32_t refs = pagetable_walk_levels(pt, leaf);
+    if (pt->type == PT_SINGLE_LEVEL || pt->type == PT_INVERTED) {
+        walkcache_record(vmm->walk_cache, refs);
+        return refs;
+    }
+
+    uint32_t shift[METRICS_PT_MAX_LEVELS];
+    for (uint32_t l = 0; l < levels && l < METRICS_PT_MAX_LEVELS; l++)
+        shift[l] = pagetable_level_shift(pt, l);
+    return walkcache_walk(vmm->walk_cache, proc->pid, vpn, shift, levels, levels - refs);
+}
+
+// Aligned frames for one huge page, unless that would leave free memory under the
+// high watermark (reclaim runs for base pages, never to make room for a huge one)
+static int32_t vmm_alloc_huge(VMM *vmm)
+{
+    if (frame_get_free_count(vmm->frame_allocator) < vmm->huge_pages + vmm->wmark_high)
+        return -1;
+    return frame_alloc_contig(vmm->frame_allocator, vmm->huge_pages);
+}
+
+// Reclaim reached a frame inside a huge page: remap the region as base pages so
+// the victim can go on its own. Returns the victim's new base-page entry.
+static PageTableEntry *vmm_split_huge(VMM *vmm, Process *proc, uint64_t vpn)
+{
+    uint64_t base_vpn = vpn & ~(uint64_t)(vmm->huge_pages - 1);
+    vmm_tlb_invalidate(vmm, proc, vpn);
+    if (!pagetable_split_huge(proc->page_table, base_vpn * vmm->config.page_size)) {
+        return NULL;
+    }
+
+    // Base-page dirty bits follow the frames, not the old huge leaf
+    for (uint32_t i = 0; i < vmm->huge_pages; i++) {
+        PageTableEntry *pte =
+            pagetable_lookup(proc->page_table, (base_vpn + i) * vmm->config.page_size);
+        pte_set_dirty(pte, vmm->frame_allocator->frames[pte_frame(pte)].dirty);
+    }
+    metrics_record_thp_split(vmm->metrics);
+    return pagetable_lookup(proc->page_table, vpn * vmm->config.page_size);
+}
+
+// Evict a victim frame: unmap it, write it back if dirty, and return it to the free pool
+static void vmm_evict_frame(VMM *vmm, uint32_t victim, uint64_t issue_ns, AccessCost *cost,
+                            bool background)
+{
+    FrameInfo *victim_frame = frame_get_info(vmm->frame_allocator, victim);
+    Process *victim_proc = vmm_get_process(vmm, victim_frame->pid);
+    if (victim_proc) {
+        vmm->pt_epoch++;
+        uint64_t victim_addr = victim_frame->vpn * vmm->config.page_size;
+        PageTableEntry *victim_pte = pagetable_lookup(victim_proc->page_table, victim_addr);
+        if (victim_pte && (pte_flags(victim_pte) & PTE_HUGE)) {
+            victim_pte = vmm_split_huge(vmm, victim_proc, victim_frame->vpn);
+        }
+        if (victim_pte) {
+            // If dirty, swap out
+            if (victim_frame->dirty) {
+                int32_t swap_slot = swap_alloc(vmm->swap, victim_frame->pid, victim_frame->vpn);
+                if (swap_slot >= 0) {
+                    // Dirty write-back is charged to the faulting access
+                    uint64_t write_ns =
+                        swap_out(vmm->swap, swap_slot,
+                                 frame_get_data(vmm->frame_allocator, victim), issue_ns);
+                    if (write_ns > cost->io_ns)
+                        cost->io_ns = write_ns;
+                    metrics_record_swap_out(vmm->metrics);
+                    pte_set_swap_slot(victim_pte, (uint64_t)swap_slot);
+                }
+            }
+            pagetable_unmap(victim_proc->page_table, victim_addr);
+
+            // Invalidate TLB entry
+            vmm_tlb_invalidate(vmm, victim_proc, victim_frame->vpn);
+            tlb_invalidate(vmm->base_tlb, victim_frame->pid, victim_frame->vpn);
+        }
+    }
+
+    if (victim_frame->readahead) {
+        metrics_record_readahead_wasted(vmm->metrics);
+    }
+    if (victim_frame->untouched) {
+        vmm->huge_untouched--;
+    }
+    frame_free(vmm->frame_allocator, victim);
+    metrics_record_replacement(vmm->metrics);
+    metrics_record_reclaim(vmm->metrics, background);
+}
+
+// Select up to count victims in one policy pass and evict them all
+static uint32_t vmm_reclaim_frames(VMM *vmm, uint32_t count, uint64_t issue_ns, AccessCost *cost,
+                                   bool background)
+{
+    uint32_t victims[VMM_MAX_RECLAIM_BATCH];
+    if (count > VMM_MAX_RECLAIM_BATCH)
+        count = VMM_MAX_RECLAIM_BATCH;
+
+    uint64_t steps = vmm->replacement_policy->select_steps;
+    uint32_t found =
+        replacement_select_victims(vmm->replacement_policy, vmm->frame_allocator, victims, count);
+    metrics_record_victim_selection(vmm->metrics, found,
+                                    vmm->replacement_policy->select_steps - steps);
+    if (found == 0) {
+        LOG_ERROR_MSG("Failed to select victim frame");
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < found; i++) {
+        vmm_evict_frame(vmm, victims[i], issue_ns, cost, background);
+    }
+    return found;
+}
+
+// One kswapd pass: reclaim a batch toward the high watermark, then start the
+// write-back of whatever it cleaned. Nobody waits on either.
+static void vmm_kswapd_run(void *ctx, uint64_t arg, uint64_t time_ns)
+{
+    VMM *vmm = ctx;
+    (void)arg;
+
+    AccessCost unused = {0, 0, 0};
+    uint32_t free_frames = frame_get_free_count(vmm->frame_allocator);
+    uint32_t reclaimed = 0;
+    if (free_frames < vmm->wmark_high) {
+        uint32_t want = vmm->wmark_high - free_frames;
+        reclaimed = vmm_reclaim_frames(vmm, want < KSWAPD_BATCH ? want : KSWAPD_BATCH, time_ns,
+                                       &unused, true);
+    }
+    swap_flush(vmm->swap, time_ns);
+
+    if (reclaimed > 0 && frame_get_free_count(vmm->frame_allocator) < vmm->wmark_high) {
+        simclock_schedule(vmm->clock, time_ns + KSWAPD_BATCH * KSWAPD_PAGE_NS, vmm_kswapd_run,
+                          vmm, 0);
+    } else {
+        vmm->kswapd_running = false;
+    }
+}
+
+static void vmm_wake_kswapd(VMM *vmm)
+{
+    if (!vmm->config.kswapd || vmm->kswapd_running ||
+        frame_get_free_count(vmm->frame_allocator) >= vmm->wmark_low) {
+        return;
+    }
+    vmm->kswapd_running = true;
+    vmm->metrics->kswapd_wakeups++;
+    simclock_schedule(vmm->clock, simclock_now(vmm->clock) + KSWAPD_BATCH * KSWAPD_PAGE_NS,
+                      vmm_kswapd_run, vmm, 0);
+}
+
+// Readahead window size, following Linux's swap cluster readahead: grow with the
+// hits since the last window, fall back to one page on non-sequential faults
+// without hits, and never shrink by more than half at a time
+static uint32_t vmm_readahead_window(VMM *vmm, uint32_t slot)
+{
+    uint32_t max_window = vmm->config.swap_readahead;
+    if (max_window <= 1)
+        return 1;
+
+    uint32_t hits = vmm->ra_hits;
+    vmm->ra_hits = 0;
+
+    uint32_t pages = hits + 2;
+    if (pages == 2) {
+        if (slot != vmm->ra_prev_slot + 1 && slot + 1 != vmm->ra_prev_slot)
+            pages = 1;
+    } else {
+        uint32_t rounded = 1;
+        while (rounded < pages)
+            rounded <<= 1;
+        pages = rounded;
+    }
+    if (pages > max_window)
+        pages = max_window;
+    if (pages < vmm->ra_prev_window / 2)
+        pages = vmm->ra_prev_window / 2;
+
+    vmm->ra_prev_window = pages;
+    vmm->ra_prev_slot = slot;
+    return pages;
+}
+
+// Swapped-out pages of proc in the aligned window around slot, in slot order
+static uint32_t vmm_collect_readahead(VMM *vmm, Process *proc, uint32_t slot, uint32_t *ra_slots,
+                                      PageTableEntry **ra_ptes)
+{
+    uint32_t window = vmm_readahead_window(vmm, slot);
+    if (window <= 1)
+        return 0;
+
+    // Never let speculation claim more than a quarter of memory; halving keeps the
+    // window a power of two, so it stays aligned
+    while (window > 1 && window > vmm->config.num_frames / 4)
+        window /= 2;
+    if (window <= 1)
+        return 0;
+
+    uint32_t count = 0;
+    uint32_t start = slot & ~(window - 1);
+    for (uint32_t s = start; s < start + window; s++) {
+        uint32_t pid;
+        uint64_t vpn;
+        if (s == slot || !swap_slot_on_device(vmm->swap, s, &pid, &vpn) || pid != proc->pid)
+            continue;
+        PageTableEntry *pte =
+            pagetable_lookup(proc->page_table, vpn * vmm->config.page_size);
+        if (!pte || pte_is_valid(pte) || !(pte_flags(pte) & PTE_SWAPPED) ||
+            pte_swap_slot(pte) != s)
+            continue;
+        ra_slots[count] = s;
+        ra_ptes[count] = pte;
+        count++;
+    }
+    return count;
+}
+
+// First use of a page brought in by readahead
+static void vmm_readahead_hit(VMM *vmm, uint32_t pfn)
+{
+    vmm->frame_allocator->frames[pfn].readahead = false;
+    vmm->ra_hits++;
+    metrics_record_readahead_hit(vmm->metrics);
+    replacement_on_readahead_hit(vmm->replacement_policy, pfn);
+}
+
+// First reference to a page mapped speculatively (readahead) or as part of a huge page
+static void vmm_note_reference(VMM *vmm, uint32_t pfn)
+{
+    FrameInfo *frame = &vmm->frame_allocator->frames[pfn];
+    if (frame->readahead) {
+        vmm_readahead_hit(vmm, pfn);
+    }
+    if (frame->untouched) {
+        frame->untouched = false;
+        vmm->huge_untouched--;
+    }
+}
+
+// Map a whole huge page on the first fault anywhere in its region; every other
+// base page in it is bloat until it is referenced
+static void vmm_map_huge(VMM *vmm, Process *proc, uint64_t vpn, uint32_t first, bool is_write)
+{
+    FrameAllocator *fa = vmm->frame_allocator;
+    uint64_t base_vpn = vpn & ~(uint64_t)(vmm->huge_pages - 1);
+
+    uint8_t *data = frame_get_data(fa, first);
+    if (data) {
+        memset(data, 0, (uint64_t)vmm->huge_pages * vmm->config.page_size);
+    }
+
+    for (uint32_t i = 0; i < vmm->huge_pages; i++) {
+        uint32_t f = first + i;
+        frame_set_pid(fa, f, proc->pid);
+        frame_set_vpn(fa, f, base_vpn + i);
+        frame_set_dirty(fa, f, false);
+        fa->frames[f].untouched = base_vpn + i != vpn;
+        replacement_on_allocate(vmm->replacement_policy, f, fa);
+    }
+    uint32_t pfn = first + (uint32_t)(vpn - base_vpn);
+    frame_set_dirty(fa, pfn, is_write);
+    if (is_write) {
+        vmm_stamp_page(vmm, pfn, proc->pid, vpn);
+    }
+
+    uint32_t flags = PTE_VALID | PTE_USER;
+    if (is_write) {
+        flags |= PTE_WRITE | PTE_DIRTY;
+    }
+    pagetable_map_huge(proc->page_table, base_vpn * vmm->config.page_size, first, flags);
+
+    vmm->huge_untouched += vmm->huge_pages - 1;
+    uint64_t bloat = vmm->huge_untouched * vmm->config.page_size;
+    if (bloat > vmm->metrics->huge_bloat_bytes)
+        vmm->metrics->huge_bloat_bytes = bloat;
+}
+
+// khugepaged: once every base page of a region is resident, migrate the region
+// into one huge page. Runs off the fault path, so nobody is charged for the copy.
+static void vmm_try_collapse(VMM *vmm, Process *proc, uint64_t vpn)
+{
+    FrameAllocator *fa = vmm->frame_allocator;
+    uint64_t page_size = vmm->config.page_size;
+    uint64_t base_vpn = vpn & ~(uint64_t)(vmm->huge_pages - 1);
+
+    PageTableEntry *pte = pagetable_lookup(proc->page_table, vpn * page_size);
+    if (!pte || (pte_flags(pte) & PTE_HUGE) ||
+        pagetable_region_valid(proc->page_table, vpn * page_size) != vmm->huge_pages) {
+        return;
+    }
+
+    int32_t first = vmm_alloc_huge(vmm);
+    metrics_record_thp_collapse(vmm->metrics, first >= 0);
+    if (first < 0) {
+        return;
+    }
+
+    uint32_t flags = PTE_VALID | PTE_USER;
+    for (uint32_t i = 0; i < vmm->huge_pages; i++) {
+        PageTableEntry *old = pagetable_lookup(proc->page_table, (base_vpn + i) * page_size);
+        uint32_t from = pte_frame(old);
+        uint32_t to = (uint32_t)first + i;
+        flags |= pte_flags(old) & (PTE_WRITE | PTE_DIRTY);
+
+        uint8_t *src = frame_get_data(fa, from);
+        if (src) {
+            memcpy(frame_get_data(fa, to), src, page_size);
+        }
+
+        // The page keeps its replacement state across the move
+        FrameInfo *dst = &fa->frames[to];
+        const FrameInfo *info = &fa->frames[from];
+        dst->pid = info->pid;
+        dst->vpn = info->vpn;
+        dst->dirty = info->dirty;
+        fa->ages[to] = fa->ages[from];
+        dst->last_access_time = info->last_access_time;
+        dst->readahead = info->readahead;
+        dst->untouched = info->untouched;
+        frame_set_reference(fa, to, frame_is_referenced(fa, from));
+
+        replacement_on_move(vmm->replacement_policy, from, to, fa);
+        frame_free(fa, from);
+        vmm_tlb_invalidate(vmm, proc, base_vpn + i);
+    }
+    pagetable_map_huge(proc->page_table, base_vpn * page_size, (uint32_t)first, flags);
+    LOG_DEBUG_MSG("Collapsed PID=%u VPN=0x%lx into huge page at frame %d", proc->pid, base_vpn,
+                  first);
+}
+
 // Handle page fault
-static bool vmm_handle_page_fault(VMM *vmm, Process *proc, uint64_t virtual_addr, bool is_write)
+static bool vmm_handle_page_fault(VMM *vmm, Process *proc, uint64_t virtual_addr, bool is_write,
+                                  AccessCost *cost)
 {
     LOG_DEBUG_MSG("Page fault: PID=%u, addr=0x%lx, %s", proc->pid, virtual_addr,
                   is_write ? "WRITE" : "READ");
 
+    // Mapping (and any reclaim or collapse) can move entries under cached pointers
+    vmm->pt_epoch++;
+
+    // No entry means no L2 table yet: nothing in the region is mapped or swapped
     uint64_t vpn = virtual_addr / vmm->config.page_size;
     PageTableEntry *pte = pagetable_lookup(proc->page_table, virtual_addr);
 
-    if (!pte) {
-        LOG_ERROR_MSG("Invalid address: 0x%lx", virtual_addr);
-        return false;
-    }
-
     bool is_major_fault = false;
 
-    // Try to allocate a frame
-    int32_t frame_num = frame_alloc(vmm->frame_allocator);
-
-    // If no free frames, select victim and evict
-    if (frame_num < 0) {
-        LOG_DEBUG_MSG("No free frames, selecting victim");
-        frame_num = replacement_select_victim(vmm->replacement_policy, vmm->frame_allocator);
+    // Kernel fault handling runs before any I/O is issued
+    uint64_t handling_ns = vmm->config.access_times.page_fault_time_us * 1000;
+    cost->cpu_ns += handling_ns;
+    uint64_t issue_ns = simclock_now(vmm->clock) + cost->cpu_ns;
+
+    // A swap-in from the device also reads this process's neighboring slots
+    bool from_swap = pte && (pte_flags(pte) & PTE_SWAPPED);
+    uint32_t slot = from_swap ? (uint32_t)pte_swap_slot(pte) : 0;
+    uint32_t ra_slots[VMM_MAX_READAHEAD];
+    PageTableEntry *ra_ptes[VMM_MAX_READAHEAD];
+    uint32_t ra_count = 0;
+    if (from_swap && !swap_is_staged(vmm->swap, slot)) {
+        ra_count = vmm_collect_readahead(vmm, proc, slot, ra_slots, ra_ptes);
+    }
 
-        if (frame_num < 0) {
-            LOG_ERROR_MSG("Failed to select victim frame");
-            return false;
+    replacement_on_fault(vmm->replacement_policy, proc->pid, vpn);
+
+    // Free enough frames for the faulting page and its readahead before taking any,
+    // so reclaim never picks a frame this fault is filling. With kswapd the fault
+    // only reclaims directly when that would dip into the min reserve.
+    uint32_t needed = 1 + ra_count + (vmm->config.kswapd ? vmm->wmark_min : 0);
+    while (frame_get_free_count(vmm->frame_allocator) < needed) {
+        LOG_DEBUG_MSG("Free frames below reserve, reclaiming directly");
+        uint32_t shortfall = needed - frame_get_free_count(vmm->frame_allocator);
+        uint32_t batch = vmm->config.reclaim_batch;
+        if (vmm_reclaim_frames(vmm, shortfall > batch ? shortfall : batch, issue_ns, cost,
+                               false) == 0) {
+            if (frame_get_free_count(vmm->frame_allocator) == 0)
+                return false;
+            break;
         }
+    }
 
-        // Evict victim frame
-        FrameInfo *victim_frame = frame_get_info(vmm->frame_allocator, frame_num);
-        if (victim_frame) {
-            // Find victim's page table entry and invalidate
-            Process *victim_proc = vmm_get_process(vmm, victim_frame->pid);
-            if (victim_proc) {
-                uint64_t victim_addr = victim_frame->vpn * vmm->config.page_size;
-                PageTableEntry *victim_pte =
-                    pagetable_lookup(victim_proc->page_table, victim_addr);
-                if (victim_pte) {
-                    // If dirty, swap out
-                    if (victim_frame->dirty) {
-                        int32_t swap_slot =
-                            swap_alloc(vmm->swap, victim_frame->pid, victim_frame->vpn);
-                        if (swap_slot >= 0) {
-                            swap_out(vmm->swap, swap_slot, NULL);
-                            metrics_record_swap_out(vmm->metrics);
-                            victim_pte->swap_offset = swap_slot;
-                        }
-                    }
-                    pte_set_valid(victim_pte, false);
-
-                    // Invalidate TLB entry
-                    tlb_invalidate(vmm->tlb, victim_frame->pid, victim_frame->vpn);
-                }
-            }
+    // Eager mode: the first touch of an empty region maps the whole huge page when
+    // aligned frames are free. THP instead faults base pages and collapses later.
+    if (!pte && vmm->huge_pages && !vmm->config.thp) {
+        int32_t first = vmm_alloc_huge(vmm);
+        metrics_record_huge_fault(vmm->metrics, first < 0);
+        if (first >= 0) {
+            vmm_map_huge(vmm, proc, vpn, (uint32_t)first, is_write);
+            vmm_wake_kswapd(vmm);
+            metrics_record_page_fault(vmm->metrics, proc->pid, false);
+            cost->stall_ns += handling_ns + cost->io_ns;
+            metrics_record_fault_latency(vmm->metrics, handling_ns + cost->io_ns);
+            return true;
         }
+    }
 
-        metrics_record_replacement(vmm->metrics);
+    // Reclaimed victims went back to the free pool, so the faulting page gets a
+    // freshly allocated frame with its own replacement state
+    int32_t frame_num = frame_alloc(vmm->frame_allocator);
+    if (frame_num < 0) {
+        LOG_ERROR_MSG("Failed to allocate a frame");
+        return false;
+    }
+    uint32_t ra_frames[VMM_MAX_READAHEAD];
+    uint32_t ra_taken = 0;
+    for (; ra_taken < ra_count; ra_taken++) {
+        int32_t f = frame_alloc(vmm->frame_allocator);
+        if (f < 0)
+            break;
+        ra_frames[ra_taken] = (uint32_t)f;
     }
+    ra_count = ra_taken;
+    vmm_wake_kswapd(vmm);
 
     // Check if page is in swap
-    if (pte->swap_offset > 0) {
-        // Swap in
-        swap_in(vmm->swap, pte->swap_offset, NULL);
+    if (from_swap) {
+        // Swap in (issued alongside any write-back; the process waits for both)
+        uint64_t read_ns;
+        if (ra_count == 0) {
+            read_ns = swap_in(vmm->swap, slot, frame_get_data(vmm->frame_allocator, frame_num),
+                              issue_ns);
+        } else {
+            // Merge the faulting slot into the sorted readahead list
+            uint32_t slots[VMM_MAX_READAHEAD + 1];
+            void *data[VMM_MAX_READAHEAD + 1];
+            uint32_t target = 0;
+            while (target < ra_count && ra_slots[target] < slot)
+                target++;
+            for (uint32_t i = 0; i < ra_count; i++) {
+                uint32_t n = i < target ? i : i + 1;
+                slots[n] = ra_slots[i];
+                data[n] = frame_get_data(vmm->frame_allocator, ra_frames[i]);
+            }
+            slots[target] = slot;
+            data[target] = frame_get_data(vmm->frame_allocator, frame_num);
+            read_ns = swap_in_cluster(vmm->swap, slots, data, ra_count + 1, target, issue_ns);
+            metrics_record_readahead(vmm->metrics, ra_count);
+        }
+        if (read_ns > cost->io_ns)
+            cost->io_ns = read_ns;
+        vmm_verify_page(vmm, frame_num, proc->pid, vpn);
         metrics_record_swap_in(vmm->metrics);
-        swap_free(vmm->swap, pte->swap_offset);
-        pte->swap_offset = 0;
+        swap_free(vmm->swap, slot);
+        pte_clear_swap_slot(pte);
         is_major_fault = true;
+    } else {
+        // Fresh page: zero-fill like a real kernel would
+        uint8_t *data = frame_get_data(vmm->frame_allocator, frame_num);
+        if (data) {
+            memset(data, 0, vmm->config.page_size);
+        }
     }
 
     // Map page to frame
@@ -292,14 +994,41 @@ static bool vmm_handle_page_fault(VMM *vmm, Process *proc, uint64_t virtual_addr
     frame_set_pid(vmm->frame_allocator, frame_num, proc->pid);
     frame_set_vpn(vmm->frame_allocator, frame_num, vpn);
     frame_set_dirty(vmm->frame_allocator, frame_num, is_write);
+    if (is_write) {
+        vmm_stamp_page(vmm, frame_num, proc->pid, vpn);
+    }
 
     // Notify replacement policy
-    replacement_on_allocate(vmm->replacement_policy, frame_num);
+    replacement_on_allocate(vmm->replacement_policy, frame_num, vmm->frame_allocator);
+
+    // Map the read-ahead pages clean, at the lowest replacement priority
+    for (uint32_t i = 0; i < ra_count; i++) {
+        uint32_t f = ra_frames[i];
+        uint64_t ra_vpn = vmm->swap->slots[ra_slots[i]].vpn;
+        pte_clear_swap_slot(ra_ptes[i]);
+        pagetable_map(proc->page_table, ra_vpn * vmm->config.page_size, f, PTE_VALID | PTE_USER);
+        swap_free(vmm->swap, ra_slots[i]);
+
+        frame_set_pid(vmm->frame_allocator, f, proc->pid);
+        frame_set_vpn(vmm->frame_allocator, f, ra_vpn);
+        frame_set_dirty(vmm->frame_allocator, f, false);
+        vmm_verify_page(vmm, f, proc->pid, ra_vpn);
+        vmm->frame_allocator->frames[f].readahead = true;
+        replacement_on_readahead(vmm->replacement_policy, f, vmm->frame_allocator);
+    }
+
+    if (vmm->config.thp) {
+        vmm_try_collapse(vmm, proc, vpn);
+    }
 
     // Update metrics
     metrics_record_page_fault(vmm->metrics, proc->pid, is_major_fault);
 
-    LOG_DEBUG_MSG("Page fault handled: allocated frame %d", frame_num);
+    cost->stall_ns += handling_ns + cost->io_ns;
+    metrics_record_fault_latency(vmm->metrics, handling_ns + cost->io_ns);
+
+    LOG_DEBUG_MSG("Page fault handled: allocated frame %d (+%u read ahead)", frame_num,
+                  ra_count);
     return true;
 }
 
@@ -309,18 +1038,27 @@ bool vmm_access(VMM *vmm, uint32_t pid, uint64_t virtual_addr, bool is_write)
         return false;
     }
 
-    // Find or create process
-    Process *proc = vmm_get_process(vmm, pid);
-    if (!proc) {
-        if (!vmm_add_process(vmm, pid)) {
+    // Find or create process (consecutive accesses usually come from the same one)
+    Process *proc = vmm->last_proc;
+    if (!proc || proc->pid != pid) {
+        proc = vmm_get_process(vmm, pid);
+        if (!proc) {
+            if (!vmm_add_process(vmm, pid)) {
+                return false;
+            }
+            proc = vmm_get_process(vmm, pid);
+        }
+
+        if (!proc) {
+            LOG_ERROR_MSG("Failed to get process %u", pid);
             return false;
         }
-        proc = vmm_get_process(vmm, pid);
+        vmm->last_proc = proc;
     }
 
-    if (!proc) {
-        LOG_ERROR_MSG("Failed to get process %u", pid);
-        return false;
+    // A process blocked on swap I/O cannot issue its next access until it completes
+    if (proc->blocked) {
+        simclock_advance_to(vmm->clock, proc->ready_time_ns);
     }
 
     // Record access
@@ -328,11 +1066,39 @@ bool vmm_access(VMM *vmm, uint32_t pid, uint64_t virtual_addr, bool is_write)
 
     uint64_t vpn = virtual_addr / vmm->config.page_size;
     uint32_t pfn;
+    AccessCost cost = {vmm->config.access_times.tlb_hit_time_ns, 0, 0};
+
+    // What the TLB would have hit with base pages only
+    if (vmm->base_tlb) {
+        if (tlb_lookup(vmm->base_tlb, pid, vpn, &pfn))
+            metrics_record_base_tlb_hit(vmm->metrics);
+        else
+            tlb_insert(vmm->base_tlb, pid, vpn, 0);
+    }
 
-    // Step 1: TLB lookup
-    if (tlb_lookup(vmm->tlb, pid, vpn, &pfn)) {
+    // Step 1: TLB lookup. The page this process hit last is checked first, in
+    // the one L1 slot that held it; that is still a TLB hit, counted as one.
+    uint32_t tlb_level;
+    LastTranslation *last = &proc->last;
+    if (last->valid && last->vpn == vpn &&
+        tlb_hit_slot(vmm->tlb, last->tlb_slot, pid, vpn)) {
+        pfn = last->pfn;
+        tlb_level = 1;
+        metrics_record_fast_path_hit(vmm->metrics);
+    } else {
+        // An STLB hit costs its extra latency
+        tlb_level = tlb_lookup_level(vmm->tlb, pid, vpn, &pfn);
+        if (tlb_level > 1 || (tlb_level == 0 && vmm->tlb->next)) {
+            cost.cpu_ns += vmm->config.access_times.stlb_hit_time_ns;
+        }
+        if (tlb_level) {
+            vmm_remember(vmm, proc, vpn, pfn, NULL);
+        }
+    }
+    if (tlb_level) {
         // TLB hit
         metrics_record_tlb_hit(vmm->metrics, pid);
+        vmm_note_reference(vmm, pfn);
 
         // Update replacement policy
         replacement_on_access(vmm->replacement_policy, pfn, vmm->frame_allocator);
@@ -340,30 +1106,36 @@ bool vmm_access(VMM *vmm, uint32_t pid, uint64_t virtual_addr, bool is_write)
         // Update dirty bit if write
         if (is_write) {
             frame_set_dirty(vmm->frame_allocator, pfn, true);
-            PageTableEntry *pte = pagetable_lookup(proc->page_table, virtual_addr);
+            PageTableEntry *pte = vmm_last_pte(vmm, proc, virtual_addr);
             if (pte) {
                 pte_set_dirty(pte, true);
             }
+            vmm_stamp_page(vmm, pfn, pid, vpn);
         }
 
         LOG_TRACE_MSG("Access: PID=%u, addr=0x%lx, TLB HIT -> frame %u", pid, virtual_addr, pfn);
+        vmm_charge_access(vmm, proc, &cost);
         return true;
     }
 
     // TLB miss
     metrics_record_tlb_miss(vmm->metrics, pid);
-
-    // Step 2: Page table lookup
-    PageTableEntry *pte = pagetable_lookup(proc->page_table, virtual_addr);
-    if (!pte) {
+    if (virtual_addr >= vmm->config.virtual_addr_space) {
         LOG_ERROR_MSG("Invalid virtual address: 0x%lx", virtual_addr);
         return false;
     }
 
+    // Step 2: Page table walk (a huge-page leaf ends the walk a level early)
+    PageTableEntry *pte = pagetable_lookup(proc->page_table, virtual_addr);
+    cost.cpu_ns += (uint64_t)vmm_walk_refs(vmm, proc, vpn, pte) *
+                   vmm->config.access_times.memory_access_time_ns;
+
     if (pte_is_valid(pte)) {
         // Page is in memory, update TLB
-        pfn = pte->frame_number;
-        tlb_insert(vmm->tlb, pid, vpn, pfn);
+        pfn = vmm_pte_frame(vmm, pte, vpn);
+        vmm_tlb_fill(vmm, pid, vpn, pte);
+        vmm_remember(vmm, proc, vpn, pfn, pte);
+        vmm_note_reference(vmm, pfn);
 
         // Update replacement policy
         replacement_on_access(vmm->replacement_policy, pfn, vmm->frame_allocator);
@@ -372,26 +1144,110 @@ bool vmm_access(VMM *vmm, uint32_t pid, uint64_t virtual_addr, bool is_write)
         if (is_write) {
             frame_set_dirty(vmm->frame_allocator, pfn, true);
             pte_set_dirty(pte, true);
+            vmm_stamp_page(vmm, pfn, pid, vpn);
         }
 
         LOG_TRACE_MSG("Access: PID=%u, addr=0x%lx, PT HIT -> frame %u", pid, virtual_addr, pfn);
+        vmm_charge_access(vmm, proc, &cost);
         return true;
     }
 
     // Step 3: Page fault
-    if (!vmm_handle_page_fault(vmm, proc, virtual_addr, is_write)) {
+    if (!vmm_handle_page_fault(vmm, proc, virtual_addr, is_write, &cost)) {
         return false;
     }
 
     // Update TLB with new mapping
     pte = pagetable_lookup(proc->page_table, virtual_addr);
     if (pte && pte_is_valid(pte)) {
-        tlb_insert(vmm->tlb, pid, vpn, pte->frame_number);
+        vmm_tlb_fill(vmm, pid, vpn, pte);
+        vmm_remember(vmm, proc, vpn, vmm_pte_frame(vmm, pte, vpn), pte);
     }
 
+    vmm_charge_access(vmm, proc, &cost);
     return true;
 }
 
+// One trace access plus the periodic work between accesses
+static void vmm_run_step(VMM *vmm, const TraceEntry *entry, uint64_t i, uint64_t max_accesses)
+{
+    bool success = vmm_access(vmm, entry->pid, entry->virtual_addr, entry->op == OP_WRITE);
+    if (!success) {
+        LOG_WARN_MSG("Failed to access memory at index %lu", i);
+    }
+
+    // Periodic aging for approximate LRU
+    if (vmm->replacement_policy->algorithm == REPLACE_APPROX_LRU &&
+        i % vmm->config.aging_interval == 0) {
+        uint64_t start = get_monotonic_ns();
+        frame_age_all(vmm->frame_allocator);
+        metrics_record_aging(vmm->metrics, vmm->frame_allocator->total_frames,
+                             get_monotonic_ns() - start);
+    }
+
+    // Progress indicator
+    if (vmm->config.verbose && i > 0 && i % 10000 == 0) {
+        fprintf(stderr, "Progress: %llu / %llu accesses (%.1f%%)\r", 
+                (unsigned long long)i, (unsigned long long)max_accesses,
+                100.0 * i / max_accesses);
+    }
+}
+
+// End of a run: drain I/O and gather what the components counted
+static void vmm_run_finish(VMM *vmm)
+{
+    if (vmm->config.verbose) {
+        fprintf(stderr, "\n");
+    }
+
+    // Let outstanding I/O complete so the run ends when the last process does,
+    // including write-back still sitting in the batch
+    simclock_drain(vmm->clock);
+    uint64_t end_ns = simclock_now(vmm->clock);
+    end_ns += swap_flush(vmm->swap, end_ns);
+    metrics_set_sim_time(vmm->metrics, end_ns);
+    vmm->metrics->swap_device = vmm->swap->device->stats;
+    vmm->metrics->swap_device.clusters = vmm->swap->num_clusters;
+    vmm->metrics->swap_device.free_clusters = vmm->swap->free_clusters_top;
+    vmm->metrics->swap_device.cluster_fallbacks = vmm->swap->cluster_fallbacks;
+    vmm->metrics->real_io = vmm->swap->io;
+
+    // Page-table footprint across all processes
+    for (uint32_t p = 0; p < vmm->num_processes; p++) {
+        PageTable *pt = vmm->processes[p].page_table;
+        vmm->metrics->pt_memory_bytes += pagetable_memory_bytes(pt);
+        if (pt->type == PT_RADIX_4 || pt->type == PT_RADIX_5) {
+            vmm->metrics->pt_levels = pt->table.radix.levels;
+            for (uint32_t l = 0; l < pt->table.radix.levels; l++)
+                vmm->metrics->pt_nodes[l] += pt->table.radix.nodes[l];
+        }
+    }
+    vmm->metrics->pt_processes = vmm->num_processes;
+    vmm->metrics->walks = vmm->walk_cache->stats;
+    memcpy(vmm->metrics->hand_moves, vmm->replacement_policy->cp_moves,
+           sizeof(vmm->metrics->hand_moves));
+    if (vmm->replacement_policy->algorithm == REPLACE_ARC) {
+        vmm->metrics->arc_l1_max = vmm->replacement_policy->arc_l1_max;
+        vmm->metrics->arc_capacity = vmm->replacement_policy->num_frames;
+    }
+    if (vmm->tlb->next) {
+        vmm->metrics->stlb_lookups = vmm->tlb->next->lookups;
+        vmm->metrics->stlb_hits = vmm->tlb->next->hits;
+    }
+    if (vmm->inverted) {
+        vmm->metrics->pt_memory_bytes += inverted_table_memory_bytes(vmm->inverted);
+        vmm->metrics->inverted = vmm->inverted->stats;
+    }
+
+    metrics_end_simulation(vmm->metrics);
+
+    if (vmm->metrics->aging_sweeps > 0) {
+        LOG_INFO_MSG("Ages after %lu sweeps: digest 0x%016lx", vmm->metrics->aging_sweeps,
+                     frame_age_digest(vmm->frame_allocator));
+    }
+    LOG_INFO_MSG("Trace execution completed");
+}
+
 bool vmm_run_trace(VMM *vmm, Trace *trace)
 {
     if (!vmm || !trace) {
@@ -401,8 +1257,10 @@ bool vmm_run_trace(VMM *vmm, Trace *trace)
     LOG_INFO_MSG("Running trace with %lu entries", trace->count);
 
     // Set trace for OPT algorithm
-    if (vmm->replacement_policy->algorithm == REPLACE_OPT) {
-        replacement_set_trace(vmm->replacement_policy, trace);
+    if (!replacement_set_trace(vmm->replacement_policy, trace, vmm->config.page_size)) {
+        LOG_ERROR_MSG("Failed to prepare %s for the trace",
+                      replacement_get_name(vmm->replacement_policy->algorithm));
+        return false;
     }
 
     metrics_start_simulation(vmm->metrics);
@@ -421,31 +1279,44 @@ bool vmm_run_trace(VMM *vmm, Trace *trace)
             replacement_set_position(vmm->replacement_policy, i);
         }
 
-        bool success = vmm_access(vmm, entry->pid, entry->virtual_addr, entry->op == OP_WRITE);
-        if (!success) {
-            LOG_WARN_MSG("Failed to access memory at index %lu", i);
-        }
+        vmm_run_step(vmm, entry, i, max_accesses);
+    }
 
-        // Periodic aging for approximate LRU
-        if (vmm->replacement_policy->algorithm == REPLACE_APPROX_LRU && i % 1000 == 0) {
-            frame_age_all(vmm->frame_allocator);
-        }
+    vmm_run_finish(vmm);
+    return true;
+}
 
-        // Progress indicator
-        if (vmm->config.verbose && i > 0 && i % 10000 == 0) {
-            fprintf(stderr, "Progress: %llu / %llu accesses (%.1f%%)\r", 
-                    (unsigned long long)i, (unsigned long long)max_accesses,
-                    100.0 * i / max_accesses);
-        }
+bool vmm_run_spilled(VMM *vmm, NextUseSpill *spill)
+{
+    if (!vmm || !spill || !spill->first_use) {
+        return false;
     }
 
-    if (vmm->config.verbose) {
-        fprintf(stderr, "\n");
-    }
+    LOG_INFO_MSG("Running spilled trace with %lu entries", spill->count);
 
-    metrics_end_simulation(vmm->metrics);
+    // The policy takes over the first-use map and is fed next uses as the replay reads them
+    replacement_set_first_uses(vmm->replacement_policy, spill->first_use,
+                               vmm->config.page_size);
+    spill->first_use = NULL;
 
-    LOG_INFO_MSG("Trace execution completed");
+    metrics_start_simulation(vmm->metrics);
+
+    uint64_t max_accesses =
+        (vmm->config.max_instructions < spill->count) ? vmm->config.max_instructions : spill->count;
+
+    TraceEntry entry;
+    uint64_t next_use;
+    for (uint64_t i = 0; i < max_accesses; i++) {
+        if (!nextuse_spill_get(spill, i, &entry, &next_use)) {
+            break;
+        }
+
+        replacement_advance(vmm->replacement_policy, i, entry.pid,
+                            entry.virtual_addr / vmm->config.page_size, next_use);
+        vmm_run_step(vmm, &entry, i, max_accesses);
+    }
+
+    vmm_run_finish(vmm);
     return true;
 }
 
@@ -17,6 +17,15 @@
 #include "replacement.h"
 #include "metrics.h"
 #include "trace.h"
+#include "simclock.h"
+#include "walkcache.h"
+#include "nextuse.h"
+
+// Largest swap readahead window (pages)
+#define VMM_MAX_READAHEAD 64
+
+// Largest number of victims selected in one policy pass
+#define VMM_MAX_RECLAIM_BATCH 256
 
 // VMM configuration
 typedef struct {
@@ -27,17 +36,36 @@ typedef struct {
     uint64_t virtual_addr_space;    // Virtual address space per process
     
     // TLB configuration
-    uint32_t tlb_size;
-    TLBPolicy tlb_policy;
+    uint32_t tlb_size;              // L1 dTLB entries
+    uint32_t tlb_ways;              // L1 associativity (0 = fully associative)
+    uint32_t stlb_size;             // Second-level TLB entries (0 = none)
+    uint32_t stlb_ways;             // STLB associativity (0 = fully associative)
+    TLBPolicy tlb_policy;           // Replacement within a set, both levels
+    uint32_t walk_cache_entries;    // Paging-structure cache per upper level, 0 = off
+    SimdLevel simd;                 // Vector kernels, SIMD_AUTO = widest available
     
     // Page table configuration
     PageTableType pt_type;
+    uint64_t huge_page_size;        // 0 = base pages only
+    bool thp;                       // Collapse fully populated regions into huge pages
+    bool pt_reserve;                // Flat tables in reserved, lazily committed memory
     
     // Replacement algorithm
     ReplacementAlgorithm replacement_algo;
     
     // Swap configuration
     uint32_t swap_size_mb;
+    SwapDeviceType swap_device;     // Device timing profile
+    uint32_t swap_queue_depth;      // 0 = profile default
+    uint32_t swap_readahead;        // Max readahead window in pages (<= 1 disables)
+    bool kswapd;                    // Background reclaim between free-frame watermarks
+    uint32_t reclaim_batch;         // Victims evicted per direct reclaim
+    uint32_t aging_interval;        // Accesses between Approx-LRU aging sweeps
+
+    // Real-data mode (frames hold bytes, swap slots live in a file or device)
+    const char *swap_file;          // NULL = timing simulation only
+    bool direct_io;                 // Open swap_file with O_DIRECT
+    uint32_t io_batch_pages;        // Pages gathered per vectored write
     
     // Simulation parameters
     uint32_t max_processes;
@@ -53,11 +81,24 @@ typedef struct {
     
 } VMMConfig;
 
+// Page a process last hit in the TLB, rechecked before the next lookup
+typedef struct {
+    bool valid;
+    uint64_t vpn;
+    uint32_t pfn;
+    uint32_t tlb_slot;       // L1 dTLB entry that translated vpn
+    PageTableEntry *pte;     // Leaf entry, NULL until a write needs it
+    uint64_t pte_epoch;      // vmm->pt_epoch when pte was looked up
+} LastTranslation;
+
 // Process descriptor
 typedef struct {
     uint32_t pid;
     PageTable *page_table;
     bool active;
+    uint64_t ready_time_ns;  // Simulated time at which outstanding I/O completes
+    bool blocked;            // Waiting on swap I/O
+    LastTranslation last;    // Fast path for repeated accesses to one page
 } Process;
 
 // VMM instance
@@ -70,10 +111,34 @@ typedef struct {
     SwapManager *swap;
     ReplacementPolicy *replacement_policy;
     Metrics *metrics;
+    SimClock *clock;                // Simulated time
+    uint64_t io_in_flight;          // Outstanding swap I/O completions
+
+    // Background reclaim (kswapd): woken below low, reclaims up to high;
+    // faults reclaim directly only below min
+    uint32_t wmark_min;
+    uint32_t wmark_low;
+    uint32_t wmark_high;
+    bool kswapd_running;
+
+    // Huge pages
+    uint32_t huge_pages;            // Base pages per huge page (0 = off)
+    uint32_t huge_bits;             // log2(huge_pages)
+    TLB *base_tlb;                  // Same TLB without huge pages, for comparison
+    InvertedTable *inverted;        // Shared page table when pt_type is PT_INVERTED
+    WalkCache *walk_cache;          // Upper-level entries for TLB-miss walks
+    uint64_t huge_untouched;        // Frames in huge pages not referenced yet
+
+    // Adaptive swap readahead
+    uint32_t ra_hits;               // Readahead hits since the last window was sized
+    uint32_t ra_prev_window;
+    uint32_t ra_prev_slot;
     
     // Process management
     Process *processes;
     uint32_t num_processes;
+    Process *last_proc;             // Process of the previous access
+    uint64_t pt_epoch;              // Bumped whenever page-table entries may move
     
 } VMM;
 
@@ -91,6 +156,9 @@ bool vmm_access(VMM *vmm, uint32_t pid, uint64_t virtual_addr, bool is_write);
 // Run trace
 bool vmm_run_trace(VMM *vmm, Trace *trace);
 
+// Run a trace spilled to disk, reading it and its next uses block by block (OPT)
+bool vmm_run_spilled(VMM *vmm, NextUseSpill *spill);
+
 // Configuration helpers
 void vmm_config_init_default(VMMConfig *config);
 void vmm_config_print(VMMConfig *config, FILE *out);
@@ -0,0 +1,107 @@
+/**
+ * walkcache.c - Paging-structure cache implementation
+ */
+
+#include "walkcache.h"
+#include "util.h"
+#include <stdlib.h>
+
+WalkCache *walkcache_create(uint32_t entries_per_level)
+{
+    WalkCache *wc = calloc(1, sizeof(WalkCache));
+    if (!wc) {
+        LOG_ERROR_MSG("Failed to allocate walk cache");
+        return NULL;
+    }
+
+    wc->entries = entries_per_level;
+    if (entries_per_level > 0) {
+        for (uint32_t l = 1; l < METRICS_PT_MAX_LEVELS; l++) {
+            wc->levels[l] = calloc(entries_per_level, sizeof(WalkCacheEntry));
+            if (!wc->levels[l]) {
+                LOG_ERROR_MSG("Failed to allocate walk cache entries");
+                walkcache_destroy(wc);
+                return NULL;
+            }
+        }
+    }
+    wc->stats.entries_per_level = entries_per_level;
+    return wc;
+}
+
+void walkcache_destroy(WalkCache *wc)
+{
+    if (!wc)
+        return;
+    for (uint32_t l = 0; l < METRICS_PT_MAX_LEVELS; l++)
+        free(wc->levels[l]);
+    free(wc);
+}
+
+static WalkCacheEntry *walkcache_find(WalkCache *wc, uint32_t level, uint32_t pid, uint64_t tag)
+{
+    WalkCacheEntry *set = wc->levels[level];
+    for (uint32_t i = 0; i < wc->entries; i++) {
+        if (set[i].valid && set[i].pid == pid && set[i].tag == tag)
+            return &set[i];
+    }
+    return NULL;
+}
+
+static void walkcache_fill(WalkCache *wc, uint32_t level, uint32_t pid, uint64_t tag)
+{
+    WalkCacheEntry *set = wc->levels[level];
+    WalkCacheEntry *victim = &set[0];
+    for (uint32_t i = 0; i < wc->entries; i++) {
+        if (!set[i].valid) {
+            victim = &set[i];
+            break;
+        }
+        if (set[i].last_use < victim->last_use)
+            victim = &set[i];
+    }
+    victim->valid = true;
+    victim->pid = pid;
+    victim->tag = tag;
+    victim->last_use = ++wc->clock;
+}
+
+uint32_t walkcache_walk(WalkCache *wc, uint32_t pid, uint64_t vpn, const uint32_t *shift,
+                        uint32_t levels, uint32_t leaf_level)
+{
+    if (levels > METRICS_PT_MAX_LEVELS)
+        levels = METRICS_PT_MAX_LEVELS;
+
+    // A cached entry at level l points at the level l - 1 table: the walk
+    // resumes there. Prefer the deepest hit, as hardware does.
+    uint32_t start = levels;
+    if (wc->entries > 0) {
+        for (uint32_t l = leaf_level + 1; l < levels; l++) {
+            WalkCacheEntry *e = walkcache_find(wc, l, pid, vpn >> shift[l]);
+            if (e) {
+                e->last_use = ++wc->clock;
+                wc->stats.hits[l]++;
+                start = l;
+                break;
+            }
+        }
+        // Upper-level entries this walk read
+        for (uint32_t l = leaf_level + 1; l < start; l++)
+            walkcache_fill(wc, l, pid, vpn >> shift[l]);
+    }
+
+    uint32_t refs = start - leaf_level;
+    wc->stats.walks++;
+    wc->stats.refs += refs;
+    wc->stats.refs_uncached += levels - leaf_level;
+    if (levels > wc->stats.levels)
+        wc->stats.levels = levels;
+    return refs;
+}
+
+void walkcache_record(WalkCache *wc, uint32_t refs)
+{
+    wc->stats.walks++;
+    wc->stats.refs += refs;
+    wc->stats.refs_uncached += refs;
+}
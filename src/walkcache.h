@@ -0,0 +1,44 @@
+/**
+ * walkcache.h - Paging-structure (MMU) cache model
+ *
+ * Caches upper-level page table entries the way x86 paging-structure caches
+ * do: one small fully-associative LRU cache per upper level, tagged by the
+ * virtual address bits that select that entry. A TLB miss starts its walk
+ * below the deepest cached level, so each walk costs only the memory
+ * references it actually makes.
+ */
+
+#ifndef WALKCACHE_H
+#define WALKCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "metrics.h"
+
+typedef struct {
+    bool valid;
+    uint32_t pid;
+    uint64_t tag;       // vpn >> shift of the cached level
+    uint64_t last_use;
+} WalkCacheEntry;
+
+typedef struct {
+    uint32_t entries;   // Per cached level (0 disables caching)
+    WalkCacheEntry *levels[METRICS_PT_MAX_LEVELS]; // Indexed by table level; [0] unused
+    uint64_t clock;     // LRU timestamp
+    WalkMetrics stats;
+} WalkCache;
+
+WalkCache *walkcache_create(uint32_t entries_per_level);
+void walkcache_destroy(WalkCache *wc);
+
+// Memory references a walk from level levels - 1 down to leaf_level takes for vpn.
+// shift[l] is the vpn shift that selects an entry at level l. Fills the cache with
+// the upper-level entries the walk reads.
+uint32_t walkcache_walk(WalkCache *wc, uint32_t pid, uint64_t vpn, const uint32_t *shift,
+                        uint32_t levels, uint32_t leaf_level);
+
+// Walks of tables without upper levels (flat or hashed) cost what they cost
+void walkcache_record(WalkCache *wc, uint32_t refs);
+
+#endif // WALKCACHE_H
@@ -116,6 +116,9 @@ start_cli_interactive() {
     echo "  3) CLOCK"
     echo "  4) APPROX_LRU"
     echo "  5) OPT"
+    echo "  6) ARC"
+    echo "  7) LIRS"
+    echo "  8) CLOCK_PRO"
     read -r algo_choice
     
     case $algo_choice in
@@ -124,6 +127,9 @@ start_cli_interactive() {
         3) algo="CLOCK" ;;
         4) algo="APPROX_LRU" ;;
         5) algo="OPT" ;;
+        6) algo="ARC" ;;
+        7) algo="LIRS" ;;
+        8) algo="CLOCK_PRO" ;;
         *) algo="LRU" ;;
     esac
     
@@ -162,7 +168,7 @@ run_benchmarks() {
     mkdir -p benchmarks
     
     echo -e "${YELLOW}Running all algorithms with working_set trace...${NC}"
-    for algo in FIFO LRU CLOCK APPROX_LRU OPT; do
+    for algo in FIFO LRU CLOCK CLOCK_PRO APPROX_LRU ARC LIRS OPT; do
         echo -e "${BLUE}  Testing $algo...${NC}"
         ./bin/vmm -r 64 -p 4096 -t traces/working_set.trace -a "$algo" -T 64 \
             --csv "benchmarks/${algo}_results.csv" --config-name "$algo" > /dev/null
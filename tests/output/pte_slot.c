@@ -0,0 +1,29 @@
+#include "pagetable.h"
+#include <stdio.h>
+
+int main(void)
+{
+    const uint64_t slots[] = {0, 1, UINT32_MAX, 1ULL << 32, 0x123456789aULL,
+                              (1ULL << (64 - PTE_FLAG_BITS)) - 1};
+    const size_t n = sizeof(slots) / sizeof(slots[0]);
+    for (size_t i = 0; i < n; i++) {
+        PageTableEntry pte = {0};
+        pte_set(&pte, 42, PTE_DIRTY | PTE_USER);
+        pte_set_swap_slot(&pte, slots[i]);
+        if (pte_swap_slot(&pte) != slots[i] ||
+            pte_flags(&pte) != (PTE_DIRTY | PTE_USER | PTE_SWAPPED)) {
+            printf("slot 0x%llx read back as 0x%llx, flags 0x%x\n",
+                   (unsigned long long)slots[i], (unsigned long long)pte_swap_slot(&pte),
+                   pte_flags(&pte));
+            return 1;
+        }
+        pte_clear_swap_slot(&pte);
+        if (pte.raw != (PTE_DIRTY | PTE_USER)) {
+            printf("clearing slot 0x%llx left 0x%llx\n", (unsigned long long)slots[i],
+                   (unsigned long long)pte.raw);
+            return 1;
+        }
+    }
+    printf("%zu slots\n", n);
+    return 0;
+}
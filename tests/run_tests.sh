@@ -5,7 +5,7 @@ set -e
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
-BIN_DIR="$PROJECT_ROOT/bin"
+BIN_DIR="${BIN_DIR:-$PROJECT_ROOT/bin}"
 TRACE_DIR="$PROJECT_ROOT/traces"
 OUTPUT_DIR="$SCRIPT_DIR/output"
 
@@ -24,12 +24,12 @@ TESTS_FAILED=0
 # Helper functions
 pass() {
     echo -e "${GREEN}[PASS]${NC} $1"
-    ((TESTS_PASSED++))
+    TESTS_PASSED=$((TESTS_PASSED + 1))
 }
 
 fail() {
     echo -e "${RED}[FAIL]${NC} $1"
-    ((TESTS_FAILED++))
+    TESTS_FAILED=$((TESTS_FAILED + 1))
 }
 
 info() {
@@ -39,6 +39,32 @@ info() {
 # Ensure output directory exists
 mkdir -p "$OUTPUT_DIR"
 
+# Traces shared by several tests, generated once so any test can run without
+# the one that first used them
+# tlb_loop: four passes over 512 pages (Tests 23, 38)
+for pass in 1 2 3 4; do
+    for page in $(seq 0 511); do
+        printf "1 R 0x%x\n" $((page * 4096))
+    done
+done > "$OUTPUT_DIR/tlb_loop.trace"
+# lru_loop: four passes over 257 pages, one more than 1 MB of frames (Tests 25-30, 32, 33, 35)
+for pass in 1 2 3 4; do
+    for page in $(seq 0 256); do
+        printf "1 R 0x%x\n" $((page * 4096))
+    done
+done > "$OUTPUT_DIR/lru_loop.trace"
+# scan_hot: 150 hot pages read twice, then 300 new pages, ten times (Tests 31, 33)
+for round in $(seq 0 9); do
+    for pass in 1 2; do
+        for page in $(seq 0 149); do
+            printf "0 R 0x%x\n" $((page * 4096))
+        done
+    done
+    for page in $(seq 0 299); do
+        printf "0 R 0x%x\n" $(((1000 + round * 300 + page) * 4096))
+    done
+done > "$OUTPUT_DIR/scan_hot.trace"
+
 echo "========================================"
 echo "  VMM Test Suite"
 echo "========================================"
@@ -118,12 +144,12 @@ info "Test 6: TLB performance (small vs large TLB)"
     --csv "$OUTPUT_DIR/tlb_large.csv" > "$OUTPUT_DIR/tlb_large.log" 2>&1
 
 # Extract TLB hit rates
-TLB_SMALL_HITS=$(grep "Hit Rate:" "$OUTPUT_DIR/tlb_small.log" | grep "TLB" | awk '{print $3}' | tr -d '%')
-TLB_LARGE_HITS=$(grep "Hit Rate:" "$OUTPUT_DIR/tlb_large.log" | grep "TLB" | awk '{print $3}' | tr -d '%')
+TLB_SMALL_HITS=$(grep -A3 "TLB Performance:" "$OUTPUT_DIR/tlb_small.log" | grep "Hit Rate:" | awk '{print $3}' | tr -d '%')
+TLB_LARGE_HITS=$(grep -A3 "TLB Performance:" "$OUTPUT_DIR/tlb_large.log" | grep "Hit Rate:" | awk '{print $3}' | tr -d '%')
 
 if [ -n "$TLB_SMALL_HITS" ] && [ -n "$TLB_LARGE_HITS" ]; then
     # Larger TLB should have better hit rate
-    if (( $(echo "$TLB_LARGE_HITS >= $TLB_SMALL_HITS" | bc -l) )); then
+    if awk "BEGIN { exit !($TLB_LARGE_HITS >= $TLB_SMALL_HITS) }"; then
         pass "TLB size affects hit rate (Small: ${TLB_SMALL_HITS}%, Large: ${TLB_LARGE_HITS}%)"
     else
         fail "TLB hit rate unexpected (Small: ${TLB_SMALL_HITS}%, Large: ${TLB_LARGE_HITS}%)"
@@ -153,7 +179,7 @@ if "$VMM" -r 8 -p 4096 -t "$TRACE_DIR/thrashing.trace" -a FIFO -T 16 \
     PF_RATE=$(grep "Fault Rate:" "$OUTPUT_DIR/thrashing.log" | awk '{print $3}' | tr -d '%')
     if [ -n "$PF_RATE" ]; then
         # Thrashing should have high page fault rate (> 10%)
-        if (( $(echo "$PF_RATE > 10" | bc -l) )); then
+        if awk "BEGIN { exit !($PF_RATE > 10) }"; then
             pass "Thrashing scenario (PF rate: ${PF_RATE}%)"
         else
             fail "Thrashing scenario - page fault rate too low (${PF_RATE}%)"
@@ -191,6 +217,521 @@ else
     fail "Page size configuration test failed"
 fi
 
+# Test 11: Simulated time is deterministic
+info "Test 11: Deterministic simulated time"
+"$VMM" -r 1 -p 4096 -t "$TRACE_DIR/working_set.trace" -a LRU -T 16 \
+    > "$OUTPUT_DIR/simtime_a.log" 2>&1
+"$VMM" -r 1 -p 4096 -t "$TRACE_DIR/working_set.trace" -a LRU -T 16 \
+    > "$OUTPUT_DIR/simtime_b.log" 2>&1
+SIM_A=$(grep -A3 "Simulated Time:" "$OUTPUT_DIR/simtime_a.log")
+SIM_B=$(grep -A3 "Simulated Time:" "$OUTPUT_DIR/simtime_b.log")
+if [ -n "$SIM_A" ] && [ "$SIM_A" = "$SIM_B" ] && ! echo "$SIM_A" | grep -q " 0.000 ms"; then
+    pass "Simulated time reproducible across runs"
+else
+    fail "Simulated time differs between identical runs"
+fi
+
+# Test 12: Swap device profiles
+info "Test 12: Swap device models (HDD vs NVMe)"
+"$VMM" -r 1 -p 4096 -t "$TRACE_DIR/working_set.trace" -a CLOCK -T 16 --swap-device HDD \
+    > "$OUTPUT_DIR/swapdev_hdd.log" 2>&1
+"$VMM" -r 1 -p 4096 -t "$TRACE_DIR/working_set.trace" -a CLOCK -T 16 --swap-device NVME \
+    > "$OUTPUT_DIR/swapdev_nvme.log" 2>&1
+HDD_P99=$(grep "Latency p99:" "$OUTPUT_DIR/swapdev_hdd.log" | awk '{print $3}')
+NVME_P99=$(grep "Latency p99:" "$OUTPUT_DIR/swapdev_nvme.log" | awk '{print $3}')
+if [ -n "$HDD_P99" ] && [ -n "$NVME_P99" ] && awk "BEGIN { exit !($HDD_P99 > $NVME_P99) }"; then
+    pass "Swap device latency (HDD p99: ${HDD_P99} us, NVMe p99: ${NVME_P99} us)"
+else
+    fail "Swap device statistics missing or implausible"
+fi
+
+# Test 13: Real-data mode with file-backed swap
+info "Test 13: Real-data swap file I/O"
+rm -f "$OUTPUT_DIR/swap.img"
+if "$VMM" -r 1 -s 16 -p 4096 -t "$TRACE_DIR/working_set.trace" -a CLOCK -T 16 \
+    --swap-file "$OUTPUT_DIR/swap.img" -o "$OUTPUT_DIR/realdata.json" \
+    > "$OUTPUT_DIR/realdata.log" 2>&1; then
+    WRITE_CALLS=$(grep -A2 "Real Swap I/O" "$OUTPUT_DIR/realdata.log" | grep "Writes:" | awk '{print $2}')
+    VERIFY_ERRS=$(grep "Verify errors:" "$OUTPUT_DIR/realdata.log" | awk -F: '{print $2}' | tr -d ' ')
+    if [ -n "$WRITE_CALLS" ] && [ "$WRITE_CALLS" -gt 0 ] && [ "$VERIFY_ERRS" = "0" ]; then
+        pass "Real-data swap round-trips verified (${WRITE_CALLS} vectored writes)"
+    else
+        fail "Real-data swap I/O missing or corrupted (writes: ${WRITE_CALLS}, errors: ${VERIFY_ERRS})"
+    fi
+else
+    fail "Real-data swap execution failed"
+fi
+rm -f "$OUTPUT_DIR/swap.img"
+
+# Test 14: Clustered swap slots let batched write-back merge into larger requests
+info "Test 14: Swap clustering and batched write-back"
+for round in 1 2; do
+    for page in $(seq 0 1999); do
+        printf "0 W 0x%x\n" $((page * 4096))
+    done
+done > "$OUTPUT_DIR/seq_write.trace"
+"$VMM" -r 1 -t "$OUTPUT_DIR/seq_write.trace" --swap-device HDD --io-batch 1 \
+    > "$OUTPUT_DIR/wb_batch1.log" 2>&1
+"$VMM" -r 1 -t "$OUTPUT_DIR/seq_write.trace" --swap-device HDD --io-batch 32 \
+    > "$OUTPUT_DIR/wb_batch32.log" 2>&1
+IO_SIZE_1=$(grep "Avg I/O size:" "$OUTPUT_DIR/wb_batch1.log" | awk '{print $4}')
+IO_SIZE_32=$(grep "Avg I/O size:" "$OUTPUT_DIR/wb_batch32.log" | awk '{print $4}')
+SEEKS_32=$(grep "Seeks avoided:" "$OUTPUT_DIR/wb_batch32.log" | awk -F: '{print $2}' | tr -d ' ')
+if [ -n "$IO_SIZE_1" ] && [ -n "$IO_SIZE_32" ] &&
+    awk -v a="$IO_SIZE_32" -v b="$IO_SIZE_1" 'BEGIN { exit !(a > b) }' && [ "$SEEKS_32" -gt 0 ]; then
+    pass "Batched write-back merges runs (${IO_SIZE_1} KB -> ${IO_SIZE_32} KB, ${SEEKS_32} seeks avoided)"
+else
+    fail "Batched write-back did not grow I/O size (${IO_SIZE_1} KB vs ${IO_SIZE_32} KB)"
+fi
+
+# Test 15: Readahead turns sequential swap-ins into hits
+info "Test 15: Adaptive swap readahead"
+for op in W R; do
+    for page in $(seq 0 1999); do
+        printf "0 %s 0x%x\n" "$op" $((page * 4096))
+    done
+done > "$OUTPUT_DIR/seq_reread.trace"
+"$VMM" -r 1 -t "$OUTPUT_DIR/seq_reread.trace" --swap-readahead 1 > "$OUTPUT_DIR/ra_off.log" 2>&1
+"$VMM" -r 1 -t "$OUTPUT_DIR/seq_reread.trace" --swap-readahead 8 > "$OUTPUT_DIR/ra_on.log" 2>&1
+MAJOR_OFF=$(grep "Major:" "$OUTPUT_DIR/ra_off.log" | head -1 | awk '{print $2}')
+MAJOR_ON=$(grep "Major:" "$OUTPUT_DIR/ra_on.log" | head -1 | awk '{print $2}')
+RA_HITS=$(grep -A3 "Swap Readahead:" "$OUTPUT_DIR/ra_on.log" | grep "Hits:" | awk '{print $2}')
+if [ -n "$MAJOR_OFF" ] && [ -n "$MAJOR_ON" ] && [ -n "$RA_HITS" ] &&
+    [ "$MAJOR_ON" -lt "$MAJOR_OFF" ] && [ "$RA_HITS" -gt 0 ]; then
+    pass "Readahead cut major faults ($MAJOR_OFF -> $MAJOR_ON, $RA_HITS hits)"
+else
+    fail "Readahead had no effect (major faults: $MAJOR_OFF -> $MAJOR_ON)"
+fi
+
+# Test 16: kswapd keeps reclaim out of the fault path
+info "Test 16: Background reclaim (kswapd)"
+"$VMM" -r 1 -t "$TRACE_DIR/working_set.trace" --swap-device NVME > "$OUTPUT_DIR/kswapd_off.log" 2>&1
+"$VMM" -r 1 -t "$TRACE_DIR/working_set.trace" --swap-device NVME --kswapd \
+    > "$OUTPUT_DIR/kswapd_on.log" 2>&1
+DIRECT_ON=$(grep "Direct:" "$OUTPUT_DIR/kswapd_on.log" | awk '{print $2}')
+BACKGROUND_ON=$(grep "Background:" "$OUTPUT_DIR/kswapd_on.log" | awk '{print $2}')
+P99_OFF=$(grep "Fault p99:" "$OUTPUT_DIR/kswapd_off.log" | awk '{print $3}')
+P99_ON=$(grep "Fault p99:" "$OUTPUT_DIR/kswapd_on.log" | awk '{print $3}')
+if [ "$DIRECT_ON" = "0" ] && [ -n "$BACKGROUND_ON" ] && [ "$BACKGROUND_ON" -gt 0 ] &&
+    awk -v on="$P99_ON" -v off="$P99_OFF" 'BEGIN { exit !(on <= off) }'; then
+    pass "kswapd reclaimed $BACKGROUND_ON frames, fault p99 ${P99_OFF} -> ${P99_ON} us"
+else
+    fail "kswapd reclaim incorrect (direct: $DIRECT_ON, background: $BACKGROUND_ON)"
+fi
+
+# Test 17: Batched victim selection picks several frames per policy pass
+info "Test 17: Batched victim selection"
+BATCH_OK=1
+for algo in FIFO LRU APPROX_LRU CLOCK CLOCK_PRO ARC LIRS; do
+    "$VMM" -r 1 -t "$TRACE_DIR/working_set.trace" -a "$algo" --reclaim-batch 16 \
+        > "$OUTPUT_DIR/batch_$algo.log" 2>&1 || BATCH_OK=0
+    PER_PASS=$(grep "Selection:" "$OUTPUT_DIR/batch_$algo.log" | sed 's/.*(\([0-9.]*\) victims.*/\1/')
+    if [ -z "$PER_PASS" ] || ! awk -v p="$PER_PASS" 'BEGIN { exit !(p > 8) }'; then
+        BATCH_OK=0
+    fi
+done
+# Selection cost is counted in policy steps, not host time: a list tail is one
+LRU_STEPS=$(grep "Selection:" "$OUTPUT_DIR/batch_LRU.log" | awk '{print $2}')
+[ "$LRU_STEPS" = "1.00" ] || BATCH_OK=0
+if [ $BATCH_OK -eq 1 ]; then
+    pass "Every policy evicts in batches (--reclaim-batch 16, LRU $LRU_STEPS steps/victim)"
+else
+    fail "Batched victim selection returned too few victims per pass"
+fi
+
+# Test 18: Huge pages extend TLB reach; eager mapping trades memory for it
+info "Test 18: Huge pages and THP collapse/split"
+{
+    for page in $(seq 0 1535); do
+        printf "0 W 0x%x\n" $((page * 4096))
+    done
+    for i in $(seq 0 2999); do
+        printf "0 R 0x%x\n" $(((i * 37 % 1536) * 4096))
+    done
+} > "$OUTPUT_DIR/huge.trace"
+"$VMM" -t "$OUTPUT_DIR/huge.trace" --thp > "$OUTPUT_DIR/thp.log" 2>&1
+"$VMM" -r 4 -t "$OUTPUT_DIR/huge.trace" --huge-pages 2M > "$OUTPUT_DIR/huge_eager.log" 2>&1
+COLLAPSES=$(grep "Collapses:" "$OUTPUT_DIR/thp.log" | awk '{print $2}')
+TLB_GAIN=$(grep "TLB gain:" "$OUTPUT_DIR/thp.log" | awk '{print $3}')
+THP_BLOAT=$(grep "Bloat:" "$OUTPUT_DIR/thp.log" | awk '{print $2}')
+SPLITS=$(grep "Splits:" "$OUTPUT_DIR/huge_eager.log" | awk '{print $2}')
+EAGER_BLOAT=$(grep "Bloat:" "$OUTPUT_DIR/huge_eager.log" | awk '{print $2}')
+if [ -n "$COLLAPSES" ] && [ "$COLLAPSES" -ge 3 ] && [ -n "$SPLITS" ] && [ "$SPLITS" -gt 0 ] &&
+    awk -v g="$TLB_GAIN" -v t="$THP_BLOAT" -v e="$EAGER_BLOAT" \
+        'BEGIN { exit !(g > 0 && t == 0 && e > 0) }'; then
+    pass "THP collapsed $COLLAPSES regions (TLB ${TLB_GAIN} points), eager mode split $SPLITS"
+else
+    fail "Huge pages incorrect (collapses: $COLLAPSES, gain: $TLB_GAIN, splits: $SPLITS)"
+fi
+
+# Test 19: Radix page tables translate 48-bit addresses and grow with the footprint
+info "Test 19: Multi-level radix page tables"
+for i in $(seq 0 999); do
+    printf "1 W 0x%x\n" $((0x7fff00000000 + (i % 300) * 4096))
+    printf "2 R 0x%x\n" $((0x100000000000 + (i * 7919 % 5000) * 4096))
+done > "$OUTPUT_DIR/wide.trace"
+"$VMM" -t "$OUTPUT_DIR/wide.trace" --pt-type RADIX_4 > "$OUTPUT_DIR/radix_wide.log" 2>&1
+"$VMM" -t "$TRACE_DIR/working_set.trace" --pt-type RADIX_4 > "$OUTPUT_DIR/radix_ws.log" 2>&1
+"$VMM" -t "$TRACE_DIR/working_set.trace" --pt-type SINGLE > "$OUTPUT_DIR/single_ws.log" 2>&1
+WIDE_FAILED=$(grep -c "Failed to access" "$OUTPUT_DIR/radix_wide.log" || true)
+RADIX_MEM=$(grep -A1 "Page Tables:" "$OUTPUT_DIR/radix_ws.log" | grep "Memory:" | awk '{print $2}')
+SINGLE_MEM=$(grep -A1 "Page Tables:" "$OUTPUT_DIR/single_ws.log" | grep "Memory:" | awk '{print $2}')
+if [ "$WIDE_FAILED" = "0" ] && grep -q "Nodes: *L4" "$OUTPUT_DIR/radix_wide.log" &&
+    [ -n "$RADIX_MEM" ] && [ -n "$SINGLE_MEM" ] &&
+    awk -v r="$RADIX_MEM" -v s="$SINGLE_MEM" 'BEGIN { exit !(r < s) }'; then
+    pass "RADIX_4 maps 48-bit addresses, page tables ${SINGLE_MEM} KB -> ${RADIX_MEM} KB"
+else
+    fail "Radix page tables incorrect (failed: $WIDE_FAILED, memory: $RADIX_MEM vs $SINGLE_MEM KB)"
+fi
+
+# Test 20: Inverted page table is sized by RAM, not by address spaces or process count
+info "Test 20: Hashed inverted page table"
+"$VMM" -t "$OUTPUT_DIR/wide.trace" -r 1 --pt-type INVERTED > "$OUTPUT_DIR/inv_wide.log" 2>&1
+"$VMM" -t "$TRACE_DIR/working_set.trace" -r 1 --pt-type INVERTED > "$OUTPUT_DIR/inv_ws.log" 2>&1
+INV_FAILED=$(grep -c "Failed to access" "$OUTPUT_DIR/inv_wide.log" || true)
+INV_WIDE=$(grep -A1 "Page Tables:" "$OUTPUT_DIR/inv_wide.log" | grep "Memory:" | awk '{print $2}')
+INV_WS=$(grep -A1 "Page Tables:" "$OUTPUT_DIR/inv_ws.log" | grep "Memory:" | awk '{print $2}')
+if [ "$INV_FAILED" = "0" ] && [ -n "$INV_WIDE" ] &&
+    awk -v a="$INV_WIDE" -v b="$INV_WS" 'BEGIN { d = a - b; exit !(d < 1 && d > -1) }' &&
+    grep -q "Probes:" "$OUTPUT_DIR/inv_ws.log" && grep -q "Collisions:" "$OUTPUT_DIR/inv_ws.log"; then
+    pass "INVERTED page table: ${INV_WIDE} KB for 48-bit spaces, ${INV_WS} KB for 4 processes"
+else
+    fail "Inverted page table incorrect (failed: $INV_FAILED, memory: $INV_WIDE vs $INV_WS KB)"
+fi
+
+# Test 21: Reserved flat tables commit host memory only for touched entries
+info "Test 21: Reserved single-level page tables"
+"$VMM" -t "$TRACE_DIR/working_set.trace" -r 1 -v 1048576 --pt-reserve \
+    > "$OUTPUT_DIR/reserve_ws.log" 2>&1
+"$VMM" -t "$TRACE_DIR/working_set.trace" -r 1 --pt-type SINGLE > "$OUTPUT_DIR/flat_ws.log" 2>&1
+"$VMM" -t "$TRACE_DIR/working_set.trace" -r 1 --pt-type SINGLE --pt-reserve \
+    > "$OUTPUT_DIR/flat_reserve_ws.log" 2>&1
+RES_MEM=$(grep -A1 "Page Tables:" "$OUTPUT_DIR/reserve_ws.log" | grep "Memory:" | awk '{print $2}')
+RES_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/flat_reserve_ws.log" | grep "Total:" | awk '{print $2}')
+FLAT_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/flat_ws.log" | grep "Total:" | awk '{print $2}')
+if [ -n "$RES_MEM" ] && [ -n "$FLAT_FAULTS" ] && [ "$RES_FAULTS" = "$FLAT_FAULTS" ] &&
+    awk -v r="$RES_MEM" 'BEGIN { exit !(r < 65536) }'; then
+    pass "Reserved flat tables for 1 TB spaces commit ${RES_MEM} KB"
+else
+    fail "Reserved page tables incorrect (memory: $RES_MEM KB, faults: $RES_FAULTS vs $FLAT_FAULTS)"
+fi
+
+# Test 22: The page-walk cache shortens walks of deep tables
+info "Test 22: Page-walk cache"
+"$VMM" -t "$TRACE_DIR/locality.trace" -r 1 --pt-type RADIX_4 > "$OUTPUT_DIR/pwc_on.log" 2>&1
+"$VMM" -t "$TRACE_DIR/locality.trace" -r 1 --pt-type RADIX_4 --walk-cache 0 \
+    > "$OUTPUT_DIR/pwc_off.log" 2>&1
+REFS_ON=$(grep "Refs/walk:" "$OUTPUT_DIR/pwc_on.log" | awk '{print $2}')
+REFS_OFF=$(grep "Refs/walk:" "$OUTPUT_DIR/pwc_off.log" | awk '{print $2}')
+AMT_ON=$(grep "Sim AMT:" "$OUTPUT_DIR/pwc_on.log" | awk '{print $3}')
+AMT_OFF=$(grep "Sim AMT:" "$OUTPUT_DIR/pwc_off.log" | awk '{print $3}')
+if [ "$REFS_OFF" = "4.00" ] && [ -n "$REFS_ON" ] &&
+    awk -v a="$REFS_ON" -v b="$AMT_ON" -v c="$AMT_OFF" 'BEGIN { exit !(a < 4 && b < c) }'; then
+    pass "Walk cache cut 4-level walks to $REFS_ON references"
+else
+    fail "Walk cache incorrect (refs: $REFS_ON vs $REFS_OFF, AMT: $AMT_ON vs $AMT_OFF)"
+fi
+
+# Test 23: An STLB catches what a small set-associative L1 dTLB misses
+info "Test 23: Two-level TLB hierarchy"
+"$VMM" -t "$OUTPUT_DIR/tlb_loop.trace" > "$OUTPUT_DIR/tlb_l1.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/tlb_loop.trace" --stlb 1536 --stlb-ways 8 --tlb-policy PLRU \
+    > "$OUTPUT_DIR/tlb_stlb.log" 2>&1
+L1_ONLY=$(grep "Hit Rate:" "$OUTPUT_DIR/tlb_l1.log" | head -1 | awk '{print $3}' | tr -d '%')
+STLB_RATE=$(grep "L2 STLB:" "$OUTPUT_DIR/tlb_stlb.log" | awk '{print $3}' | tr -d '%')
+if [ -n "$L1_ONLY" ] && [ -n "$STLB_RATE" ] &&
+    awk -v a="$L1_ONLY" -v b="$STLB_RATE" 'BEGIN { exit !(a < 1 && b > 50) }'; then
+    pass "STLB hits ${STLB_RATE}% of L1 dTLB misses (L1 alone: ${L1_ONLY}%)"
+else
+    fail "TLB hierarchy incorrect (L1 only: $L1_ONLY%, STLB: $STLB_RATE%)"
+fi
+
+# Test 24: Repeated accesses to one page are served by the last-translation fast path
+info "Test 24: Last-translation fast path"
+for page in $(seq 0 127); do
+    printf "1 R 0x%x\n2 R 0x%x\n1 W 0x%x\n1 R 0x%x\n1 R 0x%x\n" $((page * 4096)) \
+        $((page * 4096)) $((page * 4096 + 8)) $((page * 4096 + 16)) $((page * 4096 + 24))
+done > "$OUTPUT_DIR/repeat.trace"
+"$VMM" -t "$OUTPUT_DIR/repeat.trace" > "$OUTPUT_DIR/fast_path.log" 2>&1
+FAST_HITS=$(grep "Fast path:" "$OUTPUT_DIR/fast_path.log" | awk '{print $6}' | tr -d '()')
+TLB_HITS=$(grep "Hits:" "$OUTPUT_DIR/fast_path.log" | head -1 | awk '{print $2}')
+if [ "$TLB_HITS" = "384" ] && [ "$FAST_HITS" = "384" ]; then
+    pass "Fast path served all $FAST_HITS repeat TLB hits"
+else
+    fail "Fast path incorrect (TLB hits: $TLB_HITS, fast path: $FAST_HITS)"
+fi
+
+# Test 25: Exact LRU faults on every access of a loop one page larger than memory
+info "Test 25: Exact LRU recency list"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a LRU > "$OUTPUT_DIR/lru_loop.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 2 -a LRU > "$OUTPUT_DIR/lru_fit.log" 2>&1
+LOOP_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/lru_loop.log" | tail -1 | awk '{print $2}')
+FIT_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/lru_fit.log" | tail -1 | awk '{print $2}')
+if [ "$LOOP_FAULTS" = "1028" ] && [ "$FIT_FAULTS" = "257" ]; then
+    pass "LRU faults $LOOP_FAULTS times on a 257-page loop in 256 frames"
+else
+    fail "LRU ordering incorrect (faults: $LOOP_FAULTS in 256 frames, $FIT_FAULTS in 512)"
+fi
+
+# Test 26: OPT faults only once per pass on the same loop, with 8 KB pages
+info "Test 26: OPT next-use index"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -p 8192 -a OPT > "$OUTPUT_DIR/opt_loop.log" 2>&1
+OPT_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/opt_loop.log" | tail -1 | awk '{print $2}')
+if [ "$OPT_FAULTS" = "132" ]; then
+    pass "OPT faults $OPT_FAULTS times (129 cold, one per later pass)"
+else
+    fail "OPT victim choice incorrect (faults: $OPT_FAULTS, expected 132)"
+fi
+
+# Test 27: Out-of-core OPT, in small spill blocks, matches OPT in memory
+info "Test 27: Out-of-core OPT"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -p 8192 -a OPT --opt-spill "$OUTPUT_DIR" \
+    --opt-block 100 > "$OUTPUT_DIR/opt_spill.log" 2>&1
+SPILL_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/opt_spill.log" | tail -1 | awk '{print $2}')
+if [ "$SPILL_FAULTS" = "$OPT_FAULTS" ] && grep -q "OPT spill:" "$OUTPUT_DIR/opt_spill.log"; then
+    pass "Spilled OPT matches in-memory OPT ($SPILL_FAULTS faults)"
+else
+    fail "Out-of-core OPT incorrect (faults: $SPILL_FAULTS vs $OPT_FAULTS in memory)"
+fi
+
+# Test 28: Word-at-a-time Clock keeps the frame-by-frame sweep's victims
+# (257-page loop in 256 frames: 260 faults singly, 288 in batches of 8)
+info "Test 28: Clock bitmap sweep"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a CLOCK > "$OUTPUT_DIR/clock_loop.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a CLOCK --reclaim-batch 8 \
+    > "$OUTPUT_DIR/clock_batch.log" 2>&1
+CLOCK_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/clock_loop.log" | tail -1 | awk '{print $2}')
+BATCH_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/clock_batch.log" | tail -1 | awk '{print $2}')
+if [ "$CLOCK_FAULTS" = "260" ] && [ "$BATCH_FAULTS" = "288" ]; then
+    pass "Clock sweep faults $CLOCK_FAULTS times ($BATCH_FAULTS with batch reclaim)"
+else
+    fail "Clock sweep incorrect (faults: $CLOCK_FAULTS, batched: $BATCH_FAULTS)"
+fi
+
+# Test 29: Approx-LRU ages the whole table once per --aging-interval accesses
+# (1028 accesses, aged at 0, 100, ..., 1000: 11 sweeps)
+info "Test 29: Vectorized aging"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a APPROX_LRU --aging-interval 100 \
+    > "$OUTPUT_DIR/aging.log" 2>&1
+AGING_SWEEPS=$(grep "Aging:" "$OUTPUT_DIR/aging.log" | sed 's/.*(host, \([0-9]*\) sweeps.*/\1/')
+AGING_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/aging.log" | tail -1 | awk '{print $2}')
+if [ "$AGING_SWEEPS" = "11" ] && [ "$AGING_FAULTS" = "261" ]; then
+    pass "Aging swept $AGING_SWEEPS times ($AGING_FAULTS faults)"
+else
+    fail "Aging interval not honoured (sweeps: $AGING_SWEEPS, faults: $AGING_FAULTS)"
+fi
+
+# Test 30: Approx-LRU victims from the age heap match a scan for the youngest
+# age (257-page loop in 256 frames: 263 faults singly, 284 in batches of 8)
+info "Test 30: Approx-LRU victim heap"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a APPROX_LRU > "$OUTPUT_DIR/approx_loop.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a APPROX_LRU --reclaim-batch 8 \
+    > "$OUTPUT_DIR/approx_batch.log" 2>&1
+APPROX_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/approx_loop.log" | tail -1 | awk '{print $2}')
+BATCH_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/approx_batch.log" | tail -1 | awk '{print $2}')
+if [ "$APPROX_FAULTS" = "263" ] && [ "$BATCH_FAULTS" = "284" ]; then
+    pass "Approx-LRU faults $APPROX_FAULTS times ($BATCH_FAULTS with batch reclaim)"
+else
+    fail "Approx-LRU victim choice incorrect (faults: $APPROX_FAULTS, batched: $BATCH_FAULTS)"
+fi
+
+# Test 31: ARC keeps a hot set through scans that flush it from LRU
+# (150 hot pages read twice, then 300 new pages, ten times in 256 frames)
+info "Test 31: ARC replacement"
+"$VMM" -t "$OUTPUT_DIR/scan_hot.trace" -r 1 -a LRU > "$OUTPUT_DIR/scan_lru.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/scan_hot.trace" -r 1 -a ARC > "$OUTPUT_DIR/scan_arc.log" 2>&1
+LRU_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/scan_lru.log" | tail -1 | awk '{print $2}')
+ARC_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/scan_arc.log" | tail -1 | awk '{print $2}')
+if [ "$LRU_FAULTS" = "4500" ] && [ "$ARC_FAULTS" = "3150" ]; then
+    pass "ARC faults $ARC_FAULTS times (LRU: $LRU_FAULTS), hot set kept"
+else
+    fail "ARC scan resistance incorrect (faults: $ARC_FAULTS, LRU: $LRU_FAULTS)"
+fi
+
+# Test 32: LIRS keeps most of a loop larger than memory resident
+# (257-page loop in 256 frames: LRU faults on all 1028 accesses; the
+# thrashing trace cycles 2048 pages through 1024 frames)
+info "Test 32: LIRS on loops"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a LIRS > "$OUTPUT_DIR/lirs_loop.log" 2>&1
+"$VMM" -t "$TRACE_DIR/thrashing.trace" -r 4 -a LIRS > "$OUTPUT_DIR/lirs_thrash.log" 2>&1
+LIRS_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/lirs_loop.log" | tail -1 | awk '{print $2}')
+THRASH_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/lirs_thrash.log" | tail -1 | awk '{print $2}')
+if [ "$LIRS_FAULTS" = "266" ] && [ "$THRASH_FAULTS" = "8252" ]; then
+    pass "LIRS faults $LIRS_FAULTS times on the loop, $THRASH_FAULTS of 15000 thrashing"
+else
+    fail "LIRS loop resistance incorrect (loop: $LIRS_FAULTS, thrashing: $THRASH_FAULTS)"
+fi
+
+# Test 33: CLOCK-Pro matches LIRS-like loop and scan resistance with reference
+# bits only, and reports how far its hands move per fault
+info "Test 33: CLOCK-Pro"
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a CLOCK_PRO > "$OUTPUT_DIR/cp_loop.log" 2>&1
+"$VMM" -t "$OUTPUT_DIR/scan_hot.trace" -r 1 -a CLOCK_PRO > "$OUTPUT_DIR/cp_scan.log" 2>&1
+CP_LOOP=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/cp_loop.log" | tail -1 | awk '{print $2}')
+CP_SCAN=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/cp_scan.log" | tail -1 | awk '{print $2}')
+if [ "$CP_LOOP" = "264" ] && [ "$CP_SCAN" = "3150" ] && grep -q "Hand moves:" "$OUTPUT_DIR/cp_loop.log"; then
+    pass "CLOCK-Pro faults $CP_LOOP times on the loop, $CP_SCAN on the scan"
+else
+    fail "CLOCK-Pro results incorrect (loop: $CP_LOOP, scan: $CP_SCAN)"
+fi
+
+# Test 34: A fallback slot that lands in an empty cluster takes it off the free
+# stack, so freeing the slot returns the cluster once (8 clusters in 1 MB swap;
+# pages 8..38 fall back into cluster 0, then page 1 finds its home slot taken
+# while cluster 1 is free)
+info "Test 34: Swap cluster fallback"
+{
+    for key in $(seq 0 38); do
+        printf "0 W 0x%x\n" $((key * 32 * 4096))
+    done
+    for page in $(seq 0 255); do
+        printf "0 R 0x%x\n" $(((100000 + page) * 4096))
+    done
+    printf "0 R 0x%x\n" $((32 * 4096))
+    printf "0 W 0x%x\n" 4096
+    for page in $(seq 0 255); do
+        printf "0 R 0x%x\n" $(((100000 + page) * 4096))
+    done
+    printf "0 R 0x%x\n" 4096
+} > "$OUTPUT_DIR/cluster_fallback.trace"
+"$VMM" -t "$OUTPUT_DIR/cluster_fallback.trace" -r 1 -s 1 -a LRU --swap-readahead 1 \
+    > "$OUTPUT_DIR/cluster_fallback.log" 2>&1
+CLUSTERS=$(grep "Clusters:" "$OUTPUT_DIR/cluster_fallback.log" | awk '{print $2, $5, $6}')
+if [ "$CLUSTERS" = "1 8 (32" ]; then
+    pass "Freed cluster listed once (1 free of 8, 32 fallback slots)"
+else
+    fail "Swap cluster accounting incorrect (free, total, fallbacks: $CLUSTERS)"
+fi
+
+# Test 35: ARC trims its directory before a miss's replacement, so the faulting
+# page enters T1 with |T1| + |B1| <= c (a one-shot loop leaves no B1 ghosts)
+info "Test 35: ARC L1 bound"
+ARC_OK=1
+for trace in "$OUTPUT_DIR/lru_loop.trace" "$TRACE_DIR/working_set.trace" "$TRACE_DIR/locality.trace"; do
+    "$VMM" -t "$trace" -r 1 -a ARC --reclaim-batch 4 > "$OUTPUT_DIR/arc_l1.log" 2>&1 || ARC_OK=0
+    L1=$(grep "ARC L1 max:" "$OUTPUT_DIR/arc_l1.log" | awk '{print $4, $12}' | tr -d ')')
+    if [ -z "$L1" ] || ! awk -v l="${L1% *}" -v c="${L1#* }" 'BEGIN { exit !(l <= c) }'; then
+        ARC_OK=0
+    fi
+done
+"$VMM" -t "$OUTPUT_DIR/lru_loop.trace" -r 1 -a ARC > "$OUTPUT_DIR/arc_loop.log" 2>&1
+ARC_LOOP=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/arc_loop.log" | tail -1 | awk '{print $2}')
+if [ $ARC_OK -eq 1 ] && [ "$ARC_LOOP" = "1028" ]; then
+    pass "|T1| + |B1| stays within c after every miss"
+else
+    fail "ARC L1 exceeded c (last: $L1, loop faults: $ARC_LOOP)"
+fi
+
+# Test 36: A faulting page gets a fresh frame, not its victim's replacement state:
+# LRU faults on every access of a 2048-page cycle through 1024 frames (a page that
+# kept its victim's old timestamp would be evicted next, and LRU faulted 8199 times)
+info "Test 36: Fresh replacement state for reclaimed frames"
+"$VMM" -t "$TRACE_DIR/thrashing.trace" -r 4 -a LRU -T 16 --swap-readahead 1 \
+    > "$OUTPUT_DIR/fresh_frame.log" 2>&1
+FRESH_FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/fresh_frame.log" | tail -1 | awk '{print $2}')
+if [ "$FRESH_FAULTS" = "15000" ]; then
+    pass "LRU evicts the oldest page, not the one just faulted in ($FRESH_FAULTS faults)"
+else
+    fail "Reclaimed frame kept stale replacement state ($FRESH_FAULTS faults, expected 15000)"
+fi
+
+# Test 37: A readahead window clamped to a quarter of memory stays an aligned power
+# of two (192 frames of 16 KB: the 48-page quarter rounds down to 32; unaligned
+# 48-page windows took 93 major faults and wasted 16 pages)
+info "Test 37: Readahead window clamp"
+for op in W R; do
+    for page in $(seq 0 7999); do
+        printf "0 %s 0x%x\n" "$op" $((page * 4096))
+    done
+done > "$OUTPUT_DIR/seq_reread_long.trace"
+"$VMM" -r 3 -p 16384 -t "$OUTPUT_DIR/seq_reread_long.trace" --swap-readahead 64 \
+    > "$OUTPUT_DIR/ra_clamp.log" 2>&1
+CLAMP_MAJOR=$(grep "Major:" "$OUTPUT_DIR/ra_clamp.log" | head -1 | awk '{print $2}')
+CLAMP_WASTED=$(grep -A5 "Swap Readahead:" "$OUTPUT_DIR/ra_clamp.log" | grep "Wasted:" | awk '{print $2}')
+if [ "$CLAMP_MAJOR" = "68" ] && [ "$CLAMP_WASTED" = "0" ]; then
+    pass "Clamped windows stay aligned ($CLAMP_MAJOR major faults, none wasted)"
+else
+    fail "Clamped readahead window misaligned (major: $CLAMP_MAJOR, wasted: $CLAMP_WASTED)"
+fi
+
+# Test 38: Forced tag-match kernels give the same TLB statistics
+info "Test 38: TLB kernels agree"
+TLB_KERNELS=""
+for simd in scalar sse2 avx2; do
+    "$VMM" -t "$OUTPUT_DIR/tlb_loop.trace" --tlb-ways 0 --stlb 1536 --stlb-ways 12 --simd $simd -V \
+        > "$OUTPUT_DIR/tlb_simd_$simd.log" 2>&1
+    TLB_KERNELS="$TLB_KERNELS $(grep -o "[A-Za-z0-9]* tag match" "$OUTPUT_DIR/tlb_simd_$simd.log" |
+        head -1 | awk '{print $1}')"
+    sed -n '/^TLB Performance:/,/^$/p' "$OUTPUT_DIR/tlb_simd_$simd.log" \
+        > "$OUTPUT_DIR/tlb_simd_$simd.stats"
+done
+if [ -s "$OUTPUT_DIR/tlb_simd_scalar.stats" ] &&
+    cmp -s "$OUTPUT_DIR/tlb_simd_scalar.stats" "$OUTPUT_DIR/tlb_simd_sse2.stats" &&
+    cmp -s "$OUTPUT_DIR/tlb_simd_scalar.stats" "$OUTPUT_DIR/tlb_simd_avx2.stats"; then
+    pass "TLB statistics identical across kernels:$TLB_KERNELS"
+else
+    fail "TLB statistics differ between kernels:$TLB_KERNELS"
+fi
+
+# Test 39: Forced aging kernels leave the same ages and take the same faults
+info "Test 39: Aging kernels agree"
+AGING_RESULTS=""
+for simd in scalar sse2 avx2; do
+    "$VMM" -t "$TRACE_DIR/working_set.trace" -r 1 -a APPROX_LRU --aging-interval 100 \
+        --simd $simd -V > "$OUTPUT_DIR/aging_simd_$simd.log" 2>&1
+    DIGEST=$(grep -o "digest 0x[0-9a-f]*" "$OUTPUT_DIR/aging_simd_$simd.log" | awk '{print $2}')
+    FAULTS=$(grep -A1 "Page Faults:" "$OUTPUT_DIR/aging_simd_$simd.log" | tail -1 | awk '{print $2}')
+    KERNEL=$(grep "Aging:" "$OUTPUT_DIR/aging_simd_$simd.log" | sed 's/.*sweeps, \(.*\))/\1/')
+    AGING_RESULTS="$AGING_RESULTS $KERNEL=$DIGEST/$FAULTS"
+done
+if [ -n "$DIGEST" ] && [ -n "$FAULTS" ] &&
+    [ "$(echo "$AGING_RESULTS" | tr ' ' '\n' | grep . | cut -d= -f2 | sort -u | wc -l)" = "1" ]; then
+    pass "Ages and faults identical across kernels:$AGING_RESULTS"
+else
+    fail "Aging kernels disagree:$AGING_RESULTS"
+fi
+
+# Test 40: Swap slots wider than 32 bits survive the packed entry, flags intact
+info "Test 40: Packed PTE swap slots"
+cat > "$OUTPUT_DIR/pte_slot.c" << 'CEOF'
+#include "pagetable.h"
+#include <stdio.h>
+
+int main(void)
+{
+    const uint64_t slots[] = {0, 1, UINT32_MAX, 1ULL << 32, 0x123456789aULL,
+                              (1ULL << (64 - PTE_FLAG_BITS)) - 1};
+    const size_t n = sizeof(slots) / sizeof(slots[0]);
+    for (size_t i = 0; i < n; i++) {
+        PageTableEntry pte = {0};
+        pte_set(&pte, 42, PTE_DIRTY | PTE_USER);
+        pte_set_swap_slot(&pte, slots[i]);
+        if (pte_swap_slot(&pte) != slots[i] ||
+            pte_flags(&pte) != (PTE_DIRTY | PTE_USER | PTE_SWAPPED)) {
+            printf("slot 0x%llx read back as 0x%llx, flags 0x%x\n",
+                   (unsigned long long)slots[i], (unsigned long long)pte_swap_slot(&pte),
+                   pte_flags(&pte));
+            return 1;
+        }
+        pte_clear_swap_slot(&pte);
+        if (pte.raw != (PTE_DIRTY | PTE_USER)) {
+            printf("clearing slot 0x%llx left 0x%llx\n", (unsigned long long)slots[i],
+                   (unsigned long long)pte.raw);
+            return 1;
+        }
+    }
+    printf("%zu slots\n", n);
+    return 0;
+}
+CEOF
+if ${CC:-cc} -std=c11 -Wall -Werror -I"$PROJECT_ROOT/src" "$OUTPUT_DIR/pte_slot.c" \
+    -o "$OUTPUT_DIR/pte_slot" > "$OUTPUT_DIR/pte_slot.log" 2>&1 &&
+    "$OUTPUT_DIR/pte_slot" >> "$OUTPUT_DIR/pte_slot.log" 2>&1; then
+    pass "Swap slots up to 52 bits round-trip ($(tail -1 "$OUTPUT_DIR/pte_slot.log"))"
+else
+    fail "Packed swap slot lost bits: $(tail -1 "$OUTPUT_DIR/pte_slot.log")"
+fi
+
 # Summary
 echo ""
 echo "========================================"